@@ -25,6 +25,20 @@
    The cut callback benders_callback adds to the master ILP violated Benders' cuts 
    that are found by solving the worker LP.
 
+   For this model, Benders' cuts can also be separated without the worker LP:
+   for a fixed x, the flow of commodity k can be routed iff the maximum flow
+   from node 0 to node k, with arc capacities x(i,j), is at least 1.
+   The example allows the user to choose between the two separators:
+   the worker LP, or a push-relabel maximum flow computation on the
+   n-node graph of the arcs with x(i,j) > 0, whose minimum cuts give
+   the violated Benders' cuts.
+
+   Successive x solutions are often alike, so the worker LP keeps a cache
+   of its final bases, keyed by a hash of the arcs selected by x 
+   (x(i,j) >= 0.5), and starts from the cached basis of the same key, 
+   if any. The number of simplex iterations with and without a cached 
+   basis is reported at the end.
+
    The example allows the user to decide if Benders' cuts have to be separated:
 
    a) Only to separate integer infeasible solutions. 
@@ -39,13 +53,18 @@
 
 
 /* To run this example, command line arguments are required:
-       bendersatsp {0|1} [filename]
+       bendersatsp {0|1} [lp|flow] [filename]
    where 
        0         Indicates that Benders' cuts are only used as lazy constraints, 
                  to separate integer infeasible solutions.
        1         Indicates that Benders' cuts are also used as user cuts, 
                  to separate fractional infeasible solutions.
 
+       lp        Indicates that Benders' cuts are separated by solving
+                 the worker LP (the default).
+       flow      Indicates that Benders' cuts are separated by computing
+                 maximum flows (minimum cuts) in the graph of x.
+
        filename  Is the name of the file containing the ATSP instance (arc costs).
                  If filename is not specified, the instance 
                  ../../../examples/data/atsp.dat is read */
@@ -104,6 +123,10 @@
 #include <string.h>
 #include <math.h>
 
+/* Number of worker LP bases cached by benders_callback */
+
+#define NUM_BASES 32
+
 /* Declaration of the data structure for the function benders_callback */
 
 typedef struct {
@@ -115,6 +138,10 @@ typedef struct {
          (i.e., wherefrom == CPX_CALLBACK_MIP_CUT_LAST || 
           wherefrom == CPX_CALLBACK_MIP_CUT_FEAS ) */
    int separate_fractional_solutions; 
+   /* Parameter to decide how Benders' cuts are going to be separated:
+      0: by solving the worker LP
+      1: by maximum flow computations, without the worker LP */
+   int separate_by_flow;
    /* Environment for the worker LP used to generate Benders' cuts */
    CPXENVptr env; 
    /* Worker LP used to generate Benders' cuts */
@@ -135,6 +162,29 @@ typedef struct {
    /* Data structure to add a Benders' cut to the master ILP */
    double *cutval;
    int *cutind;
+   /* Data structures for the maximum flow computations:
+      residual capacities and excesses of the nodes, distance labels,
+      next arc to scan from each node, queue of the active nodes,
+      and side of each node in the minimum cut (1 for the source side) */
+   double *resid;
+   double *excess;
+   int *label;
+   int *current;
+   int *queue;
+   int *side;
+   /* Cache of the final bases of the worker LP: the basis in slot b has
+      the column statuses base_cstat[b*(num_v_cols+num_u_cols)...] and 
+      the row statuses base_rstat[b*num_rows...], and was found for the
+      x solutions with key base_key[b]. num_bases slots are filled, and
+      next_base is the slot to overwrite next. */
+   int num_rows;
+   int num_bases, next_base;
+   unsigned int *base_key;
+   int *base_cstat;
+   int *base_rstat;
+   /* Simplex iterations of the worker LP, with and without a cached basis */
+   int num_solves, num_hits;
+   long it_hits, it_misses;
    
 } USER_CBHANDLE;
 
@@ -150,8 +200,16 @@ static int
    create_master_ILP     (CPXENVptr env, CPXLPptr lp, double **arc_cost, 
                           int num_nodes),
    init_user_cbhandle    (USER_CBHANDLE *user_cbhandle, int num_nodes, 
-                          int separate_fractional_solutions),
-   free_user_cbhandle    (USER_CBHANDLE *user_cbhandle);
+                          int separate_fractional_solutions,
+                          int separate_by_flow),
+   free_user_cbhandle    (USER_CBHANDLE *user_cbhandle),
+   separate_lp           (USER_CBHANDLE *user_cbhandle, int *found_p,
+                          int *nzcnt_p, double *rhs_p),
+   separate_flow         (USER_CBHANDLE *user_cbhandle, int *found_p,
+                          int *nzcnt_p, double *rhs_p);
+
+static double
+   max_flow              (USER_CBHANDLE *user_cbhandle, int sink);
 
 static int
    read_array (FILE *in, int *num_p, double **data_p),
@@ -201,6 +259,13 @@ main (int  argc, char *argv[])
    
    int separate_fractional_solutions; 
 
+   /* Decide how Benders' cuts are going to be separated:
+      0: by solving the worker LP
+      1: by maximum flow computations, without the worker LP */
+
+   int separate_by_flow = 0;
+   int next_arg = 2;
+
    /* Cut callback data structure */
    
    USER_CBHANDLE user_cbhandle;
@@ -211,11 +276,24 @@ main (int  argc, char *argv[])
    user_cbhandle.ray     = NULL;
    user_cbhandle.cutval  = NULL;
    user_cbhandle.cutind  = NULL;
+   user_cbhandle.resid   = NULL;
+   user_cbhandle.excess  = NULL;
+   user_cbhandle.label   = NULL;
+   user_cbhandle.current = NULL;
+   user_cbhandle.queue   = NULL;
+   user_cbhandle.side    = NULL;
+   user_cbhandle.base_key   = NULL;
+   user_cbhandle.base_cstat = NULL;
+   user_cbhandle.base_rstat = NULL;
+   user_cbhandle.num_solves = 0;
+   user_cbhandle.num_hits   = 0;
+   user_cbhandle.it_hits    = 0;
+   user_cbhandle.it_misses  = 0;
 
 
    /* Check the command line arguments */
 
-   if ( argc != 2 && argc != 3) {
+   if ( argc < 2 || argc > 4 ) {
       usage (argv[0]);
       goto TERMINATE;
    }
@@ -237,7 +315,25 @@ main (int  argc, char *argv[])
    }
    fflush (stdout);
 
-   if ( argc == 3 )  filename = argv[2];
+   if ( argc > next_arg && (strcmp (argv[next_arg], "lp")   == 0 ||
+                            strcmp (argv[next_arg], "flow") == 0) ) {
+      separate_by_flow = ( argv[next_arg][0] == 'f' ? 1 : 0 );
+      ++next_arg;
+   }
+   if ( argc > next_arg )  filename = argv[next_arg++];
+   if ( argc > next_arg ) {
+      usage (argv[0]);
+      goto TERMINATE;
+   }
+
+   printf ("Benders' cuts separated by: ");
+   if ( separate_by_flow ) {
+      printf ("Maximum flow computations.\n");
+   }
+   else {
+      printf ("The worker LP.\n");
+   }
+   fflush (stdout);
 
    /* Read the ATSP instance */
 
@@ -291,7 +387,8 @@ main (int  argc, char *argv[])
    /* Init the cut callback data structure */
 
    status = init_user_cbhandle (&user_cbhandle, num_nodes, 
-                                separate_fractional_solutions);
+                                separate_fractional_solutions,
+                                separate_by_flow);
    if ( status ) {
       fprintf (stderr,
                "Failed to init the cut callback data structure, status = %d.\n", 
@@ -330,6 +427,24 @@ main (int  argc, char *argv[])
       printf ("Objective value: %17.10e\n", objval);
    }
 
+   /* Write out the simplex iterations of the worker LP, and an estimate
+      of the iterations saved by the cached bases */
+
+   if ( !separate_by_flow ) {
+      int num_misses = user_cbhandle.num_solves - user_cbhandle.num_hits;
+      printf ("Worker LP: %d solves, %d from a cached basis\n",
+              user_cbhandle.num_solves, user_cbhandle.num_hits);
+      if ( user_cbhandle.num_hits > 0 && num_misses > 0 ) {
+         double per_hit  = (double) user_cbhandle.it_hits / 
+                           user_cbhandle.num_hits;
+         double per_miss = (double) user_cbhandle.it_misses / num_misses;
+         printf ("           %.1f simplex iterations per solve from a "
+                 "cached basis, %.1f otherwise\n", per_hit, per_miss);
+         printf ("           about %.0f simplex iterations saved\n",
+                 user_cbhandle.num_hits * (per_miss - per_hit));
+      }
+   }
+
    if ( solstat == CPXMIP_OPTIMAL ) {
     
       /* Write out the optimal tour */
@@ -423,7 +538,9 @@ TERMINATE:
 /* This routine initializes the data structure for 
    the user callback function benders_callback.
    In particular, it creates the worker LP that will be used by 
-   the function benders_callback to separate Benders' cuts.
+   the function benders_callback to separate Benders' cuts or, if
+   separate_by_flow is set, the data structures for the maximum flow
+   computations that replace it.
 
    Worker LP model (dual of flow constraints and 
    capacity constraints of the flow MILP)
@@ -447,7 +564,8 @@ TERMINATE:
 
 static int
 init_user_cbhandle  (USER_CBHANDLE *user_cbhandle, int num_nodes, 
-                     int separate_fractional_solutions)
+                     int separate_fractional_solutions,
+                     int separate_by_flow)
 {
    int i, j, k;
    int status = 0;
@@ -465,6 +583,7 @@ init_user_cbhandle  (USER_CBHANDLE *user_cbhandle, int num_nodes,
    /* Init user_cbhandle */
 
    user_cbhandle->separate_fractional_solutions = separate_fractional_solutions;
+   user_cbhandle->separate_by_flow = separate_by_flow;
    user_cbhandle->num_nodes  = num_nodes;
    user_cbhandle->num_x_cols = num_nodes * num_nodes;
    user_cbhandle->num_v_cols = (num_nodes - 1) * user_cbhandle->num_x_cols;
@@ -476,6 +595,22 @@ init_user_cbhandle  (USER_CBHANDLE *user_cbhandle, int num_nodes,
    user_cbhandle->ray        = NULL;
    user_cbhandle->cutval     = NULL;
    user_cbhandle->cutind     = NULL;
+   user_cbhandle->resid      = NULL;
+   user_cbhandle->excess     = NULL;
+   user_cbhandle->label      = NULL;
+   user_cbhandle->current    = NULL;
+   user_cbhandle->queue      = NULL;
+   user_cbhandle->side       = NULL;
+   user_cbhandle->num_rows   = 0;
+   user_cbhandle->num_bases  = 0;
+   user_cbhandle->next_base  = 0;
+   user_cbhandle->base_key   = NULL;
+   user_cbhandle->base_cstat = NULL;
+   user_cbhandle->base_rstat = NULL;
+   user_cbhandle->num_solves = 0;
+   user_cbhandle->num_hits   = 0;
+   user_cbhandle->it_hits    = 0;
+   user_cbhandle->it_misses  = 0;
    
    user_cbhandle->x = (double *) malloc (user_cbhandle->num_x_cols *
                                          sizeof(double));
@@ -508,6 +643,25 @@ init_user_cbhandle  (USER_CBHANDLE *user_cbhandle, int num_nodes,
       fprintf (stderr, "No memory for cutind array.\n");
       goto TERMINATE;
    }
+
+   /* Separation by maximum flow computations does not use the worker LP */
+
+   if ( separate_by_flow ) {
+      user_cbhandle->resid = (double *) malloc (user_cbhandle->num_x_cols *
+                                                sizeof(double));
+      user_cbhandle->excess  = (double *) malloc (num_nodes * sizeof(double));
+      user_cbhandle->label   = (int *) malloc (num_nodes * sizeof(int));
+      user_cbhandle->current = (int *) malloc (num_nodes * sizeof(int));
+      user_cbhandle->queue   = (int *) malloc (num_nodes * sizeof(int));
+      user_cbhandle->side    = (int *) malloc (num_nodes * sizeof(int));
+      if ( user_cbhandle->resid   == NULL || user_cbhandle->excess == NULL ||
+           user_cbhandle->label   == NULL || user_cbhandle->current == NULL ||
+           user_cbhandle->queue   == NULL || user_cbhandle->side  == NULL ) {
+         fprintf (stderr, "No memory for maximum flow arrays.\n");
+         status = -1;
+      }
+      goto TERMINATE;
+   }
    
    /* Create the environment for the worker LP */
 
@@ -656,6 +810,25 @@ init_user_cbhandle  (USER_CBHANDLE *user_cbhandle, int num_nodes,
       fprintf (stderr, "Error in CPXaddrows: status = %d\n", status);
       goto TERMINATE;
    }
+
+   /* Allocate the cache of worker LP bases */
+
+   user_cbhandle->num_rows = num_rows;
+   user_cbhandle->base_key = (unsigned int *) malloc (NUM_BASES *
+                                                      sizeof(unsigned int));
+   user_cbhandle->base_cstat = (int *) malloc (NUM_BASES *
+                                               (user_cbhandle->num_v_cols +
+                                                user_cbhandle->num_u_cols) *
+                                               sizeof(int));
+   user_cbhandle->base_rstat = (int *) malloc (NUM_BASES * num_rows *
+                                               sizeof(int));
+   if ( user_cbhandle->base_key   == NULL ||
+        user_cbhandle->base_cstat == NULL ||
+        user_cbhandle->base_rstat == NULL ) {
+      fprintf (stderr, "No memory for the cache of bases.\n");
+      status = -1;
+      goto TERMINATE;
+   }
    
 TERMINATE:
 
@@ -688,6 +861,15 @@ free_user_cbhandle  (USER_CBHANDLE *user_cbhandle)
    free_and_null ((char **) &user_cbhandle->ray);
    free_and_null ((char **) &user_cbhandle->cutval);
    free_and_null ((char **) &user_cbhandle->cutind);
+   free_and_null ((char **) &user_cbhandle->resid);
+   free_and_null ((char **) &user_cbhandle->excess);
+   free_and_null ((char **) &user_cbhandle->label);
+   free_and_null ((char **) &user_cbhandle->current);
+   free_and_null ((char **) &user_cbhandle->queue);
+   free_and_null ((char **) &user_cbhandle->side);
+   free_and_null ((char **) &user_cbhandle->base_key);
+   free_and_null ((char **) &user_cbhandle->base_cstat);
+   free_and_null ((char **) &user_cbhandle->base_rstat);
    
    if ( user_cbhandle->lp != NULL ) {
       int local_status = CPXfreeprob (user_cbhandle->env, &(user_cbhandle->lp) );
@@ -816,10 +998,8 @@ benders_callback  (CPXCENVptr env, void *cbdata, int wherefrom,
    
    /* Data structures to add the Benders' cut */
    
-   int k, worker_lp_sol_stat, nzcnt, sense, purgeable;
-   int cur_x_col, cur_v_col, cur_u_col;
+   int found, nzcnt, sense, purgeable;
    double rhs;
-   double eps_ray = 1e-03;
    
 
    *useraction_p = CPX_CALLBACK_DEFAULT;
@@ -853,6 +1033,75 @@ benders_callback  (CPXCENVptr env, void *cbdata, int wherefrom,
       goto TERMINATE;
    }
 
+   /* Look for a violated cut, with the worker LP or
+      with maximum flow computations */
+
+   if ( user_cbhandle->separate_by_flow )
+      status = separate_flow (user_cbhandle, &found, &nzcnt, &rhs);
+   else
+      status = separate_lp (user_cbhandle, &found, &nzcnt, &rhs);
+   if ( status || !found ) 
+      goto TERMINATE;
+
+   sense = 'G';
+   
+   purgeable = CPX_USECUT_FORCE;
+
+   /* With this choice of the purgeable parameter,
+      the cut is added to the current relaxation and
+      it cannot be purged.
+      Note that the value CPX_USECUT_FILTER is not allowed if
+      Benders' cuts are added as lazy constraints (i.e., if 
+      wherefrom is CPX_CALLBACK_MIP_CUT_LOOP or 
+      CPX_CALLBACK_MIP_CUT_LAST). 
+      Possible values and meaning of the purgeable parameter 
+      are illustrated in the documentation of CPXcutcallbackadd */
+   
+   /* Add the cut to the master ILP */
+      
+   status = CPXcutcallbackadd (env, cbdata, wherefrom, nzcnt, rhs, sense, 
+                               user_cbhandle->cutind, user_cbhandle->cutval,
+                               purgeable);
+   if ( status ) {
+      fprintf (stderr, "Error in CPXcutcallbackadd: status = %d\n", status);
+      goto TERMINATE;
+   }
+   
+   /* Tell CPLEX that cuts have been created */ 
+
+   *useraction_p = CPX_CALLBACK_SET; 
+
+TERMINATE:
+
+   /* If an error has been encountered, we fail */
+
+   if ( status ) *useraction_p = CPX_CALLBACK_FAIL; 
+
+   return status;
+
+} /* END benders_callback */
+
+
+/* This routine separates a Benders' cut violated by the current x solution
+   by solving the worker LP. On return, *found_p is 1 iff a violated cut
+   sum((i,j) in A) cutval * x(i,j) >= *rhs_p, with *nzcnt_p nonzeros
+   in user_cbhandle->cutind and user_cbhandle->cutval, has been found. */
+
+static int
+separate_lp  (USER_CBHANDLE *user_cbhandle, int *found_p, int *nzcnt_p, 
+              double *rhs_p)
+{
+   int status = 0;
+   int k, worker_lp_sol_stat, nzcnt;
+   int cur_x_col, cur_v_col, cur_u_col;
+   int base, itcnt;
+   int num_cols = user_cbhandle->num_v_cols + user_cbhandle->num_u_cols;
+   unsigned int key;
+   double rhs;
+   double eps_ray = 1e-03;
+
+   *found_p = 0;
+
    /* Update the objective function in the worker LP:
       minimize sum(k in V0) sum((i,j) in A) x(i,j) * v(k,i,j) 
                - sum(k in V0) u(k,0) + sum(k in V0) u(k,k)    */
@@ -872,6 +1121,30 @@ benders_callback  (CPXCENVptr env, void *cbdata, int wherefrom,
       }
    }
 
+   /* Start from the cached basis of the x solutions that select the same
+      arcs (x(i,j) >= 0.5), if any. The key hashes these arcs (FNV-1a).
+      Otherwise, CPXprimopt starts from the final basis of the last solve. */
+
+   key = 2166136261U;
+   for (cur_x_col = 0; cur_x_col < user_cbhandle->num_x_cols; ++cur_x_col) {
+      if ( user_cbhandle->x[cur_x_col] >= 0.5 )
+         key = (key ^ (unsigned int) cur_x_col) * 16777619U;
+   }
+   for (base = 0; base < user_cbhandle->num_bases; ++base) {
+      if ( user_cbhandle->base_key[base] == key )
+         break;
+   }
+   if ( base < user_cbhandle->num_bases ) {
+      status = CPXcopybase (user_cbhandle->env, user_cbhandle->lp,
+                            user_cbhandle->base_cstat + base * num_cols,
+                            user_cbhandle->base_rstat + 
+                            base * user_cbhandle->num_rows);
+      if ( status ) {
+         fprintf (stderr, "Error in CPXcopybase: status = %d\n", status);
+         goto TERMINATE;
+      }
+   }
+
    /* Solve the worker LP and look for a violated cut 
       A violated cut is available iff 
       worker_lp_sol_stat == CPX_STAT_UNBOUNDED */
@@ -881,7 +1154,41 @@ benders_callback  (CPXCENVptr env, void *cbdata, int wherefrom,
       fprintf (stderr, "Error in CPXprimopt: status = %d\n", status);
       goto TERMINATE;
    }
+
+   itcnt = CPXgetitcnt (user_cbhandle->env, user_cbhandle->lp);
+   ++user_cbhandle->num_solves;
+   if ( base < user_cbhandle->num_bases ) {
+      ++user_cbhandle->num_hits;
+      user_cbhandle->it_hits += itcnt;
+   }
+   else {
+      user_cbhandle->it_misses += itcnt;
+   }
+
    worker_lp_sol_stat = CPXgetstat (user_cbhandle->env, user_cbhandle->lp);
+
+   /* Cache the final basis for key, in its slot or in the least
+      recently filled one */
+
+   if ( worker_lp_sol_stat == CPX_STAT_OPTIMAL ||
+        worker_lp_sol_stat == CPX_STAT_UNBOUNDED ) {
+      if ( base == user_cbhandle->num_bases ) {
+         base = user_cbhandle->next_base;
+         user_cbhandle->next_base = (base + 1) % NUM_BASES;
+         if ( user_cbhandle->num_bases < NUM_BASES )
+            ++user_cbhandle->num_bases;
+      }
+      status = CPXgetbase (user_cbhandle->env, user_cbhandle->lp,
+                           user_cbhandle->base_cstat + base * num_cols,
+                           user_cbhandle->base_rstat + 
+                           base * user_cbhandle->num_rows);
+      if ( status ) {
+         fprintf (stderr, "Error in CPXgetbase: status = %d\n", status);
+         goto TERMINATE;
+      }
+      user_cbhandle->base_key[base] = key;
+   }
+
    if ( worker_lp_sol_stat != CPX_STAT_UNBOUNDED) 
       goto TERMINATE;
    
@@ -913,7 +1220,6 @@ benders_callback  (CPXCENVptr env, void *cbdata, int wherefrom,
       }
    }
 
-   sense = 'G';
    rhs = 0.;   
    for (k = 1; k < user_cbhandle->num_nodes; ++k) {
       cur_u_col = user_cbhandle->num_v_cols + (k-1) * user_cbhandle->num_nodes;
@@ -925,42 +1231,182 @@ benders_callback  (CPXCENVptr env, void *cbdata, int wherefrom,
          rhs -= user_cbhandle->ray[cur_u_col];
       }
    }
-   
-   purgeable = CPX_USECUT_FORCE;
 
-   /* With this choice of the purgeable parameter,
-      the cut is added to the current relaxation and
-      it cannot be purged.
-      Note that the value CPX_USECUT_FILTER is not allowed if
-      Benders' cuts are added as lazy constraints (i.e., if 
-      wherefrom is CPX_CALLBACK_MIP_CUT_LOOP or 
-      CPX_CALLBACK_MIP_CUT_LAST). 
-      Possible values and meaning of the purgeable parameter 
-      are illustrated in the documentation of CPXcutcallbackadd */
-   
-   /* Add the cut to the master ILP */
-      
-   status = CPXcutcallbackadd (env, cbdata, wherefrom, nzcnt, rhs, sense, 
-                               user_cbhandle->cutind, user_cbhandle->cutval,
-                               purgeable);
-   if ( status ) {
-      fprintf (stderr, "Error in CPXcutcallbackadd: status = %d\n", status);
-      goto TERMINATE;
+   *found_p = 1;
+   *nzcnt_p = nzcnt;
+   *rhs_p   = rhs;
+
+TERMINATE:
+
+   return status;
+
+} /* END separate_lp */
+
+
+/* This routine separates a Benders' cut violated by the current x solution
+   without the worker LP. 
+   For a fixed x, the flow of commodity k can be routed iff the maximum flow
+   from node 0 to node k, with arc capacities x(i,j), is at least 1.
+   Otherwise, the source side S of a minimum cut gives the violated cut
+   sum((i,j) in A : i in S, j not in S) x(i,j) >= 1,
+   that is the cut computed by separate_lp from the unbounded ray
+   u(k,i) = 1 for i in S, u(k,i) = 0 for i not in S, 
+   v(k,i,j) = max(u(k,i) - u(k,j), 0) of the worker LP.
+   The most violated cut over all k in V0 is returned. */
+
+static int
+separate_flow  (USER_CBHANDLE *user_cbhandle, int *found_p, int *nzcnt_p, 
+                double *rhs_p)
+{
+   int i, j, k, nzcnt;
+   int num_nodes = user_cbhandle->num_nodes;
+   double flow, min_flow = 1. - 1e-06;
+
+   *found_p = 0;
+
+   for (k = 1; k < num_nodes && min_flow > 0.; ++k) {
+
+      /* Commodity k can be routed iff the maximum flow is at least 1 */
+
+      flow = max_flow (user_cbhandle, k);
+      if ( flow >= min_flow )
+         continue;
+      min_flow = flow;
+
+      /* Compute the cut from the minimum cut. The cut is:
+         sum((i,j) in A : i in S, j not in S) x(i,j) >= 1 */
+
+      nzcnt = 0;
+      for (i = 0; i < num_nodes; ++i) {
+         if ( !user_cbhandle->side[i] )
+            continue;
+         for (j = 0; j < num_nodes; ++j) {
+            if ( !user_cbhandle->side[j] ) {
+               user_cbhandle->cutind[nzcnt]   = i * num_nodes + j;
+               user_cbhandle->cutval[nzcnt++] = 1.;
+            }
+         }
+      }
+
+      *found_p = 1;
+      *nzcnt_p = nzcnt;
+      *rhs_p   = 1.;
    }
-   
-   /* Tell CPLEX that cuts have been created */ 
 
-   *useraction_p = CPX_CALLBACK_SET; 
+   return 0;
 
-TERMINATE:
+} /* END separate_flow */
 
-   /* If an error has been encountered, we fail */
 
-   if ( status ) *useraction_p = CPX_CALLBACK_FAIL; 
+/* This routine computes a maximum flow from node 0 to node sink in 
+   the directed graph with arc capacities user_cbhandle->x, by the FIFO
+   push-relabel method, and returns its value. On return, 
+   user_cbhandle->side[i] is 1 iff node i is on the source side S
+   of a minimum cut (0 in S, sink not in S). */
 
-   return status;
+static double
+max_flow  (USER_CBHANDLE *user_cbhandle, int sink)
+{
+   int i, j, head, num_active, num_reached, min_label, was_active;
+   int n = user_cbhandle->num_nodes;
+   double delta;
+   double eps = 1e-09;
+
+   const double *x = user_cbhandle->x;
+   double *resid   = user_cbhandle->resid;
+   double *excess  = user_cbhandle->excess;
+   int    *label   = user_cbhandle->label;
+   int    *current = user_cbhandle->current;
+   int    *queue   = user_cbhandle->queue;
+   int    *side    = user_cbhandle->side;
+
+   /* Init the preflow: the arcs out of node 0 are saturated, 
+      and the nodes they reach become active */
+
+   for (i = 0; i < n; ++i) {
+      for (j = 0; j < n; ++j)
+         resid[i * n + j] = ( i != j && x[i * n + j] > eps ? x[i * n + j] : 0. );
+      excess[i]  = 0.;
+      label[i]   = 0;
+      current[i] = 0;
+   }
+   label[0] = n;
+   head = 0;
+   num_active = 0;
+   for (j = 1; j < n; ++j) {
+      if ( resid[j] > 0. ) {
+         excess[j]       = resid[j];
+         resid[j * n]    = resid[j];
+         resid[j]        = 0.;
+         if ( j != sink )
+            queue[num_active++] = j;
+      }
+   }
 
-} /* END benders_callback */
+   /* Discharge the active nodes one at a time, pushing their excess along
+      admissible arcs (label[i] == label[j] + 1), and relabeling them 
+      when no admissible arc is left */
+
+   while ( num_active > 0 ) {
+      i = queue[head];
+      head = (head + 1) % n;
+      --num_active;
+      while ( excess[i] > eps ) {
+         if ( current[i] == n ) {
+            min_label = 2 * n;
+            for (j = 0; j < n; ++j) {
+               if ( resid[i * n + j] > eps && label[j] < min_label )
+                  min_label = label[j];
+            }
+            if ( min_label == 2 * n ) {
+               excess[i] = 0.;
+               break;
+            }
+            label[i]   = min_label + 1;
+            current[i] = 0;
+            continue;
+         }
+         j = current[i];
+         if ( resid[i * n + j] > eps && label[i] == label[j] + 1 ) {
+            delta = ( excess[i] < resid[i * n + j] ? 
+                      excess[i] : resid[i * n + j] );
+            was_active = ( excess[j] > eps );
+            resid[i * n + j] -= delta;
+            resid[j * n + i] += delta;
+            excess[i]        -= delta;
+            excess[j]        += delta;
+            if ( j != 0 && j != sink && !was_active && excess[j] > eps ) {
+               queue[(head + num_active) % n] = j;
+               ++num_active;
+            }
+         }
+         else {
+            ++current[i];
+         }
+      }
+   }
+
+   /* The nodes that can still reach the sink in the residual graph are
+      on the sink side of a minimum cut, all the others are in S */
+
+   for (i = 0; i < n; ++i)
+      side[i] = 1;
+   side[sink] = 0;
+   queue[0] = sink;
+   num_reached = 1;
+   for (head = 0; head < num_reached; ++head) {
+      j = queue[head];
+      for (i = 0; i < n; ++i) {
+         if ( side[i] && resid[i * n + j] > eps ) {
+            side[i] = 0;
+            queue[num_reached++] = i;
+         }
+      }
+   }
+
+   return excess[sink];
+
+} /* END max_flow */
 
 
 /* This routine creates the master ILP (arc variables x and degree constraints).
@@ -1267,7 +1713,7 @@ static void
 usage (char *progname)
 {
    fprintf (stderr,
-      "Usage:     %s {0|1} [filename]\n", progname);
+      "Usage:     %s {0|1} [lp|flow] [filename]\n", progname);
    fprintf (stderr,
       " 0:        Benders' cuts only used as lazy constraints,\n");
    fprintf (stderr,
@@ -1276,6 +1722,10 @@ usage (char *progname)
       " 1:        Benders' cuts also used as user cuts,\n");
    fprintf (stderr,
       "           to separate fractional infeasible solutions.\n");
+   fprintf (stderr,
+      " lp:       Benders' cuts separated by solving the worker LP (default).\n");
+   fprintf (stderr,
+      " flow:     Benders' cuts separated by computing maximum flows.\n");
    fprintf (stderr,
       " filename: ATSP instance file name.\n");
    fprintf (stderr, 
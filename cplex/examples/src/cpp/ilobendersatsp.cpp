@@ -18,11 +18,37 @@
 //
 // The arc costs of an ATSP instance are read from an input file.
 // The flow MILP model is decomposed into a master ILP and a worker LP.
+// Once x is fixed, the worker LP splits into n-1 independent LPs, one per
+// commodity k in V0, which are solved concurrently on a thread pool.
 //
 // The master ILP is then solved by adding Benders' cuts during
 // the branch-and-cut process via the cut callback functions.
 // The cut callback functions add to the master ILP violated Benders' cuts
-// that are found by solving the worker LP.
+// that are found by solving the worker LPs, one cut per commodity whose
+// worker LP is unbounded.
+// The master ILP is solved with as many threads as there are cores: each
+// thread owns its worker LPs, so that the cut callback functions of
+// different threads never share them.
+//
+// All Benders' cuts found are kept in a cut pool shared by all the threads.
+// Before solving the worker LPs, the cut callback functions look for pool
+// cuts violated by the current solution, and reuse them if there are any.
+// The cuts are added to the master ILP as purgeable cuts: CPLEX can drop
+// them from the relaxation, and the pool adds them again when needed.
+//
+// Successive x solutions, at neighbouring nodes of the branch-and-cut tree,
+// are often alike. Each worker LP keeps a cache of the bases it ended with,
+// keyed by a hash of the arcs the x solution selects (x(i,j) >= 0.5), and
+// starts from the cached basis of the same key, if any. The number of
+// simplex iterations with and without a cached basis is reported at the end.
+//
+// For this model, Benders' cuts can also be separated without the worker LP:
+// for a fixed x, the flow of commodity k can be routed iff the maximum flow
+// from node 0 to node k, with arc capacities x(i,j), is at least 1.
+// The example allows the user to choose between the two separators:
+// the worker LP, or a push-relabel maximum flow computation on the
+// n-node graph of the arcs with x(i,j) > 0, whose minimum cuts give
+// the violated Benders' cuts.
 //
 // The example allows the user to decide if Benders' cuts have to be separated:
 //
@@ -38,13 +64,18 @@
 //
 //
 // To run this example, command line arguments are required:
-//     ilobendersatsp.cpp {0|1} [filename]
+//     ilobendersatsp.cpp {0|1} [lp|flow] [filename]
 // where
 //     0         Indicates that Benders' cuts are only used as lazy constraints,
 //               to separate integer infeasible solutions.
 //     1         Indicates that Benders' cuts are also used as user cuts,
 //               to separate fractional infeasible solutions.
 //
+//     lp        Indicates that Benders' cuts are separated by solving
+//               the worker LP (the default).
+//     flow      Indicates that Benders' cuts are separated by computing
+//               maximum flows (minimum cuts) in the graph of x.
+//
 //     filename  Is the name of the file containing the ATSP instance (arc costs).
 //               If filename is not specified, the instance
 //               ../../../examples/data/atsp.dat is read
@@ -92,59 +123,303 @@
 
 #include <ilcplex/ilocplex.h>
 #include <string>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 ILOSTLBEGIN
 
 typedef IloArray<IloIntVarArray> Arcs;
 
 
+// Maximum flow engine used to separate Benders' cuts without the worker LP.
+// The function maxFlow computes a maximum flow from node 0 to node sink in
+// the directed graph with arc capacities xSol(i,j), by the FIFO push-relabel
+// method, and records the source side S of a minimum cut
+// (0 in S, sink not in S), which can then be queried with inSource.
+// The working arrays are allocated once, when the engine is created.
+//
+class MinCut {
+public:
+   MinCut(IloEnv env, IloInt numNodes);
+   IloNum maxFlow(const IloNumArray2 xSol, IloInt sink);
+   IloBool inSource(IloInt i) const { return side[i] == 1; }
+private:
+   IloInt       numNodes;
+   IloNumArray2 resid;    // residual capacities
+   IloNumArray  excess;   // flow excess of the nodes
+   IloIntArray  label;    // distance labels of the nodes
+   IloIntArray  current;  // next arc (i,current[i]) to scan from node i
+   IloIntArray  queue;    // active nodes, in FIFO order
+   IloIntArray  side;     // 1 for the nodes in S, 0 otherwise
+};
+
+
+// Simplex iterations of the worker LPs, with and without a cached basis
+//
+struct WarmStartStatistics {
+   IloInt numSolves;
+   IloInt numRestored;  // solves started from a cached basis
+   IloInt itRestored;   // simplex iterations of those solves
+   IloInt itOther;      // simplex iterations of the other solves
+
+   WarmStartStatistics()
+      : numSolves(0), numRestored(0), itRestored(0), itOther(0) {}
+   void add(const WarmStartStatistics& other) {
+      numSolves   += other.numSolves;
+      numRestored += other.numRestored;
+      itRestored  += other.itRestored;
+      itOther     += other.itOther;
+   }
+   void print(ostream& out) const;
+};
+
+
+// Worker LP of a single commodity k in V0, with its own environment so that
+// the worker LPs of different commodities can be solved in different threads.
+// The function separate solves the worker LP for the current x solution and,
+// if it is unbounded, stores the cut
+// sum((i,j) in A) cutCoef[i*numNodes + j] * x(i,j) >= cutRhs
+// computed from the unbounded ray.
+// The solve starts from the basis cached for basisKey, if any, and the
+// final basis is cached for basisKey. The cache keeps the bases of the
+// last numBasisSlots keys.
+//
+class CommodityWorker {
+public:
+   CommodityWorker(IloInt numNodes, IloInt k);
+   ~CommodityWorker();
+   IloBool separate(const IloNumArray2 xSol, size_t basisKey);
+   IloBool             violated;  // a violated cut was found by separate
+   vector<IloNum>      cutCoef;
+   IloNum              cutRhs;
+   WarmStartStatistics stats;
+private:
+   enum { numBasisSlots = 32 };
+   IloInt         numNodes;
+   IloInt         k;
+   IloEnv         env;
+   IloCplex       cplex;
+   IloNumVarArray v;
+   IloNumVarArray u;
+   IloObjective   obj;
+   IloNumArray    xFlat;     // x(i,j) at i*numNodes + j
+   IloNumVarArray rayVar;    // unbounded ray read by separate
+   IloNumArray    rayVal;
+   IloNumVarArray vars;      // v then u, and the constraints,
+   IloRangeArray  rows;      // to get and set bases
+   IloCplex::BasisStatusArray colStat;
+   IloCplex::BasisStatusArray rowStat;
+   vector<size_t> basisKeys;  // key of the basis in each slot
+   vector<int>    basisCols;  // statuses of vars, numBasisSlots by vars
+   vector<int>    basisRows;  // statuses of rows, numBasisSlots by rows
+   IloInt         nextSlot;   // slot to overwrite next
+};
+
+
+// Thread pool to solve worker LPs concurrently.
+// The function solve solves a batch of worker LPs on the threads of the pool
+// and on the calling thread, and returns when all of them are solved.
+// Several threads may call solve at the same time.
+// The queue is a ring buffer of maxJobs jobs, allocated once: maxJobs must
+// bound the worker LPs queued at once, i.e., the sum of numWorkers over
+// the threads that may call solve at the same time.
+//
+class WorkerPool {
+public:
+   WorkerPool(IloInt numThreads, IloInt maxJobs);
+   ~WorkerPool();
+   IloBool solve(CommodityWorker* const* workers, IloInt numWorkers,
+                 const IloNumArray2 xSol, size_t basisKey);
+private:
+   struct Batch {
+      IloNumArray2 xSol;
+      size_t       basisKey;
+      IloInt       pending;  // worker LPs not solved yet
+      IloBool      failed;
+   };
+   struct Job {
+      CommodityWorker* worker;
+      Batch*           batch;
+   };
+   void loop();
+   void runJob(unique_lock<mutex>& guard);
+   mutex              lock;
+   condition_variable wake;  // signaled when jobs are queued or at the end
+   condition_variable done;  // signaled when a batch is solved
+   vector<Job>        jobs;      // ring buffer of the queued jobs:
+   size_t             firstJob;  // jobs[firstJob], ..., numJobs of them
+   size_t             numJobs;
+   vector<thread>     threads;
+   IloBool            stopped;
+};
+
+
+// Benders' cuts in compressed sparse form: cut c is
+// sum(h = beg[c], ..., beg[c+1]-1) val[h] * x(i,j) >= rhs[c]
+// where ind[h] = i*numNodes + j.
+//
+struct SparseCuts {
+   vector<IloInt> beg;
+   vector<int>    ind;
+   vector<IloNum> val;
+   vector<IloNum> rhs;
+
+   SparseCuts() : beg(1, 0) {}
+   IloInt size() const { return (IloInt) rhs.size(); }
+   void clear() {
+      beg.assign(1, 0);
+      ind.clear();
+      val.clear();
+      rhs.clear();
+   }
+   // Append the cut sum(h) coef[h] * x(h) >= cutRhs, given dense
+   void add(const vector<IloNum>& coef, IloNum cutRhs) {
+      for (size_t h = 0; h < coef.size(); ++h) {
+         if ( coef[h] != 0. ) {
+            ind.push_back((int) h);
+            val.push_back(coef[h]);
+         }
+      }
+      beg.push_back((IloInt) ind.size());
+      rhs.push_back(cutRhs);
+   }
+   // Append the cut with the nnz nonzeros cutInd, cutVal
+   void add(const int* cutInd, const IloNum* cutVal, IloInt nnz,
+            IloNum cutRhs) {
+      ind.insert(ind.end(), cutInd, cutInd + nnz);
+      val.insert(val.end(), cutVal, cutVal + nnz);
+      beg.push_back((IloInt) ind.size());
+      rhs.push_back(cutRhs);
+   }
+   // Append cut c of cuts
+   void add(const SparseCuts& cuts, IloInt c) {
+      add(&cuts.ind[0] + cuts.beg[c], &cuts.val[0] + cuts.beg[c],
+          cuts.beg[c+1] - cuts.beg[c], cuts.rhs[c]);
+   }
+};
+
+
+// Pool of the Benders' cuts found so far, shared by all the threads.
+// Cuts are stored in compressed sparse form, scaled to right-hand side 1.
+// The function separate copies to violated the pool cuts violated by x
+// and returns their number.
+// The function add inserts cut c of cuts in the pool, unless it duplicates
+// a pool cut or is dominated by one, and removes the pool cuts it dominates.
+// As x >= 0, the cut a x >= 1 dominates the cut b x >= 1 if a <= b.
+// The pool is copied on write: separate scans the current version of the
+// cuts, which is never changed, without locking, and add builds the next
+// version aside and only locks to publish it. So the threads separate in
+// parallel, while a cut is being added too.
+//
+class CutPool {
+public:
+   CutPool();
+   IloInt separate(const vector<IloNum>& xFlat, SparseCuts& violated);
+   void add(const SparseCuts& newCuts, IloInt c);
+   void printStatistics(ostream& out);
+private:
+   static IloBool dominates(const SparseCuts& cuts, IloInt p,
+                            const int* ind, const IloNum* val, IloInt nnz);
+   static IloBool isDominatedBy(const SparseCuts& cuts, IloInt p,
+                                const int* ind, const IloNum* val,
+                                IloInt nnz);
+   mutex                        lock;      // guards cuts, held to copy it
+   shared_ptr<const SparseCuts> cuts;      // right-hand sides are all 1
+   mutex                        addLock;   // one add at a time
+   vector<IloNum>               scaled;    // cut being added, scaled
+   // Statistics
+   atomic<IloInt> numSeparations;  // calls to separate
+   atomic<IloInt> numHits;         // calls to separate that found cuts
+   atomic<IloInt> numCutsReused;   // violated cuts found by separate
+   IloInt numCutsAdded;
+   IloInt numDuplicates;
+   IloInt numDominated;    // cuts not added because dominated
+   IloInt numRemoved;      // pool cuts removed because dominated
+};
+
+
+// Benders' cut separation context of one thread of the master ILP:
+// the worker LPs of all commodities, or the maximum flow engine if
+// Benders' cuts are separated by flows, and all the buffers the cut
+// callback functions need, sized when the context is created, so that
+// separating cuts allocates no memory once the buffers have grown to
+// the largest cuts.
+// The cut callback functions read the current x solution into xSol and
+// call separate, which returns the number of violated cuts found, or -1
+// if a worker LP could not be solved. Then getCut writes the left-hand
+// side of cut c to cutLhs, and returns its right-hand side.
+//
+class BendersWorker {
+public:
+   BendersWorker(IloEnv masterEnv, const Arcs x, IloBool byFlow,
+                 WorkerPool* wPool, CutPool* cPool);
+   ~BendersWorker();
+   IloInt separate();
+   IloNum getCut(IloInt c);
+   void   addStatistics(WarmStartStatistics& total) const;
+   IloNumArray2             xSol;
+   IloExpr                  cutLhs;
+private:
+   Arcs                     x;
+   IloInt                   numNodes;
+   MinCut*                  minCut;
+   vector<CommodityWorker*> commodities;
+   WorkerPool*              workerPool;
+   CutPool*                 cutPool;
+   vector<IloNum>           xFlat;     // x(i,j) at i*numNodes + j
+   vector<IloNum>           flowCoef;  // cut found by separateFlow
+   SparseCuts               cuts;      // cuts found by separate
+};
+
+
 // Declarations for functions in this program
 
 void createMasterILP(IloModel mod, Arcs x, IloNumArray2 arcCost);
 
 void createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
-                   IloObjective obj, IloInt numNodes);
+                   IloObjective obj, IloRangeArray rows, IloInt numNodes,
+                   IloInt k);
 
-IloBool separate(const Arcs x, const IloNumArray2 xSol, IloCplex cplex,
-                 const IloNumVarArray v, const IloNumVarArray u,
-                 IloObjective obj, IloExpr cutLhs, IloNum& cutRhs);
+IloBool separateFlow(const IloNumArray2 xSol, MinCut& minCut,
+                     vector<IloNum>& cutCoef, IloNum& cutRhs);
 
 void usage(char *progname);
 
 
 // Implementation class for the user-defined lazy constraint callback.
 // The function BendersLazyCallback allows to add Benders' cuts as lazy constraints.
+// Each thread separates Benders' cuts with its own worker, workers[t],
+// whose buffers are reused from call to call.
+// The cuts are purgeable, as the cut pool keeps them.
 //
-ILOLAZYCONSTRAINTCALLBACK5(BendersLazyCallback, Arcs, x, IloCplex, workerCplex,
-                           IloNumVarArray, v, IloNumVarArray, u,
-                           IloObjective, workerObj)
+ILOLAZYCONSTRAINTCALLBACK2(BendersLazyCallback, Arcs, x,
+                           BendersWorker* const*, workers)
 {
    IloInt i;
-   IloEnv masterEnv = getEnv();
+   BendersWorker* worker = workers[getMyThreadNum()];
    IloInt numNodes = x.getSize();
 
    // Get the current x solution
   
-   IloNumArray2 xSol(masterEnv, numNodes);
-   for (i = 0; i < numNodes; ++i) {
-      xSol[i] = IloNumArray(masterEnv);
-      getValues(xSol[i], x[i]);
-   }
+   for (i = 0; i < numNodes; ++i)
+      getValues(worker->xSol[i], x[i]);
 
    // Benders' cut separation
 
-   IloExpr cutLhs(masterEnv);
-   IloNum cutRhs;
-   IloBool sepStat = separate(x, xSol, workerCplex, v, u, workerObj, cutLhs, cutRhs);
-   if ( sepStat ) {
-      add(cutLhs >= cutRhs).end();
+   IloInt numCuts = worker->separate();
+   if ( numCuts < 0 ) {
+      abort();
+      return;
+   }
+   for (i = 0; i < numCuts; ++i) {
+      IloNum cutRhs = worker->getCut(i);
+      add(worker->cutLhs >= cutRhs, IloCplex::UseCutPurge).end();
    }
-
-   // Free memory
-
-   cutLhs.end();
-   for (i = 0; i < numNodes; ++i)
-      xSol[i].end();
-   xSol.end();
 
    return;
 
@@ -153,10 +428,12 @@ ILOLAZYCONSTRAINTCALLBACK5(BendersLazyCallback, Arcs, x, IloCplex, workerCplex,
 
 // Implementation class for the user-defined user cut callback.
 // The function BendersUserCallback allows to add Benders' cuts as user cuts.
+// Each thread separates Benders' cuts with its own worker, workers[t],
+// whose buffers are reused from call to call.
+// The cuts are purgeable, as the cut pool keeps them.
 //
-ILOUSERCUTCALLBACK5(BendersUserCallback, Arcs, x, IloCplex, workerCplex,
-                    IloNumVarArray, v, IloNumVarArray, u,
-                    IloObjective, workerObj)
+ILOUSERCUTCALLBACK2(BendersUserCallback, Arcs, x,
+                    BendersWorker* const*, workers)
 {
    // Skip the separation if not at the end of the cut loop
 
@@ -164,32 +441,25 @@ ILOUSERCUTCALLBACK5(BendersUserCallback, Arcs, x, IloCplex, workerCplex,
       return;
 
    IloInt i;
-   IloEnv masterEnv = getEnv();
+   BendersWorker* worker = workers[getMyThreadNum()];
    IloInt numNodes = x.getSize();
 
    // Get the current x solution
-
-   IloNumArray2 xSol(masterEnv, numNodes);
-   for (i = 0; i < numNodes; ++i) {
-      xSol[i] = IloNumArray(masterEnv);
-      getValues(xSol[i], x[i]);
-   }
+  
+   for (i = 0; i < numNodes; ++i)
+      getValues(worker->xSol[i], x[i]);
 
    // Benders' cut separation
 
-   IloExpr cutLhs(masterEnv);
-   IloNum cutRhs;
-   IloBool sepStat = separate(x, xSol, workerCplex, v, u, workerObj, cutLhs, cutRhs);
-   if ( sepStat ) {
-      add(cutLhs >= cutRhs).end();
+   IloInt numCuts = worker->separate();
+   if ( numCuts < 0 ) {
+      abort();
+      return;
+   }
+   for (i = 0; i < numCuts; ++i) {
+      IloNum cutRhs = worker->getCut(i);
+      add(worker->cutLhs >= cutRhs, IloCplex::UseCutPurge).end();
    }
-   
-   // Free memory
-
-   cutLhs.end();
-   for (i = 0; i < numNodes; ++i)
-      xSol[i].end();
-   xSol.end();
 
    return;
 
@@ -200,14 +470,16 @@ int
 main(int argc, char **argv)
 {
    IloEnv masterEnv;
-   IloEnv workerEnv;
+   WorkerPool* pool = 0;
+   CutPool cutPool;
+   vector<BendersWorker*> workers;
 
    try {
       const char* fileName = "../../../examples/data/atsp.dat";
 
        // Check the command line arguments
 
-      if ( argc != 2 && argc != 3) {
+      if ( argc < 2 || argc > 4 ) {
          usage (argv[0]);
          throw (-1);
       }
@@ -228,7 +500,26 @@ main(int argc, char **argv)
          masterEnv.out() << "Only integer infeasible solutions." << endl;
       }
 
-      if ( argc == 3 )  fileName = argv[2];
+      IloInt nextArg = 2;
+      IloBool separateByFlow = IloFalse;
+      if ( argc > nextArg && (strcmp(argv[nextArg], "lp")   == 0 ||
+                              strcmp(argv[nextArg], "flow") == 0) ) {
+         separateByFlow = ( argv[nextArg][0] == 'f' );
+         ++nextArg;
+      }
+      if ( argc > nextArg )  fileName = argv[nextArg++];
+      if ( argc > nextArg ) {
+         usage (argv[0]);
+         throw (-1);
+      }
+
+      masterEnv.out() << "Benders' cuts separated by: ";
+      if ( separateByFlow ) {
+         masterEnv.out() << "Maximum flow computations." << endl;
+      }
+      else {
+         masterEnv.out() << "The worker LPs of the commodities." << endl;
+      }
 
       // Read arc_costs from data file (17 city problem)
 
@@ -245,37 +536,41 @@ main(int argc, char **argv)
       Arcs x(masterEnv, numNodes);
       createMasterILP(masterMod, x, arcCost);
 
-      // Create worker IloCplex algorithm and worker LP for Benders' cuts separation
-
-      IloCplex workerCplex(workerEnv);
-      IloNumVarArray v(workerEnv);
-      IloNumVarArray u(workerEnv);
-      IloObjective workerObj(workerEnv);
-      createWorkerLP(workerCplex, v, u, workerObj, numNodes);
-
       // Set up the cut callback to be used for separating Benders' cuts
 
       IloCplex masterCplex(masterMod);
       masterCplex.setParam(IloCplex::Param::Preprocessing::Presolve, IloFalse); 
 
-      // Set the maximum number of threads to 1. 
-      // This instruction is redundant: If MIP control callbacks are registered, 
-      // then by default CPLEX uses 1 (one) thread only.
-      // Note that the current example may not work properly if more than 1 threads 
-      // are used, because the callback functions modify shared global data.
-      // We refer the user to the documentation to see how to deal with multi-thread 
-      // runs in presence of MIP control callbacks. 
+      // Set the number of threads to the number of cores.
+      // If MIP control callbacks are registered, then by default CPLEX uses
+      // 1 (one) thread only. The callback functions of this example may run
+      // in several threads at the same time, because each thread separates
+      // Benders' cuts with its own worker: thread t uses workers[t], which
+      // owns the worker LPs (or the maximum flow engine) of that thread only.
+      // The worker LPs of the commodities are solved on a thread pool
+      // shared by all the threads.
+
+      IloInt numThreads = masterCplex.getNumCores();
+      masterCplex.setParam(IloCplex::Param::Threads, numThreads); 
+
+      // Create the thread pool and the workers for Benders' cuts separation,
+      // which share the cut pool. Each thread queues at most one worker LP
+      // per commodity at a time.
 
-      masterCplex.setParam(IloCplex::Param::Threads, 1); 
+      if ( !separateByFlow )
+         pool = new WorkerPool(numThreads, numThreads * (numNodes - 1));
+      for (IloInt t = 0; t < numThreads; ++t)
+         workers.push_back(new BendersWorker(masterEnv, x, separateByFlow,
+                                             pool, &cutPool));
 
       // Turn on traditional search for use with control callbacks
 
       masterCplex.setParam(IloCplex::Param::MIP::Strategy::Search,
                            IloCplex::Traditional);
       
-      masterCplex.use(BendersLazyCallback(masterEnv, x, workerCplex, v, u, workerObj));
+      masterCplex.use(BendersLazyCallback(masterEnv, x, &workers[0]));
       if ( separateFracSols )
-         masterCplex.use(BendersUserCallback(masterEnv, x, workerCplex, v, u, workerObj));
+         masterCplex.use(BendersUserCallback(masterEnv, x, &workers[0]));
 
       // Solve the model and write out the solution
 
@@ -321,6 +616,14 @@ main(int argc, char **argv)
          masterEnv.out() << "No solution available" << endl;
       }
 
+      cutPool.printStatistics(masterEnv.out());
+      if ( !separateByFlow ) {
+         WarmStartStatistics warmStart;
+         for (size_t t = 0; t < workers.size(); ++t)
+            workers[t]->addStatistics(warmStart);
+         warmStart.print(masterEnv.out());
+      }
+
    }
    catch (const IloException& e) {
       cerr << "Exception caught: " << e << endl;
@@ -329,10 +632,12 @@ main(int argc, char **argv)
       cerr << "Unknown exception caught!" << endl;
    }
 
-   // Close the environments
+   // Free the workers and the thread pool, and close the environment
 
+   for (size_t t = 0; t < workers.size(); ++t)
+      delete workers[t];
+   delete pool;
    masterEnv.end();
-   workerEnv.end();
 
    return 0;
 
@@ -414,33 +719,35 @@ createMasterILP(IloModel mod, Arcs x, IloNumArray2 arcCost)
 }// END createMasterILP
 
 
-// This routine set up the IloCplex algorithm to solve the worker LP, and
-// creates the worker LP (i.e., the dual of flow constraints and
-// capacity constraints of the flow MILP)
+// This routine set up the IloCplex algorithm to solve the worker LP of
+// commodity k, and creates the worker LP (i.e., the dual of flow constraints
+// and capacity constraints of the flow MILP for commodity k).
+// The worker LP of the flow MILP is made of the worker LPs of all the
+// commodities k in V0, which share no variables and no constraints.
 //
 // Modeling variables:
-// forall k in V0, i in V:
+// forall i in V:
 //    u(k,i) = dual variable associated with flow constraint (k,i)
 //
-// forall k in V0, forall (i,j) in A:
+// forall (i,j) in A:
 //    v(k,i,j) = dual variable associated with capacity constraint (k,i,j)
 //
 // Objective:
-// minimize sum(k in V0) sum((i,j) in A) x(i,j) * v(k,i,j)
-//          - sum(k in V0) u(k,0) + sum(k in V0) u(k,k)
+// minimize sum((i,j) in A) x(i,j) * v(k,i,j) - u(k,0) + u(k,k)
 //
 // Constraints:
-// forall k in V0, forall (i,j) in A: u(k,i) - u(k,j) <= v(k,i,j)
+// forall (i,j) in A: u(k,i) - u(k,j) <= v(k,i,j)
 //
 // Nonnegativity on variables v(k,i,j)
-// forall k in V0, forall (i,j) in A: v(k,i,j) >= 0
+// forall (i,j) in A: v(k,i,j) >= 0
 //
 void
 createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u, 
-               IloObjective obj, IloInt numNodes)
+               IloObjective obj, IloRangeArray rows, IloInt numNodes,
+               IloInt k)
 {
 
-   IloInt i, j, k;
+   IloInt i, j;
    IloEnv env = cplex.getEnv();
    IloModel mod(env, "atsp_worker"); 
 
@@ -451,22 +758,22 @@ createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
       
    // Turn off the presolve reductions and set the CPLEX optimizer
    // to solve the worker LP with primal simplex method.
+   // The worker LPs are solved concurrently by the threads of the pool,
+   // so each of them is solved with 1 (one) thread.
 
    cplex.setParam(IloCplex::Param::Preprocessing::Reduce, 0);
    cplex.setParam(IloCplex::Param::RootAlgorithm, IloCplex::Primal); 
+   cplex.setParam(IloCplex::Param::Threads, 1); 
    
-   // Create variables v(k,i,j) forall k in V0, (i,j) in A
+   // Create variables v(k,i,j) forall (i,j) in A
    // For simplicity, also dummy variables v(k,i,i) are created.
    // Those variables are fixed to 0 and do not partecipate to 
    // the constraints.
 
-   IloInt numArcs  = numNodes * numNodes;
-   IloInt vNumVars = (numNodes-1) * numArcs;
+   IloInt vNumVars = numNodes * numNodes;
    IloNumVarArray vTemp(env, vNumVars, 0, IloInfinity);
-   for (k = 1; k < numNodes; ++k) {
-      for (i = 0; i < numNodes; ++i) {
-         vTemp[(k-1)*numArcs + i *numNodes + i].setBounds(0, 0);
-      }
+   for (i = 0; i < numNodes; ++i) {
+      vTemp[i*numNodes + i].setBounds(0, 0);
    }
    v.clear();
    v.add(vTemp);
@@ -475,13 +782,11 @@ createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
 
    // Set names for variables v(k,i,j) 
 
-   for (k = 1; k < numNodes; ++k) {
-      for(i = 0; i < numNodes; ++i) {
-         for(j = 0; j < numNodes; ++j) {
-            char varName[100];
-            sprintf(varName, "v.%d.%d.%d", (int) k, (int) i, (int) j); 
-            v[(k-1)*numArcs + i*numNodes + j].setName(varName);
-         }
+   for(i = 0; i < numNodes; ++i) {
+      for(j = 0; j < numNodes; ++j) {
+         char varName[100];
+         sprintf(varName, "v.%d.%d.%d", (int) k, (int) i, (int) j); 
+         v[i*numNodes + j].setName(varName);
       }
    }
    
@@ -494,9 +799,9 @@ createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
       v[j].setObject(&vIndex[j]);
    }
 
-   // Create variables u(k,i) forall k in V0, i in V
+   // Create variables u(k,i) forall i in V
 
-   IloInt uNumVars = (numNodes-1) * numNodes;
+   IloInt uNumVars = numNodes;
    IloNumVarArray uTemp(env, uNumVars, -IloInfinity, IloInfinity);
    u.clear();
    u.add(uTemp);
@@ -505,12 +810,10 @@ createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
 
    // Set names for variables u(k,i) 
 
-   for (k = 1; k < numNodes; ++k) {
-      for(i = 0; i < numNodes; ++i) {
-         char varName[100];
-         sprintf(varName, "u.%d.%d", (int) k, (int) i); 
-         u[(k-1)*numNodes + i].setName(varName);
-      }
+   for(i = 0; i < numNodes; ++i) {
+      char varName[100];
+      sprintf(varName, "u.%d.%d", (int) k, (int) i); 
+      u[i].setName(varName);
    }
 
    // Associate indices to variables u(k,i)
@@ -522,25 +825,28 @@ createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
       u[j].setObject(&uIndex[j]);
    }
 
-   // Initial objective function is empty
+   // Initial objective function is - u(k,0) + u(k,k);
+   // the coefficients of v(k,i,j) are set at each separation
 
    obj.setSense(IloObjective::Minimize);
+   obj.setLinearCoef(u[0], -1.);
+   obj.setLinearCoef(u[k], 1.);
    mod.add(obj);
 
    // Add constraints:
-   // forall k in V0, forall (i,j) in A: u(k,i) - u(k,j) <= v(k,i,j)
-
-   for (k = 1; k < numNodes; ++k) {
-      for(i = 0; i < numNodes; ++i) {
-         for(j = 0; j < numNodes; ++j) {
-            if ( i != j ) {
-               IloExpr expr(env);
-               expr -= v[(k-1)*numArcs + i*(numNodes) + j];
-               expr += u[(k-1)*numNodes + i];
-               expr -= u[(k-1)*numNodes + j];
-               mod.add(expr <= 0);
-               expr.end();
-            }
+   // forall (i,j) in A: u(k,i) - u(k,j) <= v(k,i,j)
+
+   for(i = 0; i < numNodes; ++i) {
+      for(j = 0; j < numNodes; ++j) {
+         if ( i != j ) {
+            IloExpr expr(env);
+            expr -= v[i*numNodes + j];
+            expr += u[i];
+            expr -= u[j];
+            IloRange row = (expr <= 0);
+            rows.add(row);
+            mod.add(row);
+            expr.end();
          }
       }
    }
@@ -548,108 +854,722 @@ createWorkerLP(IloCplex cplex, IloNumVarArray v, IloNumVarArray u,
 }// END createWorkerLP
 
 
-// This routine separates Benders' cuts violated by the current x solution.
-// Violated cuts are found by solving the worker LP
+CommodityWorker::CommodityWorker(IloInt n, IloInt commodity)
+   : violated(IloFalse), cutCoef(n * n), cutRhs(0.),
+     numNodes(n), k(commodity), env(), cplex(env), v(env), u(env),
+     obj(env), xFlat(env, n * n), rayVar(env), rayVal(env), vars(env),
+     rows(env), colStat(env), rowStat(env), basisKeys(numBasisSlots),
+     nextSlot(0)
+{
+   createWorkerLP(cplex, v, u, obj, rows, numNodes, k);
+   vars.add(v);
+   vars.add(u);
+   basisCols.resize(numBasisSlots * vars.getSize());
+   basisRows.resize(numBasisSlots * rows.getSize());
+
+} // END CommodityWorker::CommodityWorker
+
+
+CommodityWorker::~CommodityWorker()
+{
+   env.end();
+
+} // END CommodityWorker::~CommodityWorker
+
+
+// This routine separates a Benders' cut violated by the current x solution
+// for commodity k. Violated cuts are found by solving the worker LP.
+// It returns IloFalse if the worker LP could not be solved.
 //
 IloBool
-separate(const Arcs x, const IloNumArray2 xSol, IloCplex cplex,
-         const IloNumVarArray v, const IloNumVarArray u,
-         IloObjective obj, IloExpr cutLhs, IloNum& cutRhs)
+CommodityWorker::separate(const IloNumArray2 xSol, size_t basisKey)
 {
-   IloBool violatedCutFound = IloFalse;
+   IloInt i, j, h;
+   IloInt numVars = vars.getSize();
+   IloInt numRows = rows.getSize();
 
-   IloEnv env = cplex.getEnv();
-   IloModel mod = cplex.getModel();
+   violated = IloFalse;
 
-   IloInt numNodes = xSol.getSize();
-   IloInt numArcs  = numNodes * numNodes;
-   IloInt i, j, k, h;
+   try {
+
+      // Update the objective function in the worker LP:
+      // minimize sum((i,j) in A) x(i,j) * v(k,i,j) - u(k,0) + u(k,k)
 
-   // Update the objective function in the worker LP:
-   // minimize sum(k in V0) sum((i,j) in A) x(i,j) * v(k,i,j)
-   //          - sum(k in V0) u(k,0) + sum(k in V0) u(k,k)
-   
-   mod.remove(obj);
-   IloExpr objExpr = obj.getExpr();
-   objExpr.clear();
-   for (k = 1; k < numNodes; ++k) {
       for (i = 0; i < numNodes; ++i) {
-         for (j = 0; j < numNodes; ++j) {
-               objExpr +=  xSol[i][j] * v[(k-1)*numArcs + i*numNodes + j];
+         for (j = 0; j < numNodes; ++j)
+            xFlat[i*numNodes + j] = xSol[i][j];
+      }
+      obj.setLinearCoefs(v, xFlat);
+
+      // Start from the basis cached for basisKey, if any.
+      // Otherwise, CPLEX starts from the final basis of the last solve.
+
+      IloInt slot = -1;
+      for (h = 0; h < numBasisSlots && h < nextSlot && slot < 0; ++h) {
+         if ( basisKeys[h] == basisKey )
+            slot = h;
+      }
+      if ( slot >= 0 ) {
+         colStat.clear();
+         rowStat.clear();
+         for (h = 0; h < numVars; ++h)
+            colStat.add((IloCplex::BasisStatus) basisCols[slot*numVars + h]);
+         for (h = 0; h < numRows; ++h)
+            rowStat.add((IloCplex::BasisStatus) basisRows[slot*numRows + h]);
+         cplex.setBasisStatuses(colStat, vars, rowStat, rows);
+      }
+
+      // Solve the worker LP
+
+      cplex.solve();
+
+      ++stats.numSolves;
+      if ( slot >= 0 ) {
+         ++stats.numRestored;
+         stats.itRestored += cplex.getNiterations();
+      }
+      else {
+         stats.itOther += cplex.getNiterations();
+      }
+
+      // Cache the final basis for basisKey, in its slot or in the
+      // least recently filled one
+
+      IloAlgorithm::Status status = cplex.getStatus();
+      if ( status == IloAlgorithm::Optimal ||
+           status == IloAlgorithm::Unbounded ) {
+         if ( slot < 0 ) {
+            slot = nextSlot % numBasisSlots;
+            ++nextSlot;
+         }
+         cplex.getBasisStatuses(colStat, vars, rowStat, rows);
+         basisKeys[slot] = basisKey;
+         for (h = 0; h < numVars; ++h)
+            basisCols[slot*numVars + h] = colStat[h];
+         for (h = 0; h < numRows; ++h)
+            basisRows[slot*numRows + h] = rowStat[h];
+      }
+
+      // A violated cut is available iff the solution status is Unbounded
+
+      if ( status == IloAlgorithm::Unbounded ) {
+
+         IloInt vNumVars = numNodes * numNodes;
+
+         // Get the violated cut as an unbounded ray of the worker LP
+
+         cplex.getRay(rayVal, rayVar);
+
+         // Compute the cut from the unbounded ray. The cut is:
+         // sum((i,j) in A) v(k,i,j) * x(i,j) >= u(k,0) - u(k,k)
+
+         for (h = 0; h < vNumVars; ++h)
+            cutCoef[h] = 0.;
+         cutRhs = 0.;
+
+         for (h = 0; h < rayVal.getSize(); ++h) {
+
+            IloInt *index_p = (IloInt*) rayVar[h].getObject();
+            IloInt index = *index_p;
+
+            if ( index >= vNumVars ) {
+               i = index - vNumVars;
+               if ( i == 0 )
+                  cutRhs += rayVal[h];
+               else if ( i == k )
+                  cutRhs -= rayVal[h];
+            }
+            else {
+               cutCoef[index] += rayVal[h];
+            }
          }
+
+         violated = IloTrue;
       }
    }
-   for (k = 1; k < numNodes; ++k) {
-      objExpr += u[(k-1)*numNodes + k];
-      objExpr -= u[(k-1)*numNodes];
+   catch (const IloException&) {
+      return IloFalse;
    }
-   obj.setExpr(objExpr);
-   mod.add(obj);
-   objExpr.end(); 
 
-   // Solve the worker LP
+   return IloTrue;
 
-   cplex.solve();
+} // END CommodityWorker::separate
 
-   // A violated cut is available iff the solution status is Unbounded
 
-   if ( cplex.getStatus() == IloAlgorithm::Unbounded ) {
+WorkerPool::WorkerPool(IloInt numThreads, IloInt maxJobs)
+   : jobs(maxJobs), firstJob(0), numJobs(0), stopped(IloFalse)
+{
+   // The calling threads of solve also solve worker LPs,
+   // so the pool needs one thread less
 
-      IloInt vNumVars = (numNodes-1) * numArcs;
-      IloNumVarArray var(env);
-      IloNumArray val(env);
+   for (IloInt t = 1; t < numThreads; ++t)
+      threads.push_back(thread(&WorkerPool::loop, this));
 
-      // Get the violated cut as an unbounded ray of the worker LP
+} // END WorkerPool::WorkerPool
 
-      cplex.getRay(val, var);
 
-      // Compute the cut from the unbounded ray. The cut is:
-      // sum((i,j) in A) (sum(k in V0) v(k,i,j)) * x(i,j) >=
-      // sum(k in V0) u(k,0) - u(k,k)
+WorkerPool::~WorkerPool()
+{
+   {
+      unique_lock<mutex> guard(lock);
+      stopped = IloTrue;
+   }
+   wake.notify_all();
+   for (size_t t = 0; t < threads.size(); ++t)
+      threads[t].join();
 
-      cutLhs.clear();
-      cutRhs = 0.;
+} // END WorkerPool::~WorkerPool
 
-      for (h = 0; h < val.getSize(); ++h) {
 
-         IloInt *index_p = (IloInt*) var[h].getObject();
-         IloInt index = *index_p;
+IloBool
+WorkerPool::solve(CommodityWorker* const* workers, IloInt numWorkers,
+                  const IloNumArray2 xSol, size_t basisKey)
+{
+   Batch batch;
+   batch.xSol     = xSol;
+   batch.basisKey = basisKey;
+   batch.pending = numWorkers;
+   batch.failed  = IloFalse;
+
+   unique_lock<mutex> guard(lock);
+   for (IloInt h = 0; h < numWorkers; ++h) {
+      Job job = { workers[h], &batch };
+      jobs[(firstJob + numJobs) % jobs.size()] = job;
+      ++numJobs;
+   }
+   wake.notify_all();
 
-         if ( index >= vNumVars ) {
-            index -= vNumVars;
-            k = index / numNodes + 1;
-            i = index - (k-1)*numNodes;
-            if ( i == 0 )
-               cutRhs += val[h];
-            else if ( i == k )
-               cutRhs -= val[h];
-         }
-         else {
-            k = index / numArcs + 1;
-            i = (index - (k-1)*numArcs) / numNodes;
-            j = index - (k-1)*numArcs - i*numNodes;
-            cutLhs += val[h] * x[i][j];
+   // Help the pool until the queue is empty, then wait for
+   // the worker LPs of the batch still being solved
+
+   while ( batch.pending > 0 ) {
+      if ( numJobs > 0 )
+         runJob(guard);
+      else
+         done.wait(guard);
+   }
+
+   return !batch.failed;
+
+} // END WorkerPool::solve
+
+
+// This routine is run by the threads of the pool
+//
+void
+WorkerPool::loop()
+{
+   unique_lock<mutex> guard(lock);
+   for (;;) {
+      while ( numJobs == 0 && !stopped )
+         wake.wait(guard);
+      if ( numJobs == 0 )
+         return;
+      runJob(guard);
+   }
+
+} // END WorkerPool::loop
+
+
+// This routine solves the first worker LP in the queue,
+// with the lock released while solving it
+//
+void
+WorkerPool::runJob(unique_lock<mutex>& guard)
+{
+   Job job = jobs[firstJob];
+   firstJob = (firstJob + 1) % jobs.size();
+   --numJobs;
+
+   guard.unlock();
+   IloBool solved = job.worker->separate(job.batch->xSol,
+                                         job.batch->basisKey);
+   guard.lock();
+
+   if ( !solved )
+      job.batch->failed = IloTrue;
+   if ( --job.batch->pending == 0 )
+      done.notify_all();
+
+} // END WorkerPool::runJob
+
+
+CutPool::CutPool()
+   : cuts(make_shared<SparseCuts>()), numSeparations(0), numHits(0),
+     numCutsReused(0), numCutsAdded(0), numDuplicates(0), numDominated(0),
+     numRemoved(0)
+{
+} // END CutPool::CutPool
+
+
+// This routine computes sum(h) val[h] * x[ind[h]] over the nnz nonzeros
+// of a cut. The four partial sums are independent, so the compiler
+// can vectorize the loop.
+//
+static IloNum
+dot(const int* ind, const IloNum* val, IloInt nnz, const IloNum* x)
+{
+   IloNum sum0 = 0., sum1 = 0., sum2 = 0., sum3 = 0.;
+   IloInt h = 0;
+   for (; h + 4 <= nnz; h += 4) {
+      sum0 += val[h]   * x[ind[h]];
+      sum1 += val[h+1] * x[ind[h+1]];
+      sum2 += val[h+2] * x[ind[h+2]];
+      sum3 += val[h+3] * x[ind[h+3]];
+   }
+   for (; h < nnz; ++h)
+      sum0 += val[h] * x[ind[h]];
+   return (sum0 + sum1) + (sum2 + sum3);
+
+} // END dot
+
+
+// This routine hashes the arcs selected by x (x(i,j) >= 0.5), so that
+// the x solutions of neighbouring nodes often have the same hash
+//
+static size_t
+hashSupport(const vector<IloNum>& xFlat)
+{
+   size_t hash = 14695981039346656037ULL;
+   for (size_t h = 0; h < xFlat.size(); ++h) {
+      if ( xFlat[h] >= 0.5 )
+         hash = (hash ^ h) * 1099511628211ULL;
+   }
+   return hash;
+
+} // END hashSupport
+
+
+IloInt
+CutPool::separate(const vector<IloNum>& xFlat, SparseCuts& violated)
+{
+   IloInt numViolated = 0;
+
+   shared_ptr<const SparseCuts> pool;
+   {
+      unique_lock<mutex> guard(lock);
+      pool = cuts;
+   }
+
+   ++numSeparations;
+   for (IloInt c = 0; c < pool->size(); ++c) {
+      IloInt beg = pool->beg[c];
+      if ( dot(&pool->ind[beg], &pool->val[beg], pool->beg[c+1] - beg,
+               &xFlat[0]) < 1. - 1e-06 ) {
+         violated.add(*pool, c);
+         ++numViolated;
+      }
+   }
+   if ( numViolated > 0 ) {
+      ++numHits;
+      numCutsReused += numViolated;
+   }
+
+   return numViolated;
+
+} // END CutPool::separate
+
+
+void
+CutPool::add(const SparseCuts& newCuts, IloInt c)
+{
+   IloInt h, p;
+
+   // Scale the cut to right-hand side 1. Cuts with right-hand side <= 0
+   // cannot be violated, as x >= 0, and are not kept (nor empty cuts).
+
+   IloNum cutRhs = newCuts.rhs[c];
+   IloInt nnz = newCuts.beg[c+1] - newCuts.beg[c];
+   if ( cutRhs <= 1e-09 || nnz == 0 )
+      return;
+
+   // Only add replaces cuts, and adds are serialized, so the current
+   // version can be read without lock
+
+   unique_lock<mutex> guard(addLock);
+   const SparseCuts& pool = *cuts;
+
+   const int* ind = &newCuts.ind[0] + newCuts.beg[c];
+   scaled.resize(nnz);
+   const IloNum* val = &scaled[0];
+   for (h = 0; h < nnz; ++h)
+      scaled[h] = newCuts.val[newCuts.beg[c] + h] / cutRhs;
+
+   // Reject duplicates and dominated cuts
+
+   for (p = 0; p < pool.size(); ++p) {
+      if ( dominates(pool, p, ind, val, nnz) ) {
+         if ( isDominatedBy(pool, p, ind, val, nnz) )
+            ++numDuplicates;
+         else
+            ++numDominated;
+         return;
+      }
+   }
+
+   // Build the next version: the pool cuts not dominated by the new cut,
+   // and the new cut. Threads still scanning the current version keep it
+   // alive until they are done.
+
+   shared_ptr<SparseCuts> next = make_shared<SparseCuts>();
+   next->beg.reserve(pool.beg.size() + 1);
+   next->ind.reserve(pool.ind.size() + nnz);
+   next->val.reserve(pool.val.size() + nnz);
+   next->rhs.reserve(pool.rhs.size() + 1);
+   for (p = 0; p < pool.size(); ++p) {
+      if ( isDominatedBy(pool, p, ind, val, nnz) )
+         ++numRemoved;
+      else
+         next->add(pool, p);
+   }
+   next->add(ind, val, nnz, 1.);
+   ++numCutsAdded;
+
+   // Publish it
+
+   unique_lock<mutex> publish(lock);
+   cuts = next;
+
+} // END CutPool::add
+
+
+// This routine returns IloTrue if cut p of cuts dominates the cut with
+// the nnz nonzeros ind, val (both with right-hand side 1), i.e., if the
+// coefficients of p are not larger. Nonzeros are sorted by index.
+//
+IloBool
+CutPool::dominates(const SparseCuts& cuts, IloInt p, const int* ind,
+                   const IloNum* val, IloInt nnz)
+{
+   IloInt h = 0;
+   for (IloInt q = cuts.beg[p]; q < cuts.beg[p+1]; ++q) {
+      while ( h < nnz && ind[h] < cuts.ind[q] )
+         ++h;
+      if ( h == nnz || ind[h] != cuts.ind[q] || val[h] < cuts.val[q] - 1e-06 )
+         return IloFalse;
+   }
+   return IloTrue;
+
+} // END CutPool::dominates
+
+
+// This routine returns IloTrue if the cut with the nnz nonzeros ind, val
+// dominates cut p of cuts (both with right-hand side 1).
+//
+IloBool
+CutPool::isDominatedBy(const SparseCuts& cuts, IloInt p, const int* ind,
+                       const IloNum* val, IloInt nnz)
+{
+   IloInt q = cuts.beg[p];
+   for (IloInt h = 0; h < nnz; ++h) {
+      while ( q < cuts.beg[p+1] && cuts.ind[q] < ind[h] )
+         ++q;
+      if ( q == cuts.beg[p+1] || cuts.ind[q] != ind[h] ||
+           cuts.val[q] < val[h] - 1e-06 )
+         return IloFalse;
+   }
+   return IloTrue;
+
+} // END CutPool::isDominatedBy
+
+
+void
+CutPool::printStatistics(ostream& out)
+{
+   unique_lock<mutex> guard(addLock);
+   out << "Cut pool: " << numSeparations << " separations, "
+       << numHits << " answered from the pool";
+   if ( numSeparations > 0 )
+      out << " (" << 100. * numHits / numSeparations << "%)";
+   out << endl;
+   out << "          " << numCutsReused << " cuts reused, "
+       << numCutsAdded << " cuts added, "
+       << numDuplicates << " duplicates and "
+       << numDominated << " dominated cuts rejected, "
+       << numRemoved << " dominated cuts removed" << endl;
+
+} // END CutPool::printStatistics
+
+
+BendersWorker::BendersWorker(IloEnv masterEnv, const Arcs arcs,
+                             IloBool byFlow, WorkerPool* wPool,
+                             CutPool* cPool)
+   : xSol(masterEnv, arcs.getSize()), cutLhs(masterEnv), x(arcs),
+     numNodes(arcs.getSize()), minCut(0), workerPool(wPool),
+     cutPool(cPool), xFlat(numNodes * numNodes),
+     flowCoef(numNodes * numNodes)
+{
+   for (IloInt i = 0; i < numNodes; ++i)
+      xSol[i] = IloNumArray(masterEnv, numNodes);
+
+   if ( byFlow ) {
+      minCut = new (masterEnv) MinCut(masterEnv, numNodes);
+   }
+   else {
+      for (IloInt k = 1; k < numNodes; ++k)
+         commodities.push_back(new CommodityWorker(numNodes, k));
+   }
+
+} // END BendersWorker::BendersWorker
+
+
+BendersWorker::~BendersWorker()
+{
+   for (size_t h = 0; h < commodities.size(); ++h)
+      delete commodities[h];
+
+} // END BendersWorker::~BendersWorker
+
+
+// This routine separates Benders' cuts violated by the current x solution.
+// Violated cuts are looked for in the cut pool first. If there is none,
+// they are found by maximum flow computations or by solving the worker LPs
+// of all the commodities on the thread pool (one cut per commodity whose
+// worker LP is unbounded), and added to the cut pool.
+//
+IloInt
+BendersWorker::separate()
+{
+   IloInt i, j, c, h;
+
+   for (i = 0; i < numNodes; ++i) {
+      for (j = 0; j < numNodes; ++j)
+         xFlat[i*numNodes + j] = xSol[i][j];
+   }
+
+   cuts.clear();
+   if ( cutPool->separate(xFlat, cuts) == 0 ) {
+      if ( minCut != 0 ) {
+         IloNum rhs;
+         if ( separateFlow(xSol, *minCut, flowCoef, rhs) )
+            cuts.add(flowCoef, rhs);
+      }
+      else {
+         if ( !workerPool->solve(&commodities[0], commodities.size(), xSol,
+                                 hashSupport(xFlat)) )
+            return -1;
+         for (h = 0; h < (IloInt) commodities.size(); ++h) {
+            if ( commodities[h]->violated )
+               cuts.add(commodities[h]->cutCoef, commodities[h]->cutRhs);
          }
       }
+      for (c = 0; c < cuts.size(); ++c)
+         cutPool->add(cuts, c);
+   }
+
+   return cuts.size();
+
+} // END BendersWorker::separate
+
+
+void
+BendersWorker::addStatistics(WarmStartStatistics& total) const
+{
+   for (size_t h = 0; h < commodities.size(); ++h)
+      total.add(commodities[h]->stats);
+
+} // END BendersWorker::addStatistics
+
+
+void
+WarmStartStatistics::print(ostream& out) const
+{
+   IloInt numOther = numSolves - numRestored;
+   out << "Worker LPs: " << numSolves << " solves, "
+       << numRestored << " from a cached basis" << endl;
+   if ( numRestored > 0 && numOther > 0 ) {
+      IloNum perRestored = (IloNum) itRestored / numRestored;
+      IloNum perOther    = (IloNum) itOther / numOther;
+      out << "            " << perRestored
+          << " simplex iterations per solve from a cached basis, "
+          << perOther << " otherwise" << endl;
+      out << "            about " << numRestored * (perOther - perRestored)
+          << " simplex iterations saved" << endl;
+   }
 
-      var.end();
-      val.end();
+} // END WarmStartStatistics::print
+
+
+// This routine writes the left-hand side of cut c found by separate
+// to cutLhs, and returns its right-hand side
+//
+IloNum
+BendersWorker::getCut(IloInt c)
+{
+   cutLhs.clear();
+   for (IloInt h = cuts.beg[c]; h < cuts.beg[c+1]; ++h) {
+      IloInt i = cuts.ind[h] / numNodes;
+      IloInt j = cuts.ind[h] % numNodes;
+      cutLhs += cuts.val[h] * x[i][j];
+   }
+   return cuts.rhs[c];
+
+} // END BendersWorker::getCut
+
+
+// This routine separates Benders' cuts violated by the current x solution
+// without the worker LP.
+// For a fixed x, the flow of commodity k can be routed iff the maximum flow
+// from node 0 to node k, with arc capacities x(i,j), is at least 1.
+// Otherwise, the source side S of a minimum cut gives the violated cut
+// sum((i,j) in A : i in S, j not in S) x(i,j) >= 1,
+// that is the cut computed by separate from the unbounded ray
+// u(k,i) = 1 for i in S, u(k,i) = 0 for i not in S,
+// v(k,i,j) = max(u(k,i) - u(k,j), 0) of the worker LP.
+// The most violated cut over all k in V0 is returned, with the coefficient
+// of x(i,j) in cutCoef[i*numNodes + j].
+//
+IloBool
+separateFlow(const IloNumArray2 xSol, MinCut& minCut,
+             vector<IloNum>& cutCoef, IloNum& cutRhs)
+{
+   IloBool violatedCutFound = IloFalse;
+   IloNum minFlow = 1. - 1e-06;
+
+   IloInt numNodes = xSol.getSize();
+   IloInt i, j, k;
+
+   for (k = 1; k < numNodes && minFlow > 0.; ++k) {
+
+      // Commodity k can be routed iff the maximum flow is at least 1
+
+      IloNum flow = minCut.maxFlow(xSol, k);
+      if ( flow >= minFlow )
+         continue;
+      minFlow = flow;
+
+      // Compute the cut from the minimum cut. The cut is:
+      // sum((i,j) in A : i in S, j not in S) x(i,j) >= 1
+
+      cutRhs = 1.;
+      for (i = 0; i < numNodes; ++i) {
+         for (j = 0; j < numNodes; ++j) {
+            cutCoef[i*numNodes + j] = 
+               ( minCut.inSource(i) && !minCut.inSource(j) ? 1. : 0. );
+         }
+      }
 
       violatedCutFound = IloTrue;
    }
 
    return violatedCutFound;
 
-} // END separate
+} // END separateFlow
+
+
+MinCut::MinCut(IloEnv env, IloInt n)
+   : numNodes(n), resid(env, n), excess(env, n), label(env, n),
+     current(env, n), queue(env, n), side(env, n)
+{
+   for (IloInt i = 0; i < numNodes; ++i)
+      resid[i] = IloNumArray(env, numNodes);
+
+} // END MinCut::MinCut
+
+
+IloNum
+MinCut::maxFlow(const IloNumArray2 xSol, IloInt sink)
+{
+   const IloNum eps = 1e-09;
+   IloInt i, j;
+   IloInt head = 0, numActive = 0;
+
+   // Init the preflow: the arcs out of node 0 are saturated,
+   // and the nodes they reach become active
+
+   for (i = 0; i < numNodes; ++i) {
+      for (j = 0; j < numNodes; ++j)
+         resid[i][j] = ( i != j && xSol[i][j] > eps ? xSol[i][j] : 0. );
+      excess[i]  = 0.;
+      label[i]   = 0;
+      current[i] = 0;
+   }
+   label[0] = numNodes;
+   for (j = 1; j < numNodes; ++j) {
+      if ( resid[0][j] > 0. ) {
+         excess[j]   = resid[0][j];
+         resid[j][0] = resid[0][j];
+         resid[0][j] = 0.;
+         if ( j != sink )
+            queue[numActive++] = j;
+      }
+   }
+
+   // Discharge the active nodes one at a time, pushing their excess along
+   // admissible arcs (label[i] == label[j] + 1), and relabeling them
+   // when no admissible arc is left
+
+   while ( numActive > 0 ) {
+      i = queue[head];
+      head = (head + 1) % numNodes;
+      --numActive;
+      while ( excess[i] > eps ) {
+         if ( current[i] == numNodes ) {
+            IloInt minLabel = 2 * numNodes;
+            for (j = 0; j < numNodes; ++j) {
+               if ( resid[i][j] > eps && label[j] < minLabel )
+                  minLabel = label[j];
+            }
+            if ( minLabel == 2 * numNodes ) {
+               excess[i] = 0.;
+               break;
+            }
+            label[i]   = minLabel + 1;
+            current[i] = 0;
+            continue;
+         }
+         j = current[i];
+         if ( resid[i][j] > eps && label[i] == label[j] + 1 ) {
+            IloNum delta = IloMin(excess[i], resid[i][j]);
+            IloBool wasActive = ( excess[j] > eps );
+            resid[i][j] -= delta;
+            resid[j][i] += delta;
+            excess[i]   -= delta;
+            excess[j]   += delta;
+            if ( j != 0 && j != sink && !wasActive && excess[j] > eps ) {
+               queue[(head + numActive) % numNodes] = j;
+               ++numActive;
+            }
+         }
+         else {
+            ++current[i];
+         }
+      }
+   }
+
+   // The nodes that can still reach the sink in the residual graph are
+   // on the sink side of a minimum cut, all the others are in S
+
+   for (i = 0; i < numNodes; ++i)
+      side[i] = 1;
+   side[sink] = 0;
+   queue[0] = sink;
+   IloInt numReached = 1;
+   for (head = 0; head < numReached; ++head) {
+      j = queue[head];
+      for (i = 0; i < numNodes; ++i) {
+         if ( side[i] == 1 && resid[i][j] > eps ) {
+            side[i] = 0;
+            queue[numReached++] = i;
+         }
+      }
+   }
+
+   return excess[sink];
+
+} // END MinCut::maxFlow
 
 
 void usage (char *progname)
 {
-   cerr << "Usage:     " << progname << " {0|1} [filename]"                 << endl;
+   cerr << "Usage:     " << progname << " {0|1} [lp|flow] [filename]"       << endl;
    cerr << " 0:        Benders' cuts only used as lazy constraints,"        << endl;
    cerr << "           to separate integer infeasible solutions."           << endl;
    cerr << " 1:        Benders' cuts also used as user cuts,"               << endl;
    cerr << "           to separate fractional infeasible solutions."        << endl;
+   cerr << " lp:       Benders' cuts separated by solving the worker LP"    << endl;
+   cerr << "           (default)."                                          << endl;
+   cerr << " flow:     Benders' cuts separated by computing maximum flows."  << endl;
    cerr << " filename: ATSP instance file name."                            << endl;
    cerr << "           File ../../../examples/data/atsp.dat "               
         << "used if no name is provided."                                   << endl;
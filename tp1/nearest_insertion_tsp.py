@@ -7,11 +7,9 @@
 
 def cost_calc(cost_matrix, path):
     cost = 0
-    for i in range(len(path)-1):
-        value = cost_matrix[path[i]][path[i+1]]
-        cost += value
-    value = cost_matrix[path[i]][path[i+1]]
-    cost += value
+    for i in range(len(path)):
+        # aresta de path[i-1] para path[i]; com i = 0, a que fecha o ciclo
+        cost += cost_matrix[path[i-1]][path[i]]
     return cost
 
 
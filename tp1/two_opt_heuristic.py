@@ -7,16 +7,36 @@
 
 def _cost_calc(cost_matrix, path):
     cost = 0
-    for i in range(len(path)-1):
-        value = cost_matrix[path[i]][path[i+1]]
+    for i in range(len(path)):
+        # aresta do anterior a path[i]; com i = 0, a que fecha o ciclo
+        value = cost_matrix[path[i-1]][path[i]]
         # Se tiver um caminho que nao existe entao custo eh infinito
         if not value:
             return None
         cost += value
-    value = cost_matrix[path[i]][path[i+1]]
-    cost += value
     return cost
 
+def _swap_delta(cost_matrix, route, lo, hi):
+    """Variacao do custo ao inverter route[lo..hi] no ciclo, ou None se
+    uma das novas arestas nao existe.  Soh as arestas das pontas e as de
+    dentro do trecho (que mudam de sentido) sao somadas."""
+    n = len(route)
+    before, after = route[lo-1], route[(hi+1) % n]
+    old = [(before, route[lo]), (route[hi], after)]
+    new = [(before, route[hi]), (route[lo], after)]
+    for j in range(lo, hi):
+        old.append((route[j], route[j+1]))
+        new.append((route[j+1], route[j]))
+    delta = 0
+    for a, b in new:
+        value = cost_matrix[a][b]
+        if not value:
+            return None
+        delta += value
+    for a, b in old:
+        delta -= cost_matrix[a][b]
+    return delta
+
 def two_opt_swap(route, i, k):
     new_route = route[:i-1]
     r = route[i-1:k]
@@ -27,17 +47,21 @@ def two_opt_swap(route, i, k):
     return new_route
 
 def two_opt_heuristic(cost_matrix, route, max):
+    # o custo eh mantido pela variacao de cada troca, sem somar a rota toda
+    best_distance = _cost_calc(cost_matrix, route)
+    if best_distance == None or len(route) < 4:
+        return route
     improvement = 0
     while improvement < max:
-        best_distance = _cost_calc(cost_matrix, route)
-        for i, k in enumerate(range(1,len(route))):
-            new_route = two_opt_swap(route,i,k)
-            new_distance = _cost_calc(cost_matrix,new_route)
-
-            if new_distance != None and new_distance < best_distance:
-                route = new_route
-                best_distance = new_distance
+        for k in range(2, len(route)):
+            # two_opt_swap(route, k-1, k) inverte route[k-2..k-1]
+            delta = _swap_delta(cost_matrix, route, k-2, k-1)
+            if delta != None and delta < 0:
+                route = two_opt_swap(route, k-1, k)
+                best_distance += delta
                 improvement = 0
 
         improvement+=1
+    # uma soma da rota toda no fim confere o custo mantido pelas variacoes
+    assert best_distance == _cost_calc(cost_matrix, route)
     return route
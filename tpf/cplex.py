@@ -117,8 +117,12 @@ if __name__ == '__main__':
     for items in reader.info.items():
         print '\n', items
 
-        # TODO: DONE! 1. read tsp data
-        # TODO: 2. parse data to cplex format
-        # TODO: 3. solve first time
-        # TODO: 4. do branch and bound while not integer
-        # TODO: 5. do branch and cut while not integer
+    # degree LP, subtour and comb cuts, branching: tpf/native/branch.h,
+    # on CPLEX when the native engine was built with it
+    import native
+    n = len(reader.info['coordinates'])
+    D = native.Solver(n, reader.info['distance_matrix'])
+    backend = native.CPLEX if native.has_backend(native.CPLEX) else native.SIMPLEX
+    tour, z, bound = native.branch_and_cut(n, D, backend)
+    print '\ntour:', tour
+    print 'length:', z, '(optimal)' if z == bound else '(lower bound %d)' % bound
@@ -0,0 +1,416 @@
+"""Bindings to the native TSP engine in tpf/native, loaded through ctypes.
+
+Build the library first:
+    cmake -S native -B native/build && cmake --build native/build
+
+or point TPF_NATIVE_LIB at an existing libtpf.so.  The functions below are
+drop-in replacements for their namesakes in utils.py: they accept the same
+dict distance matrix 'D' (or a Solver built from it once and reused) and
+draw random tours from the 'random' module, so for the same seed they
+return the same tours as the pure Python versions.
+"""
+import ctypes
+import os
+import random
+
+_report_fn = ctypes.CFUNCTYPE(None, ctypes.c_longlong,
+                              ctypes.POINTER(ctypes.c_int), ctypes.c_void_p)
+
+_progress_fn = ctypes.CFUNCTYPE(None, ctypes.c_longlong, ctypes.c_longlong,
+                                ctypes.c_longlong, ctypes.c_double,
+                                ctypes.c_void_p)
+
+
+def _load():
+    here = os.path.dirname(os.path.abspath(__file__))
+    candidates = [os.environ.get("TPF_NATIVE_LIB"),
+                  os.path.join(here, "native", "build", "libtpf.so"),
+                  os.path.join(here, "native", "libtpf.so")]
+    for path in candidates:
+        if path and os.path.exists(path):
+            lib = ctypes.CDLL(path)
+            break
+    else:
+        raise ImportError("libtpf.so not found; build tpf/native first")
+
+    c_int_p = ctypes.POINTER(ctypes.c_int)
+    lib.tpf_solver_new.restype = ctypes.c_void_p
+    lib.tpf_solver_new.argtypes = [ctypes.c_int, c_int_p]
+    lib.tpf_solver_graph.restype = ctypes.c_void_p
+    lib.tpf_solver_graph.argtypes = [ctypes.c_int, ctypes.c_int, c_int_p,
+                                     c_int_p, c_int_p]
+    lib.tpf_solver_read.restype = ctypes.c_void_p
+    lib.tpf_solver_read.argtypes = [ctypes.c_char_p, ctypes.c_int,
+                                    ctypes.c_int]
+    lib.tpf_solver_free.argtypes = [ctypes.c_void_p]
+    lib.tpf_solver_size.restype = ctypes.c_int
+    lib.tpf_solver_size.argtypes = [ctypes.c_void_p]
+    lib.tpf_length.restype = ctypes.c_longlong
+    lib.tpf_length.argtypes = [ctypes.c_void_p, c_int_p]
+    lib.tpf_nearest_neighbor.restype = None
+    lib.tpf_nearest_neighbor.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                         c_int_p]
+    lib.tpf_localsearch.restype = ctypes.c_longlong
+    lib.tpf_localsearch.argtypes = [ctypes.c_void_p, c_int_p,
+                                    ctypes.c_longlong]
+    lib.tpf_optimize.restype = ctypes.c_longlong
+    lib.tpf_optimize.argtypes = [ctypes.c_void_p, c_int_p, ctypes.c_longlong,
+                                 ctypes.c_int]
+    lib.tpf_multistart.restype = ctypes.c_longlong
+    lib.tpf_multistart.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                   ctypes.c_uint, c_int_p]
+    lib.tpf_multistart_parallel.restype = ctypes.c_longlong
+    lib.tpf_multistart_parallel.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_uint, ctypes.c_int,
+        ctypes.c_int, ctypes.c_longlong, _report_fn, ctypes.c_void_p,
+        c_int_p]
+    lib.tpf_population_search.restype = ctypes.c_longlong
+    lib.tpf_population_search.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_uint,
+        ctypes.c_int, ctypes.c_int, ctypes.c_longlong, _report_fn,
+        ctypes.c_void_p, c_int_p]
+    lib.tpf_iterated.restype = ctypes.c_longlong
+    lib.tpf_iterated.argtypes = [ctypes.c_void_p, c_int_p, ctypes.c_longlong,
+                                 ctypes.c_uint, ctypes.c_longlong,
+                                 ctypes.c_double, ctypes.c_int]
+    lib.tpf_initial_tour.restype = ctypes.c_longlong
+    lib.tpf_initial_tour.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                     ctypes.c_uint, c_int_p]
+    lib.tpf_partition_tour.restype = ctypes.c_longlong
+    lib.tpf_partition_tour.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                       ctypes.c_int, ctypes.c_int, c_int_p]
+    lib.tpf_held_karp.restype = ctypes.c_longlong
+    lib.tpf_held_karp.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                  ctypes.POINTER(ctypes.c_double)]
+    lib.tpf_solver_alpha.restype = ctypes.c_int
+    lib.tpf_solver_alpha.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                     ctypes.c_int]
+    lib.tpf_branch_and_cut.restype = ctypes.c_longlong
+    lib.tpf_branch_and_cut.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_longlong, c_int_p,
+        ctypes.POINTER(ctypes.c_longlong)]
+    lib.tpf_lp_backend.restype = ctypes.c_int
+    lib.tpf_lp_backend.argtypes = [ctypes.c_int]
+    lib.tpf_control_new.restype = ctypes.c_void_p
+    lib.tpf_control_new.argtypes = []
+    lib.tpf_control_stop.restype = None
+    lib.tpf_control_stop.argtypes = [ctypes.c_void_p]
+    lib.tpf_control_free.restype = None
+    lib.tpf_control_free.argtypes = [ctypes.c_void_p]
+    lib.tpf_solve.restype = ctypes.c_longlong
+    lib.tpf_solve.argtypes = [
+        ctypes.c_void_p, ctypes.c_double, ctypes.c_longlong, ctypes.c_double,
+        ctypes.c_longlong, ctypes.c_uint, ctypes.c_int, _progress_fn,
+        ctypes.c_void_p, ctypes.c_void_p, c_int_p,
+        ctypes.POINTER(ctypes.c_longlong)]
+    lib.tpf_last_error.restype = ctypes.c_char_p
+    return lib
+
+_lib = _load()
+
+
+class Solver(object):
+    """Native distances plus their sorted neighbour lists.
+
+    Build it once from the dict matrix of mk_matrix(), or from a TSPLIB file
+    with Solver.read (distances are then computed on demand, so large
+    instances need no n x n matrix), and pass it wherever a 'D' is
+    expected.
+
+    Distances may be asymmetric, D[i,j] != D[j,i]; optimize() then only
+    moves segments without reversing them.  Arcs missing from 'D' or set to
+    None, as in the list-of-lists matrices of tp1 (also accepted), are
+    forbidden: the Solver keeps only the others, as a sparse graph, and a
+    tour through a forbidden arc is at least NO_ARC long.
+    """
+    def __init__(self, n, D=None, handle=None):
+        if handle is None and isinstance(D, list):
+            D = dict(((i, j), d) for i, row in enumerate(D)
+                     for j, d in enumerate(row))
+        if handle is None:
+            arcs = [(i, j, d) for (i, j), d in D.items()
+                    if i != j and d is not None]
+            if len(arcs) < n * (n - 1):
+                m = len(arcs)
+                tail, head, cost = [(ctypes.c_int * m)(*column)
+                                    for column in zip(*arcs)] or [None] * 3
+                handle = _lib.tpf_solver_graph(n, m, tail, head, cost)
+            else:
+                flat = (ctypes.c_int * (n * n))()
+                for i, j, d in arcs:
+                    flat[i * n + j] = d
+                handle = _lib.tpf_solver_new(n, flat)
+        if not handle:
+            raise Exception(_lib.tpf_last_error())
+        self.n = n
+        self._handle = handle
+
+    @classmethod
+    def read(cls, filename, cache_rows=0, truncate=False):
+        """Load a TSPLIB file; 'truncate' rounds distances as utils.py."""
+        handle = _lib.tpf_solver_read(filename.encode(), cache_rows,
+                                      int(truncate))
+        if not handle:
+            raise Exception(_lib.tpf_last_error())
+        return cls(_lib.tpf_solver_size(handle), handle=handle)
+
+    def use_alpha(self, k=5, threads=0):
+        """Keep the k alpha-nearest neighbours of each city (see held_karp).
+
+        Uses the penalties of the last held_karp() on this Solver, or
+        computes them.
+        """
+        if _lib.tpf_solver_alpha(self._handle, k, threads) < 0:
+            raise Exception(_lib.tpf_last_error())
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            _lib.tpf_solver_free(self._handle)
+            self._handle = None
+
+
+NO_ARC = 1000000000  # cost of a forbidden arc, TPF_NO_ARC of capi.h
+
+
+def _solver(n, D):
+    if isinstance(D, Solver):
+        return D
+    return Solver(n, D)
+
+
+def _array(tour):
+    return (ctypes.c_int * len(tour))(*tour)
+
+
+def length(tour, D):
+    """Calculate the length of a tour according to distance matrix 'D'."""
+    s = _solver(len(tour), D)
+    return _lib.tpf_length(s._handle, _array(tour))
+
+
+def nearest_neighbor(n, i, D):
+    """Return tour starting from city 'i', using the Nearest Neighbor."""
+    s = _solver(n, D)
+    t = (ctypes.c_int * n)()
+    _lib.tpf_nearest_neighbor(s._handle, i, t)
+    return list(t)
+
+
+def localsearch(tour, z, D, C=None):
+    """Obtain a local optimum starting from solution t; return solution length.
+
+    'tour' is updated in place, as in utils.localsearch; 'C' is ignored,
+    the neighbour lists live in the Solver.
+    """
+    s = _solver(len(tour), D)
+    t = _array(tour)
+    z = _lib.tpf_localsearch(s._handle, t, z)
+    if z < 0:
+        raise Exception(_lib.tpf_last_error())
+    tour[:] = list(t)
+    return z
+
+
+TWO_OPT, OR_OPT, OR2OPT, LIN_KERNIGHAN = 1, 2, 3, 4
+
+
+def optimize(tour, z, D, moves=OR2OPT):
+    """Local search with 2-opt, Or-opt or Lin-Kernighan; return solution length.
+
+    Stronger than localsearch(): Or-opt relocates segments of up to three
+    cities, Lin-Kernighan makes variable-depth sequential moves, and
+    don't-look bits skip cities whose surroundings have not changed.
+    'tour' is updated in place.
+    """
+    s = _solver(len(tour), D)
+    t = _array(tour)
+    z = _lib.tpf_optimize(s._handle, t, z, moves)
+    tour[:] = list(t)
+    return z
+
+
+NEAREST, GREEDY, SPACE_FILLING, FARTHEST, CHEAPEST = 1, 2, 3, 4, 5
+
+
+def initial_tour(n, D, start=GREEDY):
+    """Return a starting tour and its length.
+
+    'start' picks the heuristic: NEAREST (nearest neighbour), GREEDY (greedy
+    edge matching), SPACE_FILLING (Hilbert curve order, needs coordinates),
+    FARTHEST or CHEAPEST insertion.  With a Solver read from a TSPLIB file
+    they use a k-d tree and run in about O(n log n).
+    """
+    s = _solver(n, D)
+    t = (ctypes.c_int * n)()
+    z = _lib.tpf_initial_tour(s._handle, start, random.getrandbits(32), t)
+    if z < 0:
+        raise Exception(_lib.tpf_last_error())
+    return list(t), z
+
+
+def iterated_local_search(tour, z, D, iterations=1000, seconds=0,
+                          moves=OR2OPT):
+    """Iterated local search; return solution length.
+
+    Brings 'tour' to a local optimum with optimize(), then repeatedly kicks
+    it with a double bridge on short segments, re-optimises around the
+    kick and keeps the result unless it is longer.  Stops after
+    'iterations' kicks or 'seconds' of wall-clock time (0: no limit).  The
+    kicks are seeded from the random module.  'tour' is updated in place.
+    """
+    s = _solver(len(tour), D)
+    t = _array(tour)
+    z = _lib.tpf_iterated(s._handle, t, z, random.getrandbits(32),
+                          iterations, seconds, moves)
+    if z < 0:
+        raise Exception(_lib.tpf_last_error())
+    tour[:] = list(t)
+    return z
+
+
+def partition_tour(D, cell_size=2000, moves=LIN_KERNIGHAN, threads=0):
+    """Tour a large coordinate instance by decomposition; return (tour, z).
+
+    'D' is a Solver read from a TSPLIB file.  Its cities are split into
+    k-d cells of at most 'cell_size' cities, which are toured in parallel
+    on 'threads' threads (0: one per hardware thread) with 'moves', joined
+    into one tour and optimised along the cell boundaries.
+    """
+    t = (ctypes.c_int * D.n)()
+    z = _lib.tpf_partition_tour(D._handle, cell_size, moves, threads, t)
+    if z < 0:
+        raise Exception(_lib.tpf_last_error())
+    return list(t), z
+
+
+def held_karp(n, D, iterations=0):
+    """Held-Karp lower bound on the length of any tour.
+
+    Subgradient ascent on the node penalties of minimum 1-trees, for up to
+    'iterations' steps (0 for the default).  Returns the bound and the
+    penalties.
+    """
+    s = _solver(n, D)
+    pi = (ctypes.c_double * n)()
+    bound = _lib.tpf_held_karp(s._handle, iterations, pi)
+    if bound < 0:
+        raise Exception(_lib.tpf_last_error())
+    return bound, list(pi)
+
+
+SIMPLEX, CPLEX = 0, 1
+
+
+def has_backend(backend):
+    """Whether the native engine was built with LP backend 'backend'."""
+    return bool(_lib.tpf_lp_backend(backend))
+
+
+def branch_and_cut(n, D, backend=SIMPLEX, max_nodes=0):
+    """Solve exactly by branch-and-cut on the LP 'backend'.
+
+    Subtour and comb inequalities are separated on the degree LP and
+    fractional edges are branched on, up to 'max_nodes' nodes (0 for no
+    limit).  Returns the best tour, its length and a lower bound on every
+    tour, equal to the length when the tour is proven optimal.
+    """
+    s = _solver(n, D)
+    t = (ctypes.c_int * n)()
+    bound = ctypes.c_longlong()
+    z = _lib.tpf_branch_and_cut(s._handle, backend, max_nodes, t,
+                                ctypes.byref(bound))
+    if z < 0:
+        raise Exception(_lib.tpf_last_error())
+    return list(t), z, bound.value
+
+
+class Control(object):
+    """Stops a running solve() from another thread; see solve()."""
+    def __init__(self):
+        self._handle = _lib.tpf_control_new()
+
+    def stop(self):
+        _lib.tpf_control_stop(self._handle)
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            _lib.tpf_control_free(self._handle)
+            self._handle = None
+
+
+def solve(n, D, seconds=0, iterations=0, gap=None, bound=None, report=None,
+          control=None, moves=LIN_KERNIGHAN | OR2OPT):
+    """Anytime solver; return (tour, z, bound).
+
+    Improves a greedy tour by iterated local search until 'seconds' of
+    wall-clock time, 'iterations' kicks, a tour within 'gap' (e.g. 0.01) of
+    'bound' or of the Held-Karp bound computed alongside, or
+    control.stop() from another thread, whichever comes first.  report(z,
+    bound, iterations, seconds) is called with each new incumbent; the
+    bound returned is the one known at the end, or None.
+    """
+    s = _solver(n, D)
+    def hook(z, low, it, sec, data):
+        report(z, None if low < 0 else low, it, sec)
+    t = (ctypes.c_int * n)()
+    low = ctypes.c_longlong(-1)
+    z = _lib.tpf_solve(s._handle, seconds, iterations,
+                       -1 if gap is None else gap,
+                       -1 if bound is None else bound,
+                       random.getrandbits(32), moves,
+                       _progress_fn(hook) if report else _progress_fn(),
+                       None, control._handle if control else None, t,
+                       ctypes.byref(low))
+    if z < 0:
+        raise Exception(_lib.tpf_last_error())
+    return list(t), z, None if low.value < 0 else low.value
+
+
+def multistart_localsearch(k, n, D, report=None, threads=None, moves=0,
+                           target=None, population=0):
+    """Do k iterations of local search, starting from random solutions.
+
+    With 'threads' (0 for one per core) the restarts run in parallel in the
+    native engine, using optimize() with 'moves' or localsearch() if moves
+    is 0.  Their random tours are seeded from the random module, so results
+    still follow random.seed() and do not depend on the number of threads;
+    report is called in restart order.  The restarts stop once a tour of
+    length 'target' or less is found, e.g. within a gap of held_karp().
+    With 'population', the best that many distinct tours of the restarts
+    are recombined by partition crossover until no better tour comes out
+    (threads defaults to 0 then).
+
+    Returns best solution and its cost.
+    """
+    s = _solver(n, D)
+    if threads is not None or population:
+        def hook(z, tour, data):
+            report(z, tour[:n])
+        best = (ctypes.c_int * n)()
+        args = (random.getrandbits(32), threads or 0, moves,
+                -1 if target is None else target,
+                _report_fn(hook) if report else _report_fn(), None, best)
+        if population:
+            z = _lib.tpf_population_search(s._handle, k, population, *args)
+        else:
+            z = _lib.tpf_multistart_parallel(s._handle, k, *args)
+        if z < 0:
+            raise Exception(_lib.tpf_last_error())
+        return list(best), z
+    bestt = None
+    bestz = None
+    for i in range(0, k):
+        tour = list(range(n))
+        random.shuffle(tour)
+        t = _array(tour)
+        z = _lib.tpf_localsearch(s._handle, t, _lib.tpf_length(s._handle, t))
+        if z < 0:
+            raise Exception(_lib.tpf_last_error())
+        if bestz is None or z < bestz:
+            bestz = z
+            bestt = list(t)
+            if report:
+                report(z, bestt)
+            if target is not None and z <= target:
+                break
+    return bestt, bestz
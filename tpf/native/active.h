@@ -0,0 +1,67 @@
+#ifndef TPF_ACTIVE_H
+#define TPF_ACTIVE_H
+
+#include <vector>
+
+namespace tpf {
+
+// FIFO queue of the cities local search still has to look at, with one
+// don't-look bit per city so that a city is queued at most once.  Moves
+// push the endpoints of the edges they change; a search pops cities until
+// the queue is empty, so its work follows the changes instead of n.
+class ActiveQueue {
+public:
+    explicit ActiveQueue(int n = 0)
+        : n_(n), head_(0), size_(0), ring_(n), queued_(n, 0)
+    {
+    }
+
+    int capacity() const { return n_; }
+    bool empty() const { return size_ == 0; }
+    int size() const { return size_; }
+    bool queued(int c) const { return queued_[c] != 0; }
+
+    void push(int c)
+    {
+        if (queued_[c])
+            return;
+        queued_[c] = 1;
+        int k = head_ + size_;
+        ring_[k >= n_ ? k - n_ : k] = c;
+        ++size_;
+    }
+
+    // Queue every city, in index order.
+    void push_all()
+    {
+        for (int c = 0; c < n_; ++c)
+            push(c);
+    }
+
+    int pop()
+    {
+        int c = ring_[head_];
+        if (++head_ == n_)
+            head_ = 0;
+        --size_;
+        queued_[c] = 0;
+        return c;
+    }
+
+    void clear()
+    {
+        while (size_ > 0)
+            pop();
+    }
+
+private:
+    int n_;
+    int head_;
+    int size_;
+    std::vector<int> ring_;
+    std::vector<char> queued_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,429 @@
+// Benchmarks of the native engine.
+//
+//     tsp_bench [-o results.jsonl] [-n max_cities] [-c config,...]
+//               [-l label] [-j threads] [-B]
+//
+// Every configuration runs on every instance: the files of tpf/data, then
+// random uniform (E) and clustered (C) instances in the style of the
+// DIMACS challenge, of 1k, 10k, 100k and 1M cities up to -n (default 1M).
+// Configurations are the starting tours (nn, greedy, hilbert, farthest,
+// cheapest), greedy followed by optimize() with 2opt, oropt, or2opt or lk,
+// iterated Lin-Kernighan (ils, min(n, 1000) kicks from greedy) and the
+// k-d decomposition (partition, cells of 2000 cities, -j threads).  All
+// searches use 10 quadrant neighbours.
+//
+// Each run is a child process of its own, which builds the instance and
+// its neighbour lists (setup), then times the configuration alone; its
+// peak RSS is that of the whole child.  Lengths are compared with the
+// known optimum of TSPLIB instances, otherwise with the Held-Karp bound
+// (1000 subgradient steps up to 10k cities, 100 beyond, where it is an
+// estimate); -B skips the bounds.  One JSON object per run is appended to
+// the -o file, labelled with -l (e.g. a commit id), and a table is printed.
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bound.h"
+#include "construct.h"
+#include "counters.h"
+#include "ils.h"
+#include "localsearch.h"
+#include "moves.h"
+#include "partition.h"
+#include "tsplib.h"
+
+namespace {
+
+struct Instance {
+    std::string name;
+    std::string path;  // empty for generated instances
+    char kind;         // 'E' uniform or 'C' clustered when generated
+    int n;
+};
+
+struct Known {
+    const char* name;
+    long long optimum;
+};
+
+const Known optima[] = {
+    {"burma14", 3323},       {"berlin52", 7542},    {"a280", 2579},
+    {"pcb442", 50778},       {"att532", 27686},     {"rat783", 8806},
+    {"pr1002", 259045},      {"pr2392", 378032},    {"pcb3038", 137694},
+    {"fnl4461", 182566},     {"usa13509", 19982859},
+    {"pla85900", 142382641},
+};
+
+const char* const configs[] = {"nn",     "greedy", "hilbert", "farthest",
+                               "cheapest", "2opt", "oropt",  "or2opt",
+                               "lk",     "ils",    "partition"};
+
+const int bench_neighbors = 10;
+const int bench_cell_size = 2000;
+
+// Uniform: integer coordinates in [0, 1e6).  Clustered: n/10 centres
+// placed so, cities normally distributed around a random centre with
+// deviation 1e6 / sqrt(n).
+tpf::Problem generate(char kind, int n)
+{
+    tpf::Problem p;
+    p.name = std::string(1, kind) + std::to_string(n);
+    p.n = n;
+    p.type = tpf::EUC_2D;
+    p.x.resize(n);
+    p.y.resize(n);
+    std::mt19937 rng(static_cast<unsigned>(n) * 2 + (kind == 'C'));
+    std::uniform_int_distribution<int> side(0, 999999);
+    if (kind == 'E') {
+        for (int i = 0; i < n; ++i) {
+            p.x[i] = side(rng);
+            p.y[i] = side(rng);
+        }
+        return p;
+    }
+    int m = std::max(1, n / 10);
+    std::vector<double> cx(m), cy(m);
+    for (int c = 0; c < m; ++c) {
+        cx[c] = side(rng);
+        cy[c] = side(rng);
+    }
+    std::uniform_int_distribution<int> centre(0, m - 1);
+    std::normal_distribution<double> offset(0, 1e6 / std::sqrt(double(n)));
+    for (int i = 0; i < n; ++i) {
+        int c = centre(rng);
+        p.x[i] = std::floor(cx[c] + offset(rng));
+        p.y[i] = std::floor(cy[c] + offset(rng));
+    }
+    return p;
+}
+
+tpf::Problem load(const Instance& in)
+{
+    if (in.path.empty())
+        return generate(in.kind, in.n);
+    return tpf::read_tsplib(in.path);
+}
+
+double now()
+{
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+tpf::Tour run(const std::string& config, const tpf::Oracle& D,
+              const tpf::Neighbors& C, int threads)
+{
+    const char* starts[] = {"nn", "greedy", "hilbert", "farthest",
+                            "cheapest"};
+    std::mt19937 rng(1);
+    for (int s = 0; s < 5; ++s)
+        if (config == starts[s])
+            return tpf::initial_tour(tpf::Start(tpf::NEAREST_START + s), D, C,
+                                     rng);
+    if (config == "partition")
+        return tpf::partition_tour(D, C, bench_cell_size,
+                                   tpf::LIN_KERNIGHAN, threads);
+
+    tpf::Tour tour = tpf::greedy_tour(D, C);
+    long long z = tpf::length(tour, D);
+    if (config == "ils") {
+        long long kicks = std::min(D.size(), 1000);
+        tpf::iterated_local_search(tour, z, D, C, rng, kicks, 0,
+                                   tpf::LIN_KERNIGHAN | tpf::OR2OPT);
+        return tour;
+    }
+    int moves = config == "2opt"     ? tpf::TWO_OPT
+                : config == "oropt"  ? tpf::OR_OPT
+                : config == "or2opt" ? tpf::OR2OPT
+                                     : tpf::LIN_KERNIGHAN;
+    tpf::optimize(tour, z, D, C, moves);
+    return tour;
+}
+
+long peak_rss_kb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Run 'job' in a child process and return the line it printed, or an
+// "error ..." line.
+template <class Job>
+std::string in_child(const Job& job)
+{
+    std::fflush(0);
+    int fd[2];
+    if (pipe(fd) != 0)
+        return "error pipe failed";
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fd[0]);
+        close(fd[1]);
+        return "error fork failed";
+    }
+    if (pid == 0) {
+        close(fd[0]);
+        std::string line;
+        int code = 0;
+        try {
+            line = job();
+        } catch (const std::exception& e) {
+            line = std::string("error ") + e.what();
+            code = 1;
+        }
+        ssize_t written = write(fd[1], line.data(), line.size());
+        (void)written;
+        close(fd[1]);
+        _exit(code);
+    }
+    close(fd[1]);
+    std::string line;
+    char buf[256];
+    ssize_t got;
+    while ((got = read(fd[0], buf, sizeof buf)) > 0)
+        line.append(buf, got);
+    close(fd[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (line.empty())
+        line = WIFSIGNALED(status) ? "error killed by signal "
+                                         + std::to_string(WTERMSIG(status))
+                                   : "error no result";
+    return line;
+}
+
+std::string measure(const Instance& in, const std::string& config,
+                    int threads)
+{
+    double t0 = now();
+    tpf::Problem p = load(in);
+    tpf::Oracle D(p);
+    tpf::Neighbors C = tpf::mk_neighbors(D, bench_neighbors, true);
+    tpf::SearchCounters& counters = tpf::search_counters();
+    long long evaluated = counters.evaluated, applied = counters.applied;
+    double t1 = now();
+    tpf::Tour tour = run(config, D, C, threads);
+    double t2 = now();
+    char line[256];
+    std::snprintf(line, sizeof line, "%lld %.6f %.6f %lld %lld %ld",
+                  tpf::length(tour, D), t2 - t1, t1 - t0,
+                  counters.evaluated - evaluated, counters.applied - applied,
+                  peak_rss_kb());
+    return line;
+}
+
+std::string bound(const Instance& in)
+{
+    tpf::Problem p = load(in);
+    tpf::Oracle D(p);
+    tpf::Neighbors C = tpf::mk_neighbors(D, bench_neighbors, true);
+    tpf::HeldKarp hk =
+        tpf::held_karp(D, C, -1, p.n <= 10000 ? 0 : 100);
+    char line[64];
+    std::snprintf(line, sizeof line, "%lld %d", hk.bound, hk.exact ? 1 : 0);
+    return line;
+}
+
+std::string quoted(const std::string& s)
+{
+    std::string q = "\"";
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '"' || s[i] == '\\')
+            q += '\\';
+        q += s[i];
+    }
+    return q + "\"";
+}
+
+std::vector<Instance> instances(int max_cities)
+{
+    std::vector<Instance> all;
+    std::string dir = TPF_DATA_DIR;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            std::string file = e->d_name;
+            if (file.size() > 4 && file.substr(file.size() - 4) == ".tsp") {
+                Instance in;
+                in.name = file.substr(0, file.size() - 4);
+                in.path = dir + "/" + file;
+                in.kind = 0;
+                in.n = 0;
+                all.push_back(in);
+            }
+        }
+        closedir(d);
+    }
+    std::sort(all.begin(), all.end(),
+              [](const Instance& a, const Instance& b) {
+                  return a.name < b.name;
+              });
+    const char* sizes[] = {"1k", "10k", "100k", "1M"};
+    int n = 1000;
+    for (int s = 0; s < 4 && n <= max_cities; ++s, n *= 10)
+        for (int k = 0; k < 2; ++k) {
+            Instance in;
+            in.kind = k == 0 ? 'E' : 'C';
+            in.name = std::string(1, in.kind) + sizes[s];
+            in.n = n;
+            all.push_back(in);
+        }
+    return all;
+}
+
+void usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "usage: %s [-o results.jsonl] [-n max_cities] "
+                 "[-c config,...] [-l label] [-j threads] [-B]\n",
+                 prog);
+    std::exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const char* output = 0;
+    std::string label;
+    int max_cities = 1000000, threads = 0;
+    bool bounds = true;
+    std::vector<std::string> chosen(configs, configs + sizeof configs
+                                                           / sizeof *configs);
+    int opt;
+    while ((opt = getopt(argc, argv, "o:n:c:l:j:B")) != -1) {
+        switch (opt) {
+        case 'o': output = optarg; break;
+        case 'n': max_cities = std::atoi(optarg); break;
+        case 'l': label = optarg; break;
+        case 'j': threads = std::atoi(optarg); break;
+        case 'B': bounds = false; break;
+        case 'c': {
+            chosen.clear();
+            std::string list = optarg;
+            for (size_t pos = 0; pos <= list.size();) {
+                size_t end = std::min(list.find(',', pos), list.size());
+                std::string c = list.substr(pos, end - pos);
+                if (std::find(configs, configs + sizeof configs
+                                                     / sizeof *configs,
+                              c) == configs + sizeof configs
+                                                  / sizeof *configs)
+                    usage(argv[0]);
+                chosen.push_back(c);
+                pos = end + 1;
+            }
+            break;
+        }
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc)
+        usage(argv[0]);
+
+    FILE* out = 0;
+    if (output && !(out = std::fopen(output, "a"))) {
+        std::perror(output);
+        return 1;
+    }
+    std::printf("%-10s %8s %-10s %10s %10s %12s %14s %8s\n", "instance", "n",
+                "config", "seconds", "rss_kb", "moves/s", "z", "gap");
+
+    std::vector<Instance> all = instances(max_cities);
+    for (size_t i = 0; i < all.size(); ++i) {
+        Instance& in = all[i];
+        if (in.n == 0)
+            in.n = tpf::read_tsplib(in.path).n;
+        if (in.n > max_cities)
+            continue;
+        long long reference = -1;
+        std::string kind = "none";
+        for (size_t k = 0; k < sizeof optima / sizeof *optima; ++k)
+            if (in.name == optima[k].name) {
+                reference = optima[k].optimum;
+                kind = "optimum";
+            }
+        if (reference < 0 && bounds) {
+            std::string line = in_child([&in] { return bound(in); });
+            int exact = 0;
+            if (std::sscanf(line.c_str(), "%lld %d", &reference, &exact)
+                == 2)
+                kind = exact ? "held-karp" : "held-karp-estimate";
+            else
+                reference = -1;
+        }
+
+        for (size_t c = 0; c < chosen.size(); ++c) {
+            const std::string& config = chosen[c];
+            std::string line = in_child(
+                [&] { return measure(in, config, threads); });
+            long long z = 0, evaluated = 0, applied = 0;
+            double seconds = 0, setup = 0;
+            long rss = 0;
+            if (std::sscanf(line.c_str(), "%lld %lf %lf %lld %lld %ld", &z,
+                            &seconds, &setup, &evaluated, &applied, &rss)
+                != 6) {
+                std::printf("%-10s %8d %-10s %s\n", in.name.c_str(), in.n,
+                            config.c_str(), line.c_str());
+                if (out)
+                    std::fprintf(out,
+                                 "{\"label\": %s, \"instance\": %s, "
+                                 "\"n\": %d, \"config\": %s, "
+                                 "\"error\": %s}\n",
+                                 quoted(label).c_str(),
+                                 quoted(in.name).c_str(), in.n,
+                                 quoted(config).c_str(),
+                                 quoted(line.substr(6)).c_str());
+                continue;
+            }
+            double rate = seconds > 0 ? evaluated / seconds : 0;
+            double gap = reference > 0 ? double(z - reference) / reference
+                                       : -1;
+            std::printf("%-10s %8d %-10s %10.3f %10ld %12.0f %14lld ",
+                        in.name.c_str(), in.n, config.c_str(), seconds, rss,
+                        rate, z);
+            if (reference > 0)
+                std::printf("%8.4f\n", gap);
+            else
+                std::printf("%8s\n", "-");
+            if (out) {
+                std::fprintf(
+                    out,
+                    "{\"label\": %s, \"time\": %ld, \"instance\": %s, "
+                    "\"n\": %d, \"config\": %s, \"threads\": %d, "
+                    "\"seconds\": %.6f, \"setup_seconds\": %.6f, "
+                    "\"peak_rss_kb\": %ld, \"moves_evaluated\": %lld, "
+                    "\"moves_applied\": %lld, \"moves_per_second\": %.0f, "
+                    "\"z\": %lld, \"reference\": %lld, "
+                    "\"reference_kind\": %s, \"gap\": ",
+                    quoted(label).c_str(), static_cast<long>(std::time(0)),
+                    quoted(in.name).c_str(), in.n, quoted(config).c_str(),
+                    threads, seconds, setup, rss, evaluated, applied, rate,
+                    z, reference, quoted(kind).c_str());
+                if (reference > 0)
+                    std::fprintf(out, "%.6f}\n", gap);
+                else
+                    std::fprintf(out, "null}\n");
+                std::fflush(out);
+            }
+            std::fflush(stdout);
+        }
+    }
+    if (out)
+        std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,371 @@
+#include "bound.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "construct.h"
+#include "moves.h"
+#include "pool.h"
+
+namespace tpf {
+
+namespace {
+
+// The first k entries of each list of C.
+Neighbors truncate(const Neighbors& C, int k)
+{
+    int n = static_cast<int>(C.first.size()) - 1;
+    Neighbors T;
+    T.first.resize(n + 1);
+    for (int i = 0; i < n; ++i) {
+        T.first[i] = static_cast<int>(T.city.size());
+        int end = std::min(C.end(i), C.begin(i) + k);
+        T.city.insert(T.city.end(), C.city.begin() + C.begin(i),
+                      C.city.begin() + end);
+        T.dist.insert(T.dist.end(), C.dist.begin() + C.begin(i),
+                      C.dist.begin() + end);
+    }
+    T.first[n] = static_cast<int>(T.city.size());
+    return T;
+}
+
+// Minimum 1-trees under penalties pi.  The tree over cities 1..n-1 is
+// rooted at city 1; 'order' lists the cities as Prim reached them, so
+// parents come first.
+struct OneTree {
+    std::vector<int> parent;
+    std::vector<double> weight;  // of the edge to the parent
+    std::vector<int> order;
+    std::vector<int> degree;
+    int a, b;                    // the two neighbours of city 0
+    double length;               // sum of the weights, without penalties
+
+    // Shortest 1-tree on the edges of G, with the distances from city 0
+    // to every city in d0.  Cities G leaves apart are joined to the tree
+    // by their nearest city in it.
+    void sparse(const Oracle& D, const Neighbors& G,
+                const std::vector<int>& d0, const std::vector<double>& pi)
+    {
+        int n = D.size();
+        reset(n);
+        std::vector<double> key(n, std::numeric_limits<double>::infinity());
+        std::vector<char> in(n, 0);
+        in[0] = 1;
+        typedef std::pair<double, int> Item;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item> >
+            heap;
+        int scan = 1;
+        key[1] = 0;
+        heap.push(Item(0, 1));
+        for (int m = 1; m < n;) {
+            int v;
+            if (heap.empty()) {
+                while (in[scan])
+                    ++scan;
+                v = scan;
+                for (int u = 1; u < n; ++u)
+                    if (in[u]) {
+                        double w = D(v, u) + pi[v] + pi[u];
+                        if (w < key[v]) {
+                            key[v] = w;
+                            parent[v] = u;
+                        }
+                    }
+            } else {
+                v = heap.top().second;
+                double k = heap.top().first;
+                heap.pop();
+                if (in[v] || k != key[v])
+                    continue;
+            }
+            add(v, key[v]);
+            in[v] = 1;
+            ++m;
+            for (int k = G.begin(v); k < G.end(v); ++k) {
+                int u = G.city[k];
+                double w = G.dist[k] + pi[v] + pi[u];
+                if (!in[u] && w < key[u]) {
+                    key[u] = w;
+                    parent[u] = v;
+                    heap.push(Item(w, u));
+                }
+            }
+        }
+        close(d0, pi);
+    }
+
+    // Shortest 1-tree on all edges, by O(n^2) Prim.
+    void dense(const Oracle& D, const std::vector<int>& d0,
+               const std::vector<double>& pi)
+    {
+        int n = D.size();
+        reset(n);
+        std::vector<double> key(n, std::numeric_limits<double>::infinity());
+        std::vector<char> in(n, 0);
+        std::vector<int> row(n);
+        in[0] = 1;
+        key[1] = 0;
+        for (int m = 1; m < n; ++m) {
+            int v = -1;
+            for (int u = 1; u < n; ++u)
+                if (!in[u] && (v < 0 || key[u] < key[v]))
+                    v = u;
+            add(v, key[v]);
+            in[v] = 1;
+            D.distances(v, row.data());
+            for (int u = 1; u < n; ++u) {
+                double w = row[u] + pi[v] + pi[u];
+                if (!in[u] && w < key[u]) {
+                    key[u] = w;
+                    parent[u] = v;
+                }
+            }
+        }
+        close(d0, pi);
+    }
+
+    // 1-tree length less 2 * sum(pi).
+    double value(const std::vector<double>& pi) const
+    {
+        double s = 0;
+        for (size_t i = 0; i < pi.size(); ++i)
+            s += pi[i];
+        return length - 2 * s;
+    }
+
+private:
+    void reset(int n)
+    {
+        parent.assign(n, -1);
+        weight.assign(n, 0);
+        degree.assign(n, 0);
+        order.clear();
+        order.reserve(n);
+        length = 0;
+    }
+
+    void add(int v, double w)
+    {
+        order.push_back(v);
+        if (parent[v] < 0)
+            return;
+        weight[v] = w;
+        length += w;
+        ++degree[v];
+        ++degree[parent[v]];
+    }
+
+    void close(const std::vector<int>& d0, const std::vector<double>& pi)
+    {
+        int n = static_cast<int>(d0.size());
+        a = b = -1;
+        double wa = 0, wb = 0;
+        for (int j = 1; j < n; ++j) {
+            double w = d0[j] + pi[0] + pi[j];
+            if (a < 0 || w < wa) {
+                b = a;
+                wb = wa;
+                a = j;
+                wa = w;
+            } else if (b < 0 || w < wb) {
+                b = j;
+                wb = w;
+            }
+        }
+        length += wa + wb;
+        degree[0] = 2;
+        ++degree[a];
+        ++degree[b];
+    }
+};
+
+long long upper_bound(const Oracle& D, const Neighbors& C)
+{
+    Tour tour = greedy_tour(D, C);
+    return optimize(tour, length(tour, D), D, C);
+}
+
+long long round_up(double value)
+{
+    return static_cast<long long>(std::ceil(value - 1e-6));
+}
+
+}  // namespace
+
+HeldKarp held_karp(const Oracle& D, const Neighbors& C, long long upper,
+                   int iterations, const Control* control)
+{
+    if (!D.symmetric())
+        throw std::runtime_error("held_karp needs symmetric distances");
+    int n = D.size();
+    HeldKarp hk;
+    hk.pi.assign(n, 0);
+    hk.iterations = 0;
+    hk.exact = hk.tour = true;
+    if (n < 3) {
+        hk.value = n == 2 ? 2.0 * D(0, 1) : 0;
+        hk.bound = round_up(hk.value);
+        return hk;
+    }
+    if (iterations <= 0)
+        iterations = held_karp_iterations;
+    if (upper < 0)
+        upper = upper_bound(D, C);
+
+    Neighbors G = mk_symmetric(truncate(C, held_karp_candidates));
+    std::vector<int> d0(n);
+    D.distances(0, d0.data());
+
+    OneTree tree;
+    std::vector<double> pi(n, 0);
+    double best = -std::numeric_limits<double>::infinity();
+    double lambda = 2;
+    int stale = 0;
+    while (hk.iterations < iterations && !(control && control->stopped())) {
+        ++hk.iterations;
+        tree.sparse(D, G, d0, pi);
+        double value = tree.value(pi);
+        if (value > best + 1e-9) {
+            best = value;
+            hk.pi = pi;
+            stale = 0;
+        } else if (++stale >= held_karp_patience) {
+            lambda /= 2;
+            stale = 0;
+            pi = hk.pi;
+            if (lambda < 1e-6)
+                break;
+            continue;
+        }
+        double norm = 0;
+        for (int i = 0; i < n; ++i)
+            norm += (tree.degree[i] - 2) * (tree.degree[i] - 2);
+        if (norm == 0 || value >= upper)
+            break;
+        double step = lambda * (upper - value) / norm;
+        for (int i = 0; i < n; ++i)
+            pi[i] += step * (tree.degree[i] - 2);
+    }
+
+    hk.exact = n <= held_karp_dense_limit
+               && !(control && control->stopped());
+    if (hk.exact) {
+        tree.dense(D, d0, hk.pi);
+        hk.value = tree.value(hk.pi);
+        hk.tour = true;
+        for (int i = 0; i < n && hk.tour; ++i)
+            hk.tour = tree.degree[i] == 2;
+    } else {
+        hk.value = best;
+        hk.tour = false;
+    }
+    hk.bound = round_up(hk.value);
+    return hk;
+}
+
+Neighbors alpha_neighbors(const Oracle& D, const Neighbors& C,
+                          const HeldKarp& hk, int k, int threads)
+{
+    int n = D.size();
+    if (n < 3 || k <= 0)
+        return C;
+    const std::vector<double>& pi = hk.pi;
+    std::vector<int> d0(n);
+    D.distances(0, d0.data());
+    OneTree tree;
+    tree.sparse(D, mk_symmetric(truncate(C, held_karp_candidates)), d0, pi);
+
+    // up[l][v]: ancestor 2^l levels above v, top[l][v]: heaviest edge on
+    // the way there
+    int levels = 1;
+    while ((1 << levels) < n)
+        ++levels;
+    std::vector<std::vector<int> > up(levels, std::vector<int>(n, 1));
+    std::vector<std::vector<double> > top(levels, std::vector<double>(n, 0));
+    std::vector<int> depth(n, 0);
+    for (size_t m = 0; m < tree.order.size(); ++m) {
+        int v = tree.order[m];
+        if (tree.parent[v] < 0)
+            continue;
+        depth[v] = depth[tree.parent[v]] + 1;
+        up[0][v] = tree.parent[v];
+        top[0][v] = tree.weight[v];
+        for (int l = 1; l < levels; ++l) {
+            int u = up[l - 1][v];
+            up[l][v] = up[l - 1][u];
+            top[l][v] = std::max(top[l - 1][v], top[l - 1][u]);
+        }
+    }
+    // the heaviest edge on the tree path between u and v
+    auto path_max = [&](int u, int v) {
+        double w = 0;
+        if (depth[u] < depth[v])
+            std::swap(u, v);
+        for (int l = levels - 1; l >= 0; --l)
+            if (depth[u] - (1 << l) >= depth[v]) {
+                w = std::max(w, top[l][u]);
+                u = up[l][u];
+            }
+        if (u == v)
+            return w;
+        for (int l = levels - 1; l >= 0; --l)
+            if (up[l][u] != up[l][v]) {
+                w = std::max(w, std::max(top[l][u], top[l][v]));
+                u = up[l][u];
+                v = up[l][v];
+            }
+        return std::max(w, std::max(top[0][u], top[0][v]));
+    };
+    double second = d0[tree.b] + pi[0] + pi[tree.b];
+    auto alpha = [&](int i, int j, int d) {
+        double w = d + pi[i] + pi[j];
+        if (i == 0 || j == 0) {
+            int o = i + j;
+            return o == tree.a || o == tree.b ? 0.0 : w - second;
+        }
+        return w - path_max(i, j);
+    };
+
+    Neighbors A;
+    A.first.resize(n + 1);
+    for (int i = 0; i < n; ++i)
+        A.first[i + 1] = A.first[i] + std::min(k, C.end(i) - C.begin(i));
+    A.city.resize(A.first[n]);
+    A.dist.resize(A.first[n]);
+
+    const int block = 1024;
+    ThreadPool pool(threads);
+    std::vector<std::vector<std::pair<double, int> > > scratch(pool.size());
+    std::vector<std::vector<int> > kept(pool.size());
+    for (int lo = 0; lo < n; lo += block) {
+        pool.submit([&, lo](int w) {
+            std::vector<std::pair<double, int> >& cand = scratch[w];
+            for (int i = lo; i < std::min(n, lo + block); ++i) {
+                cand.clear();
+                for (int e = C.begin(i); e < C.end(i); ++e)
+                    cand.push_back(
+                        std::make_pair(alpha(i, C.city[e], C.dist[e]), e));
+                // by alpha, then by position in C (distance)
+                int m = A.end(i) - A.begin(i);
+                std::partial_sort(cand.begin(), cand.begin() + m, cand.end());
+                std::vector<int>& keep = kept[w];
+                keep.resize(m);
+                for (int q = 0; q < m; ++q)
+                    keep[q] = cand[q].second;
+                std::sort(keep.begin(), keep.end());
+                for (int q = 0; q < m; ++q) {
+                    A.city[A.begin(i) + q] = C.city[keep[q]];
+                    A.dist[A.begin(i) + q] = C.dist[keep[q]];
+                }
+            }
+        });
+    }
+    pool.wait();
+    return A;
+}
+
+}  // namespace tpf
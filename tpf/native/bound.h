@@ -0,0 +1,67 @@
+#ifndef TPF_BOUND_H
+#define TPF_BOUND_H
+
+#include <cmath>
+#include <vector>
+
+#include "control.h"
+#include "neighbors.h"
+#include "oracle.h"
+
+namespace tpf {
+
+// Held-Karp lower bound on the length of a symmetric tour.
+//
+// A 1-tree is a spanning tree of cities 1..n-1 plus two edges at city 0;
+// every tour is one, so the shortest 1-tree under weights
+// D(i,j) + pi[i] + pi[j], less 2 * sum(pi), bounds every tour from below.
+// The node penalties pi are tuned by subgradient ascent: pi[i] grows with
+// the degree of i in the tree beyond 2, with Polyak steps
+// lambda * (upper - value) / |g|^2 and lambda halved whenever 'patience'
+// iterations bring no improvement.
+//
+// The ascent builds its 1-trees with Prim and a binary heap on the first
+// held_karp_candidates entries of each list of C, made symmetric.  Up to
+// held_karp_dense_limit cities the final 1-tree is then taken over all
+// edges (O(n^2)), which makes 'bound' a proven lower bound; beyond that it
+// is the sparse value, a close estimate that can be slightly above the
+// true bound.
+struct HeldKarp {
+    double value;           // length of the best 1-tree less 2 * sum(pi)
+    long long bound;        // value rounded up to an integer
+    std::vector<double> pi; // penalties giving 'value'
+    bool exact;             // the final 1-tree was taken over all edges
+    bool tour;              // ... and it is a tour, hence an optimal one
+    int iterations;         // subgradient iterations done
+};
+
+// 'upper' is the length of a known tour (-1 to build one with greedy and
+// 2-opt + Or-opt); 'iterations' caps the ascent (0 for the default).  A
+// 'control' that stops ends the ascent after the current iteration and
+// skips the dense 1-tree, leaving the sparse estimate.
+HeldKarp held_karp(const Oracle& D, const Neighbors& C, long long upper = -1,
+                   int iterations = 0, const Control* control = 0);
+
+// Alpha-nearness candidates: the k cities j of each list of C with the
+// lowest alpha(i,j), the increase in length of the best 1-tree (under
+// hk.pi) forced to contain edge (i,j).  Alpha is computed from the maximum
+// edge on the tree path between i and j, with binary lifting, the cities
+// split over a pool of 'threads' threads (0 for one per hardware thread).
+// The lists are returned sorted by distance, as every consumer expects.
+Neighbors alpha_neighbors(const Oracle& D, const Neighbors& C,
+                          const HeldKarp& hk, int k, int threads = 0);
+
+// Longest tour within 'gap' (e.g. 0.01 for 1%) of a lower bound.
+inline long long gap_target(long long bound, double gap)
+{
+    return static_cast<long long>(std::floor(bound * (1 + gap)));
+}
+
+const int held_karp_iterations = 1000;
+const int held_karp_patience = 20;
+const int held_karp_candidates = 10;
+const int held_karp_dense_limit = 20000;
+
+}  // namespace tpf
+
+#endif
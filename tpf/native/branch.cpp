@@ -0,0 +1,447 @@
+#include "branch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "construct.h"
+#include "cuts.h"
+#include "ils.h"
+#include "moves.h"
+
+namespace tpf {
+
+namespace {
+
+const double eps = 1e-6;
+const int root_rounds = 200;  // cutting rounds per node
+const int node_rounds = 20;
+const int stall_rounds = 5;   // rounds without progress before branching
+
+struct Node {
+    double bound;
+    int depth;
+    std::vector<std::pair<int, int> > fix;  // (column, value)
+
+    // best bound first, deepest first among equals
+    bool operator<(const Node& o) const
+    {
+        return bound > o.bound || (bound == o.bound && depth < o.depth);
+    }
+};
+
+class Cutter {
+public:
+    Cutter(const Oracle& D, LpBackend backend, const Report& report)
+        : D_(D), n_(D.size()), lp_(mk_lp(backend)), report_(report),
+          adj_(n_), grow_(branch_columns), added_(0), feasible_(false)
+    {
+        for (int i = 0; i < n_; ++i)
+            lp_->add_row(std::vector<int>(), std::vector<double>(),
+                         Lp::EQUAL, 2);
+    }
+
+    void start(const Tour& tour, long long z, const Neighbors& C)
+    {
+        offer(tour, z);
+        for (int i = 0; i < n_; ++i) {
+            add_edge(tour[i], tour[(i + 1) % n_]);
+            int end = std::min(C.end(i), C.begin(i) + branch_columns);
+            for (int k = C.begin(i); k < end; ++k)
+                add_edge(i, C.city[k]);
+        }
+    }
+
+    BranchAndCut run(long long max_nodes)
+    {
+        BranchAndCut result;
+        result.nodes = 0;
+        result.cuts = 0;
+        std::priority_queue<Node> open;
+        Node root;
+        root.bound = -std::numeric_limits<double>::infinity();
+        root.depth = 0;
+        open.push(root);
+        while (!open.empty()) {
+            Node node = open.top();
+            if (prunable(node.bound)) {
+                open.pop();
+                continue;
+            }
+            if (max_nodes > 0 && result.nodes >= max_nodes)
+                break;
+            open.pop();
+            ++result.nodes;
+            apply(node.fix);
+            double bound;
+            int col = process(node.depth == 0, bound);
+            if (feasible_)
+                purge();
+            if (col < 0)
+                continue;
+            for (int v = 1; v >= 0; --v) {
+                Node child;
+                child.bound = bound;
+                child.depth = node.depth + 1;
+                child.fix = node.fix;
+                child.fix.push_back(std::make_pair(col, v));
+                open.push(child);
+            }
+        }
+        result.tour = best_;
+        result.z = upper_;
+        result.bound = upper_;
+        if (!open.empty())
+            result.bound = std::min(
+                upper_, static_cast<long long>(std::ceil(open.top().bound
+                                                         - eps)));
+        result.optimal = result.bound == upper_;
+        result.cuts = added_;
+        result.columns = lp_->columns();
+        return result;
+    }
+
+private:
+    bool prunable(double bound) const
+    {
+        return std::ceil(bound - eps) >= upper_;
+    }
+
+    void offer(const Tour& tour, long long z)
+    {
+        if (!best_.empty() && z >= upper_)
+            return;
+        best_ = tour;
+        upper_ = z;
+        if (report_)
+            report_(z, tour);
+    }
+
+    static long long key(int u, int v)
+    {
+        return static_cast<long long>(std::min(u, v)) << 32 | std::max(u, v);
+    }
+
+    void add_edge(int u, int v)
+    {
+        if (u == v || column_.count(key(u, v)))
+            return;
+        std::vector<int> rows;
+        std::vector<double> coefs;
+        rows.push_back(u);
+        rows.push_back(v);
+        coefs.push_back(1);
+        coefs.push_back(1);
+        for (size_t c = 0; c < cuts_.size(); ++c) {
+            int k = 0;
+            for (size_t s = 0; s < cuts_[c].sets.size(); ++s) {
+                const std::vector<int>& S = cuts_[c].sets[s];
+                k += std::binary_search(S.begin(), S.end(), u) &&
+                     std::binary_search(S.begin(), S.end(), v);
+            }
+            if (k) {
+                rows.push_back(n_ + static_cast<int>(c));
+                coefs.push_back(k);
+            }
+        }
+        int col = lp_->add_column(D_(u, v), 0, 1, rows, coefs);
+        column_[key(u, v)] = col;
+        eu_.push_back(u);
+        ev_.push_back(v);
+        adj_[u].push_back(std::make_pair(v, col));
+        adj_[v].push_back(std::make_pair(u, col));
+    }
+
+    void add_cut(const Cut& cut)
+    {
+        std::vector<char> in(n_, 0);
+        std::unordered_map<int, double> coef;
+        for (size_t s = 0; s < cut.sets.size(); ++s) {
+            const std::vector<int>& S = cut.sets[s];
+            for (size_t k = 0; k < S.size(); ++k)
+                in[S[k]] = 1;
+            for (size_t k = 0; k < S.size(); ++k) {
+                int u = S[k];
+                for (size_t e = 0; e < adj_[u].size(); ++e)
+                    if (adj_[u][e].first > u && in[adj_[u][e].first])
+                        coef[adj_[u][e].second] += 1;
+            }
+            for (size_t k = 0; k < S.size(); ++k)
+                in[S[k]] = 0;
+        }
+        std::vector<int> cols;
+        std::vector<double> coefs;
+        for (std::unordered_map<int, double>::const_iterator it =
+                 coef.begin();
+             it != coef.end(); ++it) {
+            cols.push_back(it->first);
+            coefs.push_back(it->second);
+        }
+        lp_->add_row(cols, coefs, Lp::LESS, cut.rhs);
+        cuts_.push_back(cut);
+        ++added_;
+    }
+
+    void apply(const std::vector<std::pair<int, int> >& fix)
+    {
+        for (size_t k = 0; k < fixed_.size(); ++k)
+            lp_->set_bounds(fixed_[k], 0, 1);
+        fixed_.clear();
+        for (size_t k = 0; k < fix.size(); ++k) {
+            lp_->set_bounds(fix[k].first, fix[k].second, fix[k].second);
+            fixed_.push_back(fix[k].first);
+        }
+    }
+
+    Support support(const std::vector<double>& x) const
+    {
+        Support s;
+        s.n = n_;
+        for (size_t e = 0; e < x.size(); ++e)
+            if (x[e] > eps) {
+                s.a.push_back(eu_[e]);
+                s.b.push_back(ev_[e]);
+                s.x.push_back(x[e]);
+            }
+        return s;
+    }
+
+    // Solve the node; returns the column to branch on, or -1 if the node
+    // is done, with its lower bound in 'bound'.
+    int process(bool root, double& bound)
+    {
+        int rounds = 0, stalled = 0;
+        double last = -std::numeric_limits<double>::infinity();
+        bound = last;
+        std::vector<double> x, y;
+        for (;;) {
+            feasible_ = lp_->solve() == Lp::OPTIMAL;
+            if (!feasible_) {
+                if (grow())
+                    continue;
+                return -1;
+            }
+            double z = lp_->objective();
+            lp_->primal(x);
+            bool integral = true;
+            for (size_t e = 0; e < x.size() && integral; ++e)
+                integral = x[e] < eps || x[e] > 1 - eps;
+            if (prunable(z))
+                stalled = stall_rounds;  // no use cutting; price to prune
+            else if (z > last + eps * std::max(1.0, std::fabs(z)))
+                stalled = 0;
+            else
+                ++stalled;
+            last = z;
+
+            Support s = support(x);
+            std::vector<Cut> found;
+            if (!subtour_cuts(s, found) && !integral)
+                comb_cuts(s, found);
+            bool cut = integral || (stalled < stall_rounds &&
+                                    rounds < (root ? root_rounds
+                                                   : node_rounds));
+            if (!found.empty() && cut) {
+                for (size_t c = 0; c < found.size(); ++c)
+                    add_cut(found[c]);
+                ++rounds;
+                continue;
+            }
+
+            lp_->duals(y);
+            std::vector<std::pair<double, long long> > priced;
+            bound = std::max(bound, z + price(y, priced));
+            if (prunable(bound))
+                return -1;
+            if (!priced.empty()) {
+                for (size_t k = 0; k < priced.size(); ++k)
+                    add_edge(static_cast<int>(priced[k].second >> 32),
+                             static_cast<int>(priced[k].second
+                                              & 0xffffffff));
+                continue;
+            }
+            if (integral && found.empty()) {
+                Tour t = tour(x);
+                offer(t, length(t, D_));
+                return -1;
+            }
+            return branch(x);
+        }
+    }
+
+    // Sum of the negative reduced costs of the edges out of the LP; the
+    // most negative ones are put in 'priced' (reduced cost, key).
+    double price(const std::vector<double>& y,
+                 std::vector<std::pair<double, long long> >& priced)
+    {
+        // memberships of the cities in the sets of the cuts with a dual
+        std::vector<std::vector<std::pair<int, int> > > member(n_);
+        for (size_t c = 0; c < cuts_.size(); ++c) {
+            if (y[n_ + c] == 0)
+                continue;
+            for (size_t s = 0; s < cuts_[c].sets.size(); ++s) {
+                const std::vector<int>& S = cuts_[c].sets[s];
+                for (size_t k = 0; k < S.size(); ++k)
+                    member[S[k]].push_back(std::make_pair(
+                        static_cast<int>(c), static_cast<int>(s)));
+            }
+        }
+        std::vector<double> acc(n_, 0);
+        std::vector<char> in_lp(n_, 0);
+        std::vector<int> row(n_);
+        double sum = 0;
+        for (int u = 0; u < n_; ++u) {
+            for (size_t m = 0; m < member[u].size(); ++m) {
+                const Cut& cut = cuts_[member[u][m].first];
+                const std::vector<int>& S = cut.sets[member[u][m].second];
+                double yc = y[n_ + member[u][m].first];
+                for (size_t k = 0; k < S.size(); ++k)
+                    acc[S[k]] += yc;
+            }
+            for (size_t e = 0; e < adj_[u].size(); ++e)
+                in_lp[adj_[u][e].first] = 1;
+            D_.distances(u, row.data());
+            for (int v = u + 1; v < n_; ++v) {
+                double rc = row[v] - y[u] - y[v] - acc[v];
+                if (!in_lp[v] && rc < -eps) {
+                    sum += rc;
+                    priced.push_back(std::make_pair(rc, key(u, v)));
+                }
+            }
+            for (size_t e = 0; e < adj_[u].size(); ++e)
+                in_lp[adj_[u][e].first] = 0;
+            for (size_t m = 0; m < member[u].size(); ++m) {
+                const Cut& cut = cuts_[member[u][m].first];
+                const std::vector<int>& S = cut.sets[member[u][m].second];
+                for (size_t k = 0; k < S.size(); ++k)
+                    acc[S[k]] = 0;
+            }
+        }
+        size_t keep = std::min(priced.size(), static_cast<size_t>(n_));
+        std::partial_sort(priced.begin(), priced.begin() + keep,
+                          priced.end());
+        priced.resize(keep);
+        return sum;
+    }
+
+    // Widen the LP to the grow_ nearest cities of each; false if it has
+    // every edge already.
+    bool grow()
+    {
+        if (grow_ >= n_ - 1)
+            return false;
+        grow_ = std::min(2 * grow_, n_ - 1);
+        Neighbors C = mk_closest(D_, grow_);
+        for (int i = 0; i < n_; ++i)
+            for (int k = C.begin(i); k < C.end(i); ++k)
+                add_edge(i, C.city[k]);
+        return true;
+    }
+
+    int branch(const std::vector<double>& x) const
+    {
+        int col = -1;
+        double best = 0;
+        for (size_t e = 0; e < x.size(); ++e) {
+            double f = std::min(x[e], 1 - x[e]);
+            if (f > eps && (col < 0 || f > best + eps ||
+                            (f > best - eps &&
+                             D_(eu_[e], ev_[e]) > D_(eu_[col], ev_[col])))) {
+                col = static_cast<int>(e);
+                best = f;
+            }
+        }
+        return col;
+    }
+
+    Tour tour(const std::vector<double>& x) const
+    {
+        std::vector<int> next(2 * n_, -1);
+        for (size_t e = 0; e < x.size(); ++e)
+            if (x[e] > 0.5) {
+                int u = eu_[e], v = ev_[e];
+                next[2 * u + (next[2 * u] >= 0)] = v;
+                next[2 * v + (next[2 * v] >= 0)] = u;
+            }
+        Tour t;
+        t.reserve(n_);
+        int prev = -1, c = 0;
+        do {
+            t.push_back(c);
+            int d = next[2 * c] != prev ? next[2 * c] : next[2 * c + 1];
+            prev = c;
+            c = d;
+        } while (c != 0);
+        return t;
+    }
+
+    // Drop the cuts left slack by the last solution.
+    void purge()
+    {
+        std::vector<double> x;
+        lp_->primal(x);
+        Support s = support(x);
+        std::vector<int> drop;
+        std::vector<Cut> kept;
+        for (size_t c = 0; c < cuts_.size(); ++c) {
+            if (cut_lhs(cuts_[c], s) < cuts_[c].rhs - 1e-3)
+                drop.push_back(n_ + static_cast<int>(c));
+            else
+                kept.push_back(cuts_[c]);
+        }
+        if (drop.empty())
+            return;
+        lp_->delete_rows(drop);
+        cuts_.swap(kept);
+    }
+
+    const Oracle& D_;
+    int n_;
+    std::unique_ptr<Lp> lp_;
+    Report report_;
+    Tour best_;
+    long long upper_;
+    std::unordered_map<long long, int> column_;
+    std::vector<int> eu_, ev_;                            // per column
+    std::vector<std::vector<std::pair<int, int> > > adj_;  // (city, column)
+    std::vector<Cut> cuts_;                               // row n_ + k
+    std::vector<int> fixed_;
+    int grow_, added_;
+    bool feasible_;  // the last LP had a solution
+};
+
+}  // namespace
+
+BranchAndCut branch_and_cut(const Oracle& D, const Neighbors& C,
+                            LpBackend backend, long long max_nodes,
+                            const Report& report)
+{
+    if (!D.symmetric())
+        throw std::runtime_error("branch_and_cut needs symmetric distances");
+    int n = D.size();
+    Tour tour = greedy_tour(D, C);
+    long long z = length(tour, D);
+    if (n < 4) {
+        BranchAndCut result;
+        result.tour = tour;
+        result.z = result.bound = z;
+        result.optimal = true;
+        result.nodes = 0;
+        result.cuts = result.columns = 0;
+        if (report)
+            report(z, tour);
+        return result;
+    }
+    std::mt19937 rng(1);
+    z = iterated_local_search(tour, z, D, C, rng, std::max(1000, 10 * n), 0,
+                              LIN_KERNIGHAN | OR2OPT);
+    Cutter cutter(D, backend, report);
+    cutter.start(tour, z, C);
+    return cutter.run(max_nodes);
+}
+
+}  // namespace tpf
@@ -0,0 +1,45 @@
+#ifndef TPF_BRANCH_H
+#define TPF_BRANCH_H
+
+#include "localsearch.h"
+#include "lp.h"
+
+namespace tpf {
+
+struct BranchAndCut {
+    Tour tour;         // best tour found
+    long long z;       // its length
+    long long bound;   // proven lower bound on every tour
+    bool optimal;      // z == bound
+    long long nodes;   // branch-and-bound nodes solved
+    int cuts;          // inequalities added
+    int columns;       // edges in the LP at the end
+};
+
+// Exact branch-and-cut for the symmetric TSP.
+//
+// The LP starts from the degree constraints x(delta(i)) = 2 on the first
+// branch_columns candidate edges of each city and the edges of a tour
+// found by iterated Lin-Kernighan, whose length is the first upper bound.
+// Each node separates subtour constraints exactly and blossoms
+// heuristically (cuts.h) until none are violated or the LP stalls; then
+// every edge left out is priced with the duals.  The Lagrangian value
+// objective + sum of the negative reduced costs bounds the node, and prunes
+// it when no shorter tour can lie below; otherwise the edges with negative
+// reduced cost join the LP.  A fully priced, integral solution is a tour;
+// a fractional one is split on its most fractional edge.  Open nodes are
+// taken best bound first.  Cuts are global and those left slack are
+// dropped between nodes.
+//
+// 'max_nodes' limits the search (0: none), in which case the result may
+// not be optimal; 'report' is called with each new best tour.
+BranchAndCut branch_and_cut(const Oracle& D, const Neighbors& C,
+                            LpBackend backend = SIMPLEX_LP,
+                            long long max_nodes = 0,
+                            const Report& report = Report());
+
+const int branch_columns = 10;
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,325 @@
+#include "capi.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+#include "bound.h"
+#include "branch.h"
+#include "construct.h"
+#include "crossover.h"
+#include "ils.h"
+#include "localsearch.h"
+#include "moves.h"
+#include "partition.h"
+#include "solve.h"
+#include "tsplib.h"
+
+struct tpf_control {
+    tpf::Control control;
+};
+
+struct tpf_solver {
+    tpf::Oracle D;
+    tpf::Neighbors C;
+    tpf::HeldKarp hk;  // pi is empty until computed
+};
+
+namespace {
+
+std::string last_error;
+
+static_assert(TPF_NO_ARC == tpf::no_arc, "capi.h and graph.h disagree");
+
+tpf_solver* make_solver(const tpf::Oracle& D)
+{
+    tpf_solver* s = new tpf_solver;
+    s->D = D;
+    s->C = tpf::mk_neighbors(s->D, tpf::default_neighbors(D.size()));
+    return s;
+}
+
+}  // namespace
+
+extern "C" {
+
+tpf_solver* tpf_solver_new(int n, const int* d)
+{
+    try {
+        tpf::Matrix D(n);
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j)
+                D.at(i, j) = d[static_cast<size_t>(i) * n + j];
+        return make_solver(tpf::Oracle(D));
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return 0;
+    }
+}
+
+tpf_solver* tpf_solver_graph(int n, int m, const int* tail, const int* head,
+                             const int* cost)
+{
+    try {
+        return make_solver(tpf::Oracle(tpf::Graph(n, m, tail, head, cost)));
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return 0;
+    }
+}
+
+tpf_solver* tpf_solver_read(const char* filename, int cache_rows,
+                            int truncate)
+{
+    try {
+        tpf::Problem p = tpf::read_tsplib(
+            filename, truncate ? tpf::TRUNCATE : tpf::NINT);
+        return make_solver(tpf::Oracle(p, cache_rows));
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return 0;
+    }
+}
+
+void tpf_solver_free(tpf_solver* s)
+{
+    delete s;
+}
+
+int tpf_solver_size(const tpf_solver* s)
+{
+    return s->D.size();
+}
+
+long long tpf_length(const tpf_solver* s, const int* tour)
+{
+    tpf::Tour t(tour, tour + s->D.size());
+    return tpf::length(t, s->D);
+}
+
+void tpf_nearest_neighbor(const tpf_solver* s, int i, int* tour)
+{
+    tpf::Tour t = tpf::nearest_neighbor(i, s->D);
+    std::copy(t.begin(), t.end(), tour);
+}
+
+long long tpf_localsearch(const tpf_solver* s, int* tour, long long z)
+{
+    try {
+        tpf::Tour t(tour, tour + s->D.size());
+        z = tpf::localsearch(t, z, s->D, s->C);
+        std::copy(t.begin(), t.end(), tour);
+        return z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_optimize(const tpf_solver* s, int* tour, long long z,
+                       int moves)
+{
+    tpf::Tour t(tour, tour + s->D.size());
+    z = tpf::optimize(t, z, s->D, s->C, moves);
+    std::copy(t.begin(), t.end(), tour);
+    return z;
+}
+
+long long tpf_multistart(const tpf_solver* s, int k, unsigned seed, int* best)
+{
+    try {
+        std::mt19937 rng(seed);
+        tpf::Solution sol = tpf::multistart_localsearch(k, s->D, s->C, rng);
+        std::copy(sol.tour.begin(), sol.tour.end(), best);
+        return sol.z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_multistart_parallel(const tpf_solver* s, int k, unsigned seed,
+                                  int threads, int moves, long long target,
+                                  tpf_report report, void* data, int* best)
+{
+    try {
+        tpf::Report hook;
+        if (report)
+            hook = [report, data](long long z, const tpf::Tour& tour) {
+                report(z, tour.data(), data);
+            };
+        tpf::Solution sol = tpf::multistart_localsearch(
+            k, s->D, s->C, seed, threads, hook, moves, target);
+        std::copy(sol.tour.begin(), sol.tour.end(), best);
+        return sol.z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_population_search(const tpf_solver* s, int k, int population,
+                                unsigned seed, int threads, int moves,
+                                long long target, tpf_report report,
+                                void* data, int* best)
+{
+    try {
+        tpf::Report hook;
+        if (report)
+            hook = [report, data](long long z, const tpf::Tour& tour) {
+                report(z, tour.data(), data);
+            };
+        tpf::Solution sol = tpf::population_search(
+            k, population, s->D, s->C, seed, threads, hook, moves, target);
+        std::copy(sol.tour.begin(), sol.tour.end(), best);
+        return sol.z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_iterated(const tpf_solver* s, int* tour, long long z,
+                       unsigned seed, long long iterations, double seconds,
+                       int moves)
+{
+    try {
+        int n = s->D.size();
+        tpf::Tour t(tour, tour + n);
+        std::mt19937 rng(seed);
+        z = tpf::iterated_local_search(t, z, s->D, s->C, rng, iterations,
+                                       seconds, moves);
+        std::copy(t.begin(), t.end(), tour);
+        return z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_initial_tour(const tpf_solver* s, int start, unsigned seed,
+                           int* tour)
+{
+    try {
+        std::mt19937 rng(seed);
+        tpf::Tour t = tpf::initial_tour(tpf::Start(start), s->D, s->C, rng);
+        std::copy(t.begin(), t.end(), tour);
+        return tpf::length(t, s->D);
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_partition_tour(const tpf_solver* s, int cell_size, int moves,
+                             int threads, int* tour)
+{
+    try {
+        tpf::Tour t = tpf::partition_tour(s->D, s->C, cell_size, moves,
+                                          threads);
+        std::copy(t.begin(), t.end(), tour);
+        return tpf::length(t, s->D);
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_held_karp(tpf_solver* s, int iterations, double* pi)
+{
+    try {
+        s->hk = tpf::held_karp(s->D, s->C, -1, iterations);
+        if (pi)
+            std::copy(s->hk.pi.begin(), s->hk.pi.end(), pi);
+        return s->hk.bound;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+int tpf_solver_alpha(tpf_solver* s, int k, int threads)
+{
+    try {
+        if (s->hk.pi.empty())
+            s->hk = tpf::held_karp(s->D, s->C);
+        s->C = tpf::alpha_neighbors(s->D, s->C, s->hk, k, threads);
+        return 0;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+long long tpf_branch_and_cut(const tpf_solver* s, int backend,
+                             long long max_nodes, int* tour,
+                             long long* bound)
+{
+    try {
+        tpf::BranchAndCut bc = tpf::branch_and_cut(
+            s->D, s->C, tpf::LpBackend(backend), max_nodes);
+        std::copy(bc.tour.begin(), bc.tour.end(), tour);
+        *bound = bc.bound;
+        return bc.z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+int tpf_lp_backend(int backend)
+{
+    return tpf::lp_backend_built(tpf::LpBackend(backend));
+}
+
+tpf_control* tpf_control_new(void)
+{
+    return new tpf_control;
+}
+
+void tpf_control_stop(tpf_control* c)
+{
+    c->control.stop();
+}
+
+void tpf_control_free(tpf_control* c)
+{
+    delete c;
+}
+
+long long tpf_solve(const tpf_solver* s, double seconds,
+                    long long iterations, double gap, long long bound,
+                    unsigned seed, int moves, tpf_progress progress,
+                    void* data, tpf_control* control, int* tour,
+                    long long* bound_out)
+{
+    try {
+        tpf::Budget budget;
+        budget.seconds = seconds;
+        budget.iterations = iterations;
+        budget.gap = gap;
+        budget.bound = bound;
+        tpf::Listener listener;
+        if (progress)
+            listener = [progress, data](const tpf::Progress& p) {
+                progress(p.z, p.bound, p.iterations, p.seconds, data);
+            };
+        tpf::Outcome out = tpf::solve(s->D, s->C, budget, listener,
+                                      control ? &control->control : 0, seed,
+                                      moves);
+        std::copy(out.tour.begin(), out.tour.end(), tour);
+        if (bound_out)
+            *bound_out = out.bound;
+        return out.z;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return -1;
+    }
+}
+
+const char* tpf_last_error(void)
+{
+    return last_error.c_str();
+}
+
+}  // extern "C"
@@ -0,0 +1,159 @@
+/* C interface to the native engine, used by tpf/native.py through ctypes.
+ *
+ * Functions that can fail return NULL or a negative value and leave a
+ * message for tpf_last_error().
+ */
+#ifndef TPF_CAPI_H
+#define TPF_CAPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tpf_solver tpf_solver;
+
+/* Build a solver from a row-major n x n distance matrix. */
+tpf_solver* tpf_solver_new(int n, const int* d);
+
+/* Build a solver from a sparse directed graph: arc k goes from tail[k] to
+ * head[k] at cost[k], k < m, and every other arc is forbidden (it costs
+ * TPF_NO_ARC).  Costs may be asymmetric; optimize() then moves segments
+ * without reversing them. */
+#define TPF_NO_ARC 1000000000
+tpf_solver* tpf_solver_graph(int n, int m, const int* tail, const int* head,
+                             const int* cost);
+
+/* Build a solver from a TSPLIB file; distances are computed on demand,
+ * keeping up to 'cache_rows' rows of them in an LRU cache.  Distances are
+ * rounded to the nearest integer as TSPLIB says, or truncated as utils.py
+ * does if 'truncate' is non-zero. */
+tpf_solver* tpf_solver_read(const char* filename, int cache_rows,
+                            int truncate);
+
+void tpf_solver_free(tpf_solver* s);
+
+int tpf_solver_size(const tpf_solver* s);
+
+long long tpf_length(const tpf_solver* s, const int* tour);
+
+/* Nearest neighbour tour starting from city i, written to 'tour'. */
+void tpf_nearest_neighbor(const tpf_solver* s, int i, int* tour);
+
+/* 2-opt local search on 'tour' (in place) of length 'z'; returns the
+ * length of the local optimum. */
+long long tpf_localsearch(const tpf_solver* s, int* tour, long long z);
+
+/* Local search with don't-look bits using the given moves (1: 2-opt,
+ * 2: Or-opt, 3: both, 4: Lin-Kernighan); returns the length of the local
+ * optimum. */
+long long tpf_optimize(const tpf_solver* s, int* tour, long long z,
+                       int moves);
+
+/* k random restarts of tpf_localsearch; the best tour is written to 'best'
+ * and its length returned. */
+long long tpf_multistart(const tpf_solver* s, int k, unsigned seed,
+                         int* best);
+
+/* Called with the length and tour of each new best solution. */
+typedef void (*tpf_report)(long long z, const int* tour, void* data);
+
+/* k restarts of tpf_optimize with the given moves (0: tpf_localsearch)
+ * spread over 'threads' threads (0: one per hardware thread).  Restart i
+ * starts from a random tour seeded by (seed, i), so the result does not
+ * depend on the number of threads.  'report', if not NULL, is called from
+ * the calling thread, in restart order.  The restarts stop once a tour of
+ * length 'target' or less is found (-1: never).  The best tour is written
+ * to 'best' and its length returned, or -1 on error. */
+long long tpf_multistart_parallel(const tpf_solver* s, int k, unsigned seed,
+                                  int threads, int moves, long long target,
+                                  tpf_report report, void* data, int* best);
+
+/* As tpf_multistart_parallel, but the best 'population' distinct tours
+ * of the restarts are then recombined by partition crossover, each child
+ * re-optimised around the edges its parents do not share, until a
+ * generation finds no better tour.  'report' is called with the best
+ * restart and each better child. */
+long long tpf_population_search(const tpf_solver* s, int k, int population,
+                                unsigned seed, int threads, int moves,
+                                long long target, tpf_report report,
+                                void* data, int* best);
+
+/* Iterated local search on 'tour' (in place) of length 'z' with the given
+ * moves, for up to 'iterations' double-bridge kicks or 'seconds' of
+ * wall-clock time (0: no limit, but one must be set); returns the final
+ * length, or -1 on error. */
+long long tpf_iterated(const tpf_solver* s, int* tour, long long z,
+                       unsigned seed, long long iterations, double seconds,
+                       int moves);
+
+/* Starting tour written to 'tour': 0 random (from 'seed'), 1 nearest
+ * neighbour, 2 greedy edge, 3 Hilbert curve, 4 farthest insertion,
+ * 5 cheapest insertion.  Returns its length, or -1 on error. */
+long long tpf_initial_tour(const tpf_solver* s, int start, unsigned seed,
+                           int* tour);
+
+/* Tour of a coordinate instance by decomposition: k-d cells of at most
+ * 'cell_size' cities are toured in parallel on 'threads' threads (0: one
+ * per hardware thread) with the given moves, joined, and optimised along
+ * their boundaries.  The tour is written to 'tour'; returns its length, or
+ * -1 on error. */
+long long tpf_partition_tour(const tpf_solver* s, int cell_size, int moves,
+                             int threads, int* tour);
+
+/* Held-Karp lower bound with up to 'iterations' subgradient steps (0: the
+ * default); the node penalties are written to 'pi' (n doubles) unless it
+ * is NULL, and kept for tpf_solver_alpha.  Returns -1 on error. */
+long long tpf_held_karp(tpf_solver* s, int iterations, double* pi);
+
+/* Replace the candidate lists of the solver by the k alpha-nearest of
+ * each, under the penalties of the last tpf_held_karp (computed now if
+ * there is none), using 'threads' threads.  Returns 0, or -1 on error. */
+int tpf_solver_alpha(tpf_solver* s, int k, int threads);
+
+/* Solve exactly by branch-and-cut, with LP backend 0 (the bundled
+ * simplex) or 1 (CPLEX, if built in), stopping after 'max_nodes' nodes
+ * (0: no limit).  The best tour is written to 'tour' and the proven lower
+ * bound to 'bound'; returns the tour's length, or -1 on error. */
+long long tpf_branch_and_cut(const tpf_solver* s, int backend,
+                             long long max_nodes, int* tour,
+                             long long* bound);
+
+/* Whether LP backend 'backend' was built in. */
+int tpf_lp_backend(int backend);
+
+/* Stops a running tpf_solve from another thread.  Once stopped, a control
+ * stays stopped. */
+typedef struct tpf_control tpf_control;
+
+tpf_control* tpf_control_new(void);
+void tpf_control_stop(tpf_control* c);
+void tpf_control_free(tpf_control* c);
+
+/* Called with the length of each new incumbent, the lower bound known so
+ * far (-1: none), the kicks done and the seconds elapsed. */
+typedef void (*tpf_progress)(long long z, long long bound,
+                             long long iterations, double seconds,
+                             void* data);
+
+/* Anytime solve: improve a greedy tour by iterated local search with the
+ * given moves until 'seconds' of wall-clock time, 'iterations' kicks, a
+ * tour within 'gap' of the lower bound 'bound' (-1: Held-Karp, computed
+ * alongside up to 20000 cities, where it is a proven bound) or
+ * tpf_control_stop(control), whichever comes first (0, 0, a negative gap
+ * and NULL for none; seconds, iterations or a control must be given).
+ * 'progress', if not NULL, is called from the calling thread.  The tour
+ * is written to 'tour' and the bound known at the end to 'bound_out'
+ * unless it is NULL; returns the length, or -1 on error. */
+long long tpf_solve(const tpf_solver* s, double seconds,
+                    long long iterations, double gap, long long bound,
+                    unsigned seed, int moves, tpf_progress progress,
+                    void* data, tpf_control* control, int* tour,
+                    long long* bound_out);
+
+const char* tpf_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
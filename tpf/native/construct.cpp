@@ -0,0 +1,433 @@
+#include "construct.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "directed.h"
+#include "kdtree.h"
+#include "unionfind.h"
+
+namespace tpf {
+
+namespace {
+
+// k-d tree over the coordinates of D's instance, or null without them.
+std::unique_ptr<KdTree> mk_tree(const Oracle& D, const Control* control)
+{
+    const Problem* p = D.problem();
+    if (!p || p->type == EXPLICIT || p->n == 0)
+        return std::unique_ptr<KdTree>();
+    KdTree::Metric metric = p->type == MAN_2D
+                                ? KdTree::L1
+                                : (p->type == MAX_2D ? KdTree::LINF
+                                                     : KdTree::L2);
+    return std::unique_ptr<KdTree>(
+        new KdTree(&p->x[0], &p->y[0], p->n, metric, control));
+}
+
+// Whether 'control' has stopped, polled at every control_run-th step only.
+bool stopping(const Control* control, size_t step)
+{
+    return control && step % control_run == 0 && control->stopped();
+}
+
+bool stopped(const Control* control)
+{
+    return control && control->stopped();
+}
+
+// A tour under construction, as a doubly-linked cycle of the cities
+// inserted so far.
+struct Cycle {
+    std::vector<int> next, prev;
+    std::vector<char> in;
+
+    Cycle(int n, int start) : next(n, -1), prev(n, -1), in(n, 0)
+    {
+        next[start] = prev[start] = start;
+        in[start] = 1;
+    }
+
+    // Cost of inserting c between x and next(x).
+    long long cost(const Oracle& D, int x, int c) const
+    {
+        int y = next[x];
+        return static_cast<long long>(D(x, c)) + D(c, y) - D(x, y);
+    }
+
+    void insert_after(int x, int c)
+    {
+        int y = next[x];
+        next[x] = c;
+        prev[c] = x;
+        next[c] = y;
+        prev[y] = c;
+        in[c] = 1;
+    }
+
+    Tour tour(int start) const
+    {
+        Tour t;
+        t.reserve(next.size());
+        int c = start;
+        do {
+            t.push_back(c);
+            c = next[c];
+        } while (c != start);
+        return t;
+    }
+};
+
+Tour identity(int n)
+{
+    Tour t(n);
+    for (int i = 0; i < n; ++i)
+        t[i] = i;
+    return t;
+}
+
+}  // namespace
+
+Tour greedy_tour(const Oracle& D, const Neighbors& C, const Control* control)
+{
+    if (!D.symmetric())
+        return directed_greedy_tour(D, C, control);
+    int n = D.size();
+    if (n < 3)
+        return identity(n);
+
+    struct Edge {
+        int d, a, b;
+        bool operator<(const Edge& o) const
+        {
+            return d < o.d || (d == o.d && (a < o.a || (a == o.a && b < o.b)));
+        }
+    };
+    // An edge in the lists of both its ends comes twice; the second copy
+    // would close a cycle and is skipped.
+    std::vector<Edge> edges;
+    edges.reserve(C.city.size());
+    for (int i = 0; i < n; ++i) {
+        if (stopping(control, i))
+            return identity(n);
+        for (int k = C.begin(i); k < C.end(i); ++k) {
+            int j = C.city[k];
+            Edge e = {C.dist[k], std::min(i, j), std::max(i, j)};
+            edges.push_back(e);
+        }
+    }
+    if (!sort_until_stopped(edges, control))
+        return identity(n);
+
+    std::vector<int> adj(2 * n, -1);
+    std::vector<int> deg(n, 0);
+    UnionFind uf(n);
+    for (size_t k = 0; k < edges.size(); ++k) {
+        if (stopping(control, k))
+            return identity(n);
+        int a = edges[k].a, b = edges[k].b;
+        if (deg[a] < 2 && deg[b] < 2 && uf.unite(a, b)) {
+            adj[2 * a + deg[a]++] = b;
+            adj[2 * b + deg[b]++] = a;
+        }
+    }
+
+    // Join the fragments: walk one to its far end, then jump to the
+    // nearest end of another.
+    std::unique_ptr<KdTree> tree = mk_tree(D, control);
+    std::vector<char> free_end(n);
+    for (int i = 0; i < n; ++i) {
+        if (stopping(control, i))
+            return identity(n);
+        free_end[i] = deg[i] < 2;
+        if (tree && !free_end[i])
+            tree->erase(i);
+    }
+    Tour tour;
+    tour.reserve(n);
+    int cur = std::find(free_end.begin(), free_end.end(), 1)
+              - free_end.begin();
+    for (;;) {
+        free_end[cur] = 0;
+        if (tree)
+            tree->erase(cur);
+        int prev = -1, c = cur;
+        for (;;) {
+            tour.push_back(c);
+            if (stopping(control, tour.size()))
+                return identity(n);
+            int a0 = adj[2 * c], a1 = adj[2 * c + 1];
+            int next = a0 >= 0 && a0 != prev ? a0
+                                             : (a1 >= 0 && a1 != prev ? a1
+                                                                      : -1);
+            if (next < 0)
+                break;
+            prev = c;
+            c = next;
+        }
+        free_end[c] = 0;
+        if (tree)
+            tree->erase(c);
+
+        int j = -1;
+        if (tree) {
+            j = tree->nearest(c);
+        } else {
+            if (stopped(control))
+                return identity(n);
+            for (int i = 0; i < n; ++i)
+                if (free_end[i] && (j < 0 || D(c, i) < D(c, j)))
+                    j = i;
+        }
+        if (j < 0)
+            break;
+        cur = j;
+    }
+    return tour;
+}
+
+Tour space_filling_tour(const Oracle& D, const Control* control)
+{
+    const Problem* p = D.problem();
+    if (!p || p->type == EXPLICIT)
+        throw std::runtime_error("space-filling curve needs coordinates");
+    int n = p->n;
+    if (n == 0)
+        return Tour();
+    double xmin = *std::min_element(p->x.begin(), p->x.end());
+    double xmax = *std::max_element(p->x.begin(), p->x.end());
+    double ymin = *std::min_element(p->y.begin(), p->y.end());
+    double ymax = *std::max_element(p->y.begin(), p->y.end());
+    const unsigned side = 1u << 16;
+    double extent = std::max(xmax - xmin, ymax - ymin);
+    double scale = extent > 0 ? (side - 1) / extent : 0;
+
+    std::vector<std::pair<unsigned long long, int> > keys(n);
+    for (int i = 0; i < n; ++i) {
+        if (stopping(control, i))
+            return identity(n);
+        unsigned x = static_cast<unsigned>((p->x[i] - xmin) * scale);
+        unsigned y = static_cast<unsigned>((p->y[i] - ymin) * scale);
+        // distance along the curve, rotating each quadrant in turn
+        unsigned long long d = 0;
+        for (unsigned s = side / 2; s > 0; s /= 2) {
+            unsigned rx = (x & s) != 0, ry = (y & s) != 0;
+            d += static_cast<unsigned long long>(s) * s * ((3 * rx) ^ ry);
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        keys[i] = std::make_pair(d, i);
+    }
+    if (!sort_until_stopped(keys, control))
+        return identity(n);
+    Tour tour(n);
+    for (int i = 0; i < n; ++i)
+        tour[i] = keys[i].second;
+    return tour;
+}
+
+Tour nearest_neighbor_tour(const Oracle& D, int start,
+                           const Control* control)
+{
+    std::unique_ptr<KdTree> tree = mk_tree(D, control);
+    if (!tree)
+        return nearest_neighbor(start, D, control);
+    if (stopped(control))
+        return identity(D.size());
+    Tour tour;
+    tour.reserve(D.size());
+    for (int c = start; c >= 0; c = tree->nearest(c)) {
+        if (stopping(control, tour.size()))
+            return identity(D.size());
+        tree->erase(c);
+        tour.push_back(c);
+    }
+    return tour;
+}
+
+Tour farthest_insertion(const Oracle& D, int start, const Control* control)
+{
+    int n = D.size();
+    if (n < 3)
+        return identity(n);
+    Cycle cycle(n, start);
+    std::unique_ptr<KdTree> tree = mk_tree(D, control);
+    if (stopped(control))
+        return identity(n);
+
+    if (!tree) {
+        // key[j]: distance from j to the tour
+        std::vector<long long> key(n);
+        for (int j = 0; j < n; ++j)
+            key[j] = D(j, start);
+        for (int m = 1; m < n; ++m) {
+            if (stopped(control))
+                return identity(n);
+            int c = -1;
+            for (int j = 0; j < n; ++j)
+                if (!cycle.in[j] && (c < 0 || key[j] > key[c]))
+                    c = j;
+            int at = start;
+            long long best = cycle.cost(D, start, c);
+            for (int x = cycle.next[start]; x != start; x = cycle.next[x]) {
+                long long delta = cycle.cost(D, x, c);
+                if (delta < best) {
+                    best = delta;
+                    at = x;
+                }
+            }
+            cycle.insert_after(at, c);
+            for (int j = 0; j < n; ++j)
+                key[j] = std::min(key[j], static_cast<long long>(D(j, c)));
+        }
+        return cycle.tour(start);
+    }
+
+    // Keys are upper bounds on the distance to the tour, which only
+    // shrinks; a popped key that is still exact belongs to the farthest
+    // city.
+    std::priority_queue<std::pair<long long, int> > heap;
+    for (int i = 0; i < n; ++i) {
+        if (stopping(control, i))
+            return identity(n);
+        if (i != start) {
+            tree->erase(i);
+            heap.push(std::make_pair(LLONG_MAX, i));
+        }
+    }
+    std::vector<int> near;
+    for (size_t step = 0; !heap.empty(); ++step) {
+        if (stopping(control, step))
+            return identity(n);
+        std::pair<long long, int> top = heap.top();
+        heap.pop();
+        int c = top.second;
+        long long d = D(c, tree->nearest(c));
+        if (d < top.first) {
+            heap.push(std::make_pair(d, c));
+            continue;
+        }
+        tree->nearest(c, 8, near);
+        int at = -1;
+        long long best = LLONG_MAX;
+        for (size_t k = 0; k < near.size(); ++k) {
+            int xs[] = {near[k], cycle.prev[near[k]]};
+            for (int e = 0; e < 2; ++e) {
+                long long delta = cycle.cost(D, xs[e], c);
+                if (delta < best) {
+                    best = delta;
+                    at = xs[e];
+                }
+            }
+        }
+        cycle.insert_after(at, c);
+        tree->insert(c);
+    }
+    return cycle.tour(start);
+}
+
+Tour cheapest_insertion(const Oracle& D, const Neighbors& C, int start,
+                        const Control* control)
+{
+    int n = D.size();
+    if (n < 3)
+        return identity(n);
+
+    Neighbors S = mk_symmetric(C, control);
+    if (stopped(control))
+        return identity(n);
+    Cycle cycle(n, start);
+    // cheapest insertion of c next to one of its neighbours in the tour
+    auto best_edge = [&](int c, int& at) {
+        long long best = LLONG_MAX;
+        for (int k = S.begin(c); k < S.end(c); ++k) {
+            int t = S.city[k];
+            if (!cycle.in[t])
+                continue;
+            int xs[] = {t, cycle.prev[t]};
+            for (int e = 0; e < 2; ++e) {
+                long long delta = cycle.cost(D, xs[e], c);
+                if (delta < best) {
+                    best = delta;
+                    at = xs[e];
+                }
+            }
+        }
+        return best;
+    };
+
+    typedef std::pair<long long, int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item> > heap;
+    auto push_around = [&](int c) {
+        for (int k = S.begin(c); k < S.end(c); ++k) {
+            int j = S.city[k], at;
+            if (!cycle.in[j])
+                heap.push(Item(best_edge(j, at), j));
+        }
+    };
+    push_around(start);
+    int scan = 0;
+    for (size_t step = 0, m = 1; m < static_cast<size_t>(n); ++step) {
+        if (stopping(control, step))
+            return identity(n);
+        int c, at = -1;
+        if (heap.empty()) {
+            if (stopped(control))
+                return identity(n);
+            // no city left next to the tour: take any, at its best place
+            while (cycle.in[scan])
+                ++scan;
+            c = scan;
+            long long best = LLONG_MAX;
+            int x = start;
+            do {
+                long long delta = cycle.cost(D, x, c);
+                if (delta < best) {
+                    best = delta;
+                    at = x;
+                }
+                x = cycle.next[x];
+            } while (x != start);
+        } else {
+            Item top = heap.top();
+            heap.pop();
+            c = top.second;
+            if (cycle.in[c])
+                continue;
+            long long cost = best_edge(c, at);
+            if (cost != top.first) {
+                heap.push(Item(cost, c));
+                continue;
+            }
+        }
+        cycle.insert_after(at, c);
+        ++m;
+        push_around(c);
+    }
+    return cycle.tour(start);
+}
+
+Tour initial_tour(Start start, const Oracle& D, const Neighbors& C,
+                  std::mt19937& rng, const Control* control)
+{
+    switch (start) {
+    case NEAREST_START: return nearest_neighbor_tour(D, 0, control);
+    case GREEDY_START: return greedy_tour(D, C, control);
+    case SPACE_FILLING_START: return space_filling_tour(D, control);
+    case FARTHEST_START: return farthest_insertion(D, 0, control);
+    case CHEAPEST_START: return cheapest_insertion(D, C, 0, control);
+    default: return randtour(D.size(), rng);
+    }
+}
+
+}  // namespace tpf
@@ -0,0 +1,62 @@
+#ifndef TPF_CONSTRUCT_H
+#define TPF_CONSTRUCT_H
+
+#include <random>
+
+#include "control.h"
+#include "localsearch.h"
+
+namespace tpf {
+
+// Starting tours.  The spatial ones query a k-d tree over the coordinates
+// of D.problem(); on instances without coordinates (EXPLICIT weights or a
+// plain Matrix) they fall back to O(n^2) scans, except the space-filling
+// curve, which throws.
+//
+// Each builder polls 'control', if given, every few thousand steps (every
+// step of the O(n^2) scans) and, once it stops, gives up and returns the
+// cities in index order: a valid tour, if a poor one.
+
+// Greedy edge: take candidate edges shortest first whenever both ends
+// have degree < 2 and no cycle closes (union-find), then join the
+// fragments end to nearest free end.  With asymmetric distances, the
+// directed_greedy_tour() of directed.h.
+Tour greedy_tour(const Oracle& D, const Neighbors& C,
+                 const Control* control = 0);
+
+// Order the cities along a Hilbert curve through their bounding box.
+Tour space_filling_tour(const Oracle& D, const Control* control = 0);
+
+// Nearest neighbour from city 'start', the nearest unvisited city found
+// with the k-d tree (ties to the lowest index as in nearest_neighbor()
+// only without coordinates).
+Tour nearest_neighbor_tour(const Oracle& D, int start = 0,
+                           const Control* control = 0);
+
+// Farthest insertion from city 'start': repeatedly take the city farthest
+// from the tour and insert it where it adds least, next to one of the
+// tour cities nearest to it.
+Tour farthest_insertion(const Oracle& D, int start = 0,
+                        const Control* control = 0);
+
+// Cheapest insertion from city 'start': repeatedly insert the city that
+// adds least, over the tour edges at its candidate neighbours.
+Tour cheapest_insertion(const Oracle& D, const Neighbors& C, int start = 0,
+                        const Control* control = 0);
+
+enum Start {
+    RANDOM_START,
+    NEAREST_START,
+    GREEDY_START,
+    SPACE_FILLING_START,
+    FARTHEST_START,
+    CHEAPEST_START
+};
+
+// A starting tour of the given kind; 'rng' draws random tours.
+Tour initial_tour(Start start, const Oracle& D, const Neighbors& C,
+                  std::mt19937& rng, const Control* control = 0);
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef TPF_CONTROL_H
+#define TPF_CONTROL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tpf {
+
+// Cooperative control of a long search from other threads.
+//
+// Any thread may stop() a control; the search polls stopped() between
+// moves, which for local search is every few microseconds, and returns
+// with the best tour it has.  A control can also stop by itself at a
+// deadline, set by a timer thread so that polling never reads the clock,
+// and stops whenever its parent does.  The search reports each
+// new best length through improved() and each iteration through count(),
+// so that progress can be watched without building tours.
+class Control {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    explicit Control(const Control* parent = 0)
+        : parent_(parent), stop_(false), iterations_(0), cancelled_(false)
+    {
+    }
+
+    ~Control() { cancel_timer(); }
+
+    // Called from the searching thread with each new best length and the
+    // iterations done so far.  It may call stop().
+    std::function<void(long long z, long long iterations)> on_improved;
+
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    // Stop at 'seconds' from now (before any search starts).
+    void set_deadline(double seconds)
+    {
+        std::chrono::duration<double> d(seconds);
+        clock::time_point deadline =
+            clock::now() + std::chrono::duration_cast<clock::duration>(d);
+        cancel_timer();
+        cancelled_ = false;
+        timer_ = std::thread([this, deadline] {
+            std::unique_lock<std::mutex> lock(timer_mutex_);
+            if (!timer_wake_.wait_until(lock, deadline,
+                                        [this] { return cancelled_; }))
+                stop();
+        });
+    }
+
+    bool stopped() const
+    {
+        return stop_.load(std::memory_order_relaxed)
+               || (parent_ && parent_->stopped());
+    }
+
+    void improved(long long z) const
+    {
+        if (on_improved)
+            on_improved(z, iterations_.load(std::memory_order_relaxed));
+    }
+
+    void count() const
+    {
+        iterations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    long long iterations() const
+    {
+        return iterations_.load(std::memory_order_relaxed);
+    }
+
+private:
+    Control(const Control&);
+    Control& operator=(const Control&);
+
+    void cancel_timer()
+    {
+        if (!timer_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex_);
+            cancelled_ = true;
+        }
+        timer_wake_.notify_one();
+        timer_.join();
+    }
+
+    const Control* parent_;
+    std::atomic<bool> stop_;
+    mutable std::atomic<long long> iterations_;
+    std::thread timer_;  // stops the control at the deadline
+    std::mutex timer_mutex_;
+    std::condition_variable timer_wake_;
+    bool cancelled_;     // the timer is no longer wanted
+};
+
+// std::sort for a search that must stay stoppable: runs of control_run
+// elements sorted, then merged pairwise, 'control' polled between runs
+// and every control_run merged elements.  Returns false, with 'v' in no
+// particular order, once it stops.  Without a control, plain std::sort.
+const size_t control_run = 4096;
+
+template <class T>
+bool sort_until_stopped(std::vector<T>& v, const Control* control)
+{
+    if (!control) {
+        std::sort(v.begin(), v.end());
+        return true;
+    }
+    size_t n = v.size();
+    for (size_t lo = 0; lo < n; lo += control_run) {
+        if (control->stopped())
+            return false;
+        std::sort(v.begin() + lo, v.begin() + std::min(n, lo + control_run));
+    }
+    std::vector<T> merged(n);
+    for (size_t width = control_run; width < n; width *= 2) {
+        size_t out = 0;
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t a = lo, mid = std::min(n, lo + width);
+            size_t b = mid, hi = std::min(n, lo + 2 * width);
+            while (a < mid || b < hi) {
+                if (out % control_run == 0 && control->stopped())
+                    return false;
+                merged[out++] = b == hi || (a < mid && !(v[b] < v[a]))
+                                    ? v[a++]
+                                    : v[b++];
+            }
+        }
+        v.swap(merged);
+    }
+    return true;
+}
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef TPF_COUNTERS_H
+#define TPF_COUNTERS_H
+
+#include <atomic>
+
+namespace tpf {
+
+// Work done by the local searches (Search and LinKernighan) of the process:
+// moves whose change in length was evaluated and moves applied.  Each
+// search counts on its own and adds its counts here when it is destroyed,
+// so that searches on pool threads are included.  The counts only grow;
+// measure a run by the difference between two reads.
+struct SearchCounters {
+    std::atomic<long long> evaluated;
+    std::atomic<long long> applied;
+};
+
+inline SearchCounters& search_counters()
+{
+    static SearchCounters counters;
+    return counters;
+}
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,239 @@
+#include "crossover.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "pool.h"
+#include "unionfind.h"
+
+namespace tpf {
+
+namespace {
+
+// The two tour neighbours of each city, at 2i and 2i + 1.
+std::vector<int> adjacency(const Tour& t)
+{
+    int n = static_cast<int>(t.size());
+    std::vector<int> adj(2 * static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        adj[2 * t[i]] = t[(i + n - 1) % n];
+        adj[2 * t[i] + 1] = t[(i + 1) % n];
+    }
+    return adj;
+}
+
+inline bool has_edge(const std::vector<int>& adj, int u, int v)
+{
+    return adj[2 * u] == v || adj[2 * u + 1] == v;
+}
+
+// Whether a and b have the same edges.
+bool same_tour(const Tour& a, const Tour& b)
+{
+    if (a.size() != b.size())
+        return false;
+    std::vector<int> adj = adjacency(b);
+    int n = static_cast<int>(a.size());
+    for (int i = 0; i < n; ++i)
+        if (!has_edge(adj, a[i], a[(i + 1) % n]))
+            return false;
+    return true;
+}
+
+// Keep the 'size' best solutions of 'pop' and 'more', distinct, ordered by
+// length and then by their order in pop followed by more.
+void select(std::vector<Solution>& pop, std::vector<Solution>& more,
+            int size)
+{
+    for (size_t i = 0; i < more.size(); ++i)
+        if (!more[i].tour.empty())
+            pop.push_back(std::move(more[i]));
+    more.clear();
+    std::stable_sort(pop.begin(), pop.end(),
+                     [](const Solution& x, const Solution& y) {
+                         return x.z < y.z;
+                     });
+    std::vector<Solution> kept;
+    for (size_t i = 0; i < pop.size()
+                       && static_cast<int>(kept.size()) < size;
+         ++i) {
+        bool dup = false;
+        for (size_t j = 0; j < kept.size() && !dup; ++j)
+            dup = kept[j].z == pop[i].z && same_tour(kept[j].tour,
+                                                     pop[i].tour);
+        if (!dup)
+            kept.push_back(std::move(pop[i]));
+    }
+    pop.swap(kept);
+}
+
+}  // namespace
+
+Solution gpx(const Solution& a, const Solution& b, const Oracle& D,
+             std::vector<int>* contested)
+{
+    if (!D.symmetric())
+        throw std::runtime_error("gpx needs symmetric distances");
+    const Solution& p = b.z < a.z ? b : a;  // the better parent
+    const Solution& q = b.z < a.z ? a : b;
+    int n = static_cast<int>(p.tour.size());
+    if (contested)
+        contested->clear();
+    if (n < 5)
+        return p;
+    std::vector<int> adj_p = adjacency(p.tour), adj_q = adjacency(q.tour);
+
+    // components of the edges the parents do not share
+    UnionFind uf(n);
+    std::vector<char> open(n, 0);
+    for (int u = 0; u < n; ++u)
+        for (int s = 0; s < 2; ++s) {
+            int v = adj_p[2 * u + s], w = adj_q[2 * u + s];
+            if (!has_edge(adj_q, u, v)) {
+                uf.unite(u, v);
+                open[u] = open[v] = 1;
+            }
+            if (!has_edge(adj_p, u, w)) {
+                uf.unite(u, w);
+                open[u] = open[w] = 1;
+            }
+        }
+    std::vector<int> comp(n, -1);
+    for (int u = 0; u < n; ++u)
+        if (open[u]) {
+            comp[u] = uf.find(u);
+            if (contested)
+                contested->push_back(u);
+        }
+
+    // How often each parent enters each component: along the tour, with
+    // the cities of shared edges only left out, count the changes from one
+    // component to another.  A component entered once by both parents is
+    // crossed by each as one path between the same two cities; paths of
+    // shared edges that leave it and come back are part of that path.
+    std::vector<int> enter_p(n, 0), enter_q(n, 0);
+    for (int t = 0; t < 2; ++t) {
+        const Tour& tour = t == 0 ? p.tour : q.tour;
+        std::vector<int>& enter = t == 0 ? enter_p : enter_q;
+        int first = -1, last = -1;
+        for (int i = 0; i < n; ++i) {
+            int r = comp[tour[i]];
+            if (r < 0)
+                continue;
+            if (first < 0)
+                first = r;
+            else if (r != last)
+                ++enter[r];
+            last = r;
+        }
+        if (first >= 0 && first != last)
+            ++enter[first];
+    }
+
+    // each parent's length in each component
+    std::vector<long long> in_p(n, 0), in_q(n, 0);
+    for (int u = 0; u < n; ++u) {
+        int v = adj_p[2 * u + 1], w = adj_q[2 * u + 1];
+        if (comp[u] >= 0 && comp[u] == comp[v])
+            in_p[comp[u]] += D(u, v);
+        if (comp[u] >= 0 && comp[u] == comp[w])
+            in_q[comp[u]] += D(u, w);
+    }
+
+    Solution child;
+    child.z = p.z;
+    std::vector<char> from_q(n, 0);
+    bool any = false;
+    for (int r = 0; r < n; ++r)
+        if (enter_p[r] == 1 && enter_q[r] == 1 && in_q[r] < in_p[r]) {
+            from_q[r] = 1;
+            child.z += in_q[r] - in_p[r];
+            any = true;
+        }
+    if (!any)
+        return p;
+
+    auto adj_of = [&](int c) -> const std::vector<int>& {
+        return comp[c] >= 0 && from_q[comp[c]] ? adj_q : adj_p;
+    };
+    child.tour.reserve(n);
+    std::vector<char> seen(n, 0);
+    int prev = adj_p[0], c = 0;
+    for (int i = 0; i < n; ++i) {
+        const std::vector<int>& adj = adj_of(c);
+        if (seen[c] || !has_edge(adj, c, prev))
+            return p;  // not a single cycle; cannot happen
+        seen[c] = 1;
+        child.tour.push_back(c);
+        int next = adj[2 * c] != prev ? adj[2 * c] : adj[2 * c + 1];
+        prev = c;
+        c = next;
+    }
+    return child;
+}
+
+Solution population_search(int k, int population, const Oracle& D,
+                           const Neighbors& C, unsigned seed, int threads,
+                           const Report& report, int moves,
+                           long long target)
+{
+    ThreadPool pool(threads);
+    std::vector<Oracle> oracles(pool.size(), D);
+    if (population < 1)
+        population = 1;
+
+    std::vector<Solution> pop, slots(k);
+    for (int i = 0; i < k; ++i)
+        pool.submit([&, i](int w) {
+            std::seed_seq seq{seed, static_cast<unsigned>(i)};
+            std::mt19937 rng(seq);
+            const Oracle& Dw = oracles[w];
+            Solution& s = slots[i];
+            s.tour = randtour(Dw.size(), rng);
+            s.z = length(s.tour, Dw);
+            s.z = moves ? optimize(s.tour, s.z, Dw, C, moves)
+                        : localsearch(s.tour, s.z, Dw, C);
+        });
+    pool.wait();
+    select(pop, slots, population);
+    if (pop.empty()) {
+        Solution none;
+        none.z = -1;
+        return none;
+    }
+    if (report)
+        report(pop[0].z, pop[0].tour);
+
+    int child_moves = moves ? moves : OR2OPT;
+    while (pop[0].z > target) {
+        std::vector<std::pair<int, int> > pairs;
+        for (size_t i = 0; i < pop.size(); ++i)
+            for (size_t j = i + 1; j < pop.size(); ++j)
+                pairs.push_back(std::make_pair(static_cast<int>(i),
+                                               static_cast<int>(j)));
+        std::vector<Solution> children(pairs.size());
+        for (size_t c = 0; c < pairs.size(); ++c)
+            pool.submit([&, c](int w) {
+                const Oracle& Dw = oracles[w];
+                std::vector<int> contested;
+                Solution s = gpx(pop[pairs[c].first], pop[pairs[c].second],
+                                 Dw, &contested);
+                if (contested.empty())
+                    return;
+                s.z = optimize(s.tour, s.z, Dw, C, contested, child_moves);
+                children[c] = std::move(s);
+            });
+        pool.wait();
+
+        long long before = pop[0].z;
+        select(pop, children, population);
+        if (pop[0].z >= before)
+            break;
+        if (report)
+            report(pop[0].z, pop[0].tour);
+    }
+    return pop[0];
+}
+
+}  // namespace tpf
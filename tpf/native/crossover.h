@@ -0,0 +1,43 @@
+#ifndef TPF_CROSSOVER_H
+#define TPF_CROSSOVER_H
+
+#include <vector>
+
+#include "localsearch.h"
+#include "moves.h"
+
+namespace tpf {
+
+// Generalized partition crossover (GPX) of two tours.
+//
+// The edges the parents do not share fall into connected components of
+// their union graph.  A component both parents enter once is crossed by
+// each as one path between the same two cities, so either path can be
+// taken independently of the rest; the child takes the shorter one in
+// each such component and the better parent's edges everywhere else.  It
+// is never longer than either parent.  'contested', if given, receives the
+// cities with an edge the parents do not share.
+Solution gpx(const Solution& a, const Solution& b, const Oracle& D,
+             std::vector<int>* contested = 0);
+
+// Parallel restarts as multistart_localsearch(), keeping the best
+// 'population' distinct local optima instead of the best one only, then
+// recombining them.  Each generation crosses every pair of the population
+// with gpx() and re-optimises the children with 'moves' (0: 2-opt, as in
+// localsearch(), for the restarts and OR2OPT for the children) from their
+// contested cities only, so the edges both parents share stay put unless
+// an improving move around a contested city reaches them; the best
+// 'population' of parents and children make the next generation.  Stops
+// when a generation brings no new best tour, or one of length 'target' or
+// less.  Restart i is seeded from (seed, i) and children are kept in pair
+// order, so the result does not depend on the number of threads.
+// 'report' is called from the calling thread with the best restart and
+// with each new best child.
+Solution population_search(int k, int population, const Oracle& D,
+                           const Neighbors& C, unsigned seed, int threads,
+                           const Report& report = Report(),
+                           int moves = OR2OPT, long long target = -1);
+
+}  // namespace tpf
+
+#endif
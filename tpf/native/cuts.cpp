@@ -0,0 +1,222 @@
+#include "cuts.h"
+
+#include <algorithm>
+#include <set>
+
+#include "unionfind.h"
+
+namespace tpf {
+
+namespace {
+
+const double eps = 1e-6;
+
+// The sets of a partition given as union-find roots.
+std::vector<std::vector<int> > classes(UnionFind& uf, int n)
+{
+    std::vector<int> id(n, -1);
+    std::vector<std::vector<int> > sets;
+    for (int i = 0; i < n; ++i) {
+        int r = uf.find(i);
+        if (id[r] < 0) {
+            id[r] = static_cast<int>(sets.size());
+            sets.push_back(std::vector<int>());
+        }
+        sets[id[r]].push_back(i);
+    }
+    return sets;
+}
+
+// Subtour constraint on S or on its complement, whichever is smaller.
+Cut subtour(std::vector<int> S, int n)
+{
+    if (2 * static_cast<int>(S.size()) > n) {
+        std::vector<char> in(n, 0);
+        for (size_t k = 0; k < S.size(); ++k)
+            in[S[k]] = 1;
+        S.clear();
+        for (int i = 0; i < n; ++i)
+            if (!in[i])
+                S.push_back(i);
+    }
+    std::sort(S.begin(), S.end());
+    Cut cut;
+    cut.sets.push_back(S);
+    cut.rhs = static_cast<int>(S.size()) - 1;
+    return cut;
+}
+
+}  // namespace
+
+double cut_lhs(const Cut& cut, const Support& x)
+{
+    std::vector<char> in(x.n, 0);
+    double lhs = 0;
+    for (size_t s = 0; s < cut.sets.size(); ++s) {
+        const std::vector<int>& S = cut.sets[s];
+        for (size_t k = 0; k < S.size(); ++k)
+            in[S[k]] = 1;
+        for (size_t k = 0; k < x.x.size(); ++k)
+            if (in[x.a[k]] && in[x.b[k]])
+                lhs += x.x[k];
+        for (size_t k = 0; k < S.size(); ++k)
+            in[S[k]] = 0;
+    }
+    return lhs;
+}
+
+int subtour_cuts(const Support& x, std::vector<Cut>& cuts)
+{
+    int n = x.n;
+    size_t before = cuts.size();
+    UnionFind all(n);
+    for (size_t k = 0; k < x.x.size(); ++k)
+        all.unite(x.a[k], x.b[k]);
+    std::vector<std::vector<int> > parts = classes(all, n);
+    if (parts.size() > 1) {
+        for (size_t p = 0; p < parts.size(); ++p)
+            cuts.push_back(subtour(parts[p], n));
+        return static_cast<int>(cuts.size() - before);
+    }
+
+    UnionFind ones(n);
+    for (size_t k = 0; k < x.x.size(); ++k)
+        if (x.x[k] >= 1 - eps)
+            ones.unite(x.a[k], x.b[k]);
+    std::vector<std::vector<int> > group = classes(ones, n);
+    int m = static_cast<int>(group.size());
+    std::vector<int> id(n);
+    for (int g = 0; g < m; ++g)
+        for (size_t k = 0; k < group[g].size(); ++k)
+            id[group[g][k]] = g;
+    std::vector<std::vector<double> > w(m, std::vector<double>(m, 0));
+    for (size_t k = 0; k < x.x.size(); ++k) {
+        int i = id[x.a[k]], j = id[x.b[k]];
+        if (i != j) {
+            w[i][j] += x.x[k];
+            w[j][i] += x.x[k];
+        }
+    }
+
+    // Stoer-Wagner: each phase orders the nodes by maximum adjacency; the
+    // last one is cut off by the weight of its edges, then merged into
+    // the one before it.
+    std::set<std::vector<int> > seen;
+    std::vector<int> active(m);
+    for (int g = 0; g < m; ++g)
+        active[g] = g;
+    std::vector<double> key(m);
+    std::vector<char> added(m);
+    while (active.size() > 1) {
+        for (size_t k = 0; k < active.size(); ++k) {
+            key[active[k]] = 0;
+            added[active[k]] = 0;
+        }
+        int prev = -1, last = -1;
+        for (size_t step = 0; step < active.size(); ++step) {
+            int v = -1;
+            for (size_t k = 0; k < active.size(); ++k) {
+                int u = active[k];
+                if (!added[u] && (v < 0 || key[u] > key[v]))
+                    v = u;
+            }
+            added[v] = 1;
+            prev = last;
+            last = v;
+            for (size_t k = 0; k < active.size(); ++k) {
+                int u = active[k];
+                if (!added[u])
+                    key[u] += w[v][u];
+            }
+        }
+        if (key[last] < 2 - eps) {
+            Cut cut = subtour(group[last], n);
+            if (seen.insert(cut.sets[0]).second)
+                cuts.push_back(cut);
+        }
+        for (size_t k = 0; k < active.size(); ++k) {
+            int u = active[k];
+            w[prev][u] += w[last][u];
+            w[u][prev] = w[prev][u];
+        }
+        w[prev][prev] = 0;
+        group[prev].insert(group[prev].end(), group[last].begin(),
+                           group[last].end());
+        active.erase(std::find(active.begin(), active.end(), last));
+    }
+    return static_cast<int>(cuts.size() - before);
+}
+
+int comb_cuts(const Support& x, std::vector<Cut>& cuts)
+{
+    int n = x.n;
+    size_t before = cuts.size();
+    UnionFind frac(n);
+    std::vector<char> touched(n, 0);
+    for (size_t k = 0; k < x.x.size(); ++k)
+        if (x.x[k] > eps && x.x[k] < 1 - eps) {
+            frac.unite(x.a[k], x.b[k]);
+            touched[x.a[k]] = touched[x.b[k]] = 1;
+        }
+    std::vector<std::vector<int> > handles = classes(frac, n);
+
+    std::vector<char> in(n, 0);
+    std::vector<int> uses(n, 0);
+    for (size_t h = 0; h < handles.size(); ++h) {
+        std::vector<int> H = handles[h];
+        if (H.size() < 2 || !touched[H[0]])
+            continue;
+        for (size_t k = 0; k < H.size(); ++k)
+            in[H[k]] = 1;
+        std::vector<int> teeth;  // support edges at 1 leaving H
+        for (size_t k = 0; k < x.x.size(); ++k)
+            if (x.x[k] >= 1 - eps && in[x.a[k]] != in[x.b[k]])
+                teeth.push_back(static_cast<int>(k));
+        // teeth meeting outside H: take their common end into H
+        for (bool merged = true; merged;) {
+            merged = false;
+            std::vector<int> out(teeth.size()), kept;
+            for (size_t t = 0; t < teeth.size(); ++t) {
+                int k = teeth[t];
+                out[t] = in[x.a[k]] ? x.b[k] : x.a[k];
+                ++uses[out[t]];
+            }
+            for (size_t t = 0; t < teeth.size(); ++t) {
+                if (uses[out[t]] > 1) {
+                    if (!in[out[t]]) {
+                        in[out[t]] = 1;
+                        H.push_back(out[t]);
+                    }
+                    merged = true;
+                } else {
+                    kept.push_back(teeth[t]);
+                }
+            }
+            for (size_t t = 0; t < teeth.size(); ++t)
+                uses[out[t]] = 0;
+            teeth.swap(kept);
+        }
+
+        int t = static_cast<int>(teeth.size());
+        if (t >= 3 && t % 2 == 1) {
+            Cut cut;
+            std::sort(H.begin(), H.end());
+            cut.sets.push_back(H);
+            for (int q = 0; q < t; ++q) {
+                int k = teeth[q];
+                std::vector<int> T(2);
+                T[0] = std::min(x.a[k], x.b[k]);
+                T[1] = std::max(x.a[k], x.b[k]);
+                cut.sets.push_back(T);
+            }
+            cut.rhs = static_cast<int>(H.size()) + (t - 1) / 2;
+            if (cut_lhs(cut, x) > cut.rhs + eps)
+                cuts.push_back(cut);
+        }
+        for (size_t k = 0; k < H.size(); ++k)
+            in[H[k]] = 0;
+    }
+    return static_cast<int>(cuts.size() - before);
+}
+
+}  // namespace tpf
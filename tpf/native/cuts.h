@@ -0,0 +1,47 @@
+#ifndef TPF_CUTS_H
+#define TPF_CUTS_H
+
+#include <vector>
+
+namespace tpf {
+
+// Separation of the inequalities of the branch-and-cut (branch.h) from a
+// fractional solution x of the degree LP, given as its support graph.
+
+// Edges (a[k], b[k]) with value x[k] > 0.
+struct Support {
+    int n;
+    std::vector<int> a, b;
+    std::vector<double> x;
+};
+
+// The inequality sum over S in 'sets' of x(E(S)) <= rhs, where E(S) are
+// the edges with both ends in S.  Subtour constraints have one set, combs
+// a handle and its teeth.
+struct Cut {
+    std::vector<std::vector<int> > sets;
+    int rhs;
+};
+
+// Left-hand side of cut at x.
+double cut_lhs(const Cut& cut, const Support& x);
+
+// Violated subtour constraints x(E(S)) <= |S| - 1.  Each connected
+// component is one if there are several; otherwise edges at 1 are
+// shrunk (Padberg-Rinaldi: some minimum cut never separates their ends)
+// and every cut of a phase of Stoer-Wagner below 2 is taken, which finds a
+// violated constraint whenever there is one.  S is the smaller side.
+// Returns the number of cuts appended.
+int subtour_cuts(const Support& x, std::vector<Cut>& cuts);
+
+// Violated blossoms (combs whose teeth are single edges), by the
+// heuristic of Padberg and Hong: handles are the components of the edges
+// with 0 < x < 1, teeth the edges at 1 leaving them, overlapping teeth
+// being merged into the handle, and an odd number of at least three teeth
+// gives x(E(H)) + x(teeth) <= |H| + (t - 1) / 2.  Returns the number of
+// cuts appended.
+int comb_cuts(const Support& x, std::vector<Cut>& cuts);
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,235 @@
+#include "directed.h"
+
+#include <algorithm>
+
+#include "active.h"
+#include "counters.h"
+#include "moves.h"
+
+namespace tpf {
+
+Tour directed_greedy_tour(const Oracle& D, const Neighbors& C,
+                          const Control* control)
+{
+    int n = D.size();
+    Tour tour;
+    if (n == 0)
+        return tour;
+    // once 'control' stops: the cities in index order
+    auto give_up = [&tour, n] {
+        tour.resize(n);
+        for (int i = 0; i < n; ++i)
+            tour[i] = i;
+        return tour;
+    };
+    auto stopping = [control](size_t step) {
+        return control && step % control_run == 0 && control->stopped();
+    };
+
+    struct Arc {
+        int d, a, b;
+        bool operator<(const Arc& o) const
+        {
+            return d < o.d || (d == o.d && (a < o.a || (a == o.a && b < o.b)));
+        }
+    };
+    std::vector<Arc> arcs;
+    arcs.reserve(C.city.size());
+    for (int i = 0; i < n; ++i) {
+        if (stopping(i))
+            return give_up();
+        for (int k = C.begin(i); k < C.end(i); ++k) {
+            Arc e = {C.dist[k], i, C.city[k]};
+            arcs.push_back(e);
+        }
+    }
+    if (!sort_until_stopped(arcs, control))
+        return give_up();
+
+    // other[x] is the far end of the fragment x ends, x itself if alone
+    std::vector<int> next(n, -1), prev(n, -1), other(n);
+    for (int i = 0; i < n; ++i)
+        other[i] = i;
+    for (size_t k = 0; k < arcs.size(); ++k) {
+        if (stopping(k))
+            return give_up();
+        int a = arcs[k].a, b = arcs[k].b;
+        if (next[a] >= 0 || prev[b] >= 0 || other[a] == b)
+            continue;
+        int head = other[a], tail = other[b];
+        next[a] = b;
+        prev[b] = a;
+        other[head] = tail;
+        other[tail] = head;
+    }
+
+    // Chain the fragments from their heads, cities with no arc in.
+    std::vector<int> heads;
+    for (int i = 0; i < n; ++i)
+        if (prev[i] < 0)
+            heads.push_back(i);
+    std::vector<char> used(n, 0);
+    size_t cursor = 0;
+    tour.reserve(n);
+    int h = heads[0];
+    for (;;) {
+        used[h] = 1;
+        int c = h;
+        for (;;) {
+            tour.push_back(c);
+            if (stopping(tour.size()))
+                return give_up();
+            if (next[c] < 0)
+                break;
+            c = next[c];
+        }
+        h = -1;
+        for (int k = C.begin(c); k < C.end(c) && h < 0; ++k)
+            if (prev[C.city[k]] < 0 && !used[C.city[k]])
+                h = C.city[k];
+        while (h < 0 && cursor < heads.size())
+            if (!used[heads[cursor++]])
+                h = heads[cursor - 1];
+        if (h < 0)
+            break;
+    }
+    return tour;
+}
+
+namespace {
+
+// Doubly linked tour: moving a segment without reversing it is O(1).
+class Directed {
+public:
+    Directed(const Tour& tour, const Oracle& D, const Neighbors& C,
+             ActiveQueue& queue)
+        : next_(tour.size()), prev_(tour.size()), D_(D), C_(C),
+          R_(mk_reverse(C)), queue_(queue), evaluated_(0), applied_(0)
+    {
+        int n = static_cast<int>(tour.size());
+        for (int k = 0; k < n; ++k) {
+            int c = tour[k], d = tour[k + 1 == n ? 0 : k + 1];
+            next_[c] = d;
+            prev_[d] = c;
+        }
+    }
+
+    ~Directed()
+    {
+        search_counters().evaluated += evaluated_;
+        search_counters().applied += applied_;
+    }
+
+    long long run(long long z)
+    {
+        while (!queue_.empty()) {
+            int a = queue_.pop();
+            while (or_opt(a, z)) {
+            }
+        }
+        return z;
+    }
+
+    Tour sequence(int start) const
+    {
+        Tour t;
+        t.reserve(next_.size());
+        int c = start;
+        do {
+            t.push_back(c);
+            c = next_[c];
+        } while (c != start);
+        return t;
+    }
+
+private:
+    bool or_opt(int a, long long& z)
+    {
+        int seg[max_segment];
+        for (int len = 1; len <= max_segment; ++len) {
+            // segments s1 -> .. -> s2 starting or ending at a
+            for (int side = 0; side < (len == 1 ? 1 : 2); ++side) {
+                int s1 = a, s2 = a;
+                seg[0] = a;
+                for (int i = 1; i < len; ++i)
+                    seg[i] = side == 0 ? (s2 = next_[s2]) : (s1 = prev_[s1]);
+                int p = prev_[s1], n = next_[s2];
+                long long gain = static_cast<long long>(D_(p, s1))
+                                 + D_(s2, n) - D_(p, n);
+                if (gain <= 0)
+                    continue;
+                // u -> s1 from the arcs into s1, s2 -> v from those out
+                for (int e = 0; e < 2; ++e) {
+                    const Neighbors& L = e == 0 ? R_ : C_;
+                    int end = e == 0 ? s1 : s2;
+                    for (int k = L.begin(end); k < L.end(end); ++k) {
+                        if (L.dist[k] >= gain)
+                            break;
+                        int c = L.city[k];
+                        int u = e == 0 ? c : prev_[c];
+                        int v = e == 0 ? next_[c] : c;
+                        if (in(seg, len, u) || in(seg, len, v))
+                            continue;
+                        long long delta = or_opt_delta(D_, p, s1, s2, n, u,
+                                                       v, false);
+                        ++evaluated_;
+                        if (delta < 0) {
+                            next_[p] = n;
+                            prev_[n] = p;
+                            next_[u] = s1;
+                            prev_[s1] = u;
+                            next_[s2] = v;
+                            prev_[v] = s2;
+                            ++applied_;
+                            z += delta;
+                            wake(p), wake(n), wake(u), wake(v);
+                            for (int i = 0; i < len; ++i)
+                                wake(seg[i]);
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    static bool in(const int* seg, int len, int c)
+    {
+        for (int i = 0; i < len; ++i)
+            if (seg[i] == c)
+                return true;
+        return false;
+    }
+
+    void wake(int c) { queue_.push(c); }
+
+    std::vector<int> next_, prev_;
+    const Oracle& D_;
+    const Neighbors& C_;
+    Neighbors R_;  // arcs into each city
+    ActiveQueue& queue_;
+    long long evaluated_, applied_;  // added to search_counters() at the end
+};
+
+}  // namespace
+
+long long directed_or_opt(Tour& tour, long long z, const Oracle& D,
+                          const Neighbors& C, const std::vector<int>* dirty)
+{
+    int n = static_cast<int>(tour.size());
+    if (n < max_segment + 3)
+        return z;
+    ActiveQueue queue(n);
+    if (dirty)
+        for (size_t k = 0; k < dirty->size(); ++k)
+            queue.push((*dirty)[k]);
+    else
+        queue.push_all();
+    Directed t(tour, D, C, queue);
+    z = t.run(z);
+    tour = t.sequence(tour[0]);
+    return checked_length(tour, z, D);
+}
+
+}  // namespace tpf
@@ -0,0 +1,39 @@
+#ifndef TPF_DIRECTED_H
+#define TPF_DIRECTED_H
+
+#include <vector>
+
+#include "control.h"
+#include "localsearch.h"
+#include "neighbors.h"
+#include "oracle.h"
+
+namespace tpf {
+
+// Tours for asymmetric distances (!D.symmetric()), such as ATSP matrices
+// and sparse directed graphs.  A tour runs tour[0] -> tour[1] -> ... and
+// back to tour[0]; C holds the arcs from each city, as mk_closest() builds
+// them.  Neither function reverses a path, so both stay correct whatever
+// D(j,i) is.
+
+// Greedy arc: take candidate arcs cheapest first whenever the tail has no
+// arc out and the head none in yet and no cycle closes, then chain the
+// fragments, each to the head of another found in the arcs from its tail
+// if there is one.  'control' is polled as by greedy_tour() (construct.h).
+Tour directed_greedy_tour(const Oracle& D, const Neighbors& C,
+                          const Control* control = 0);
+
+// Or-opt without reversal: segments of up to max_segment cities move, in
+// their direction, between two consecutive cities u -> v, found among the
+// arcs into the segment's first city and from its last one.  Cities are
+// driven by an ActiveQueue; only those in 'dirty' start active, all of
+// them if it is null.  Returns the new length.  On a sparse graph it
+// removes forbidden arcs only as far as such moves can: start from a
+// feasible tour when there is one at hand.
+long long directed_or_opt(Tour& tour, long long z, const Oracle& D,
+                          const Neighbors& C,
+                          const std::vector<int>* dirty = 0);
+
+}  // namespace tpf
+
+#endif
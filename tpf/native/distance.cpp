@@ -0,0 +1,112 @@
+#include "distance.h"
+
+namespace tpf {
+
+namespace simd {
+
+int distance_scalar(EdgeWeightType type, Rounding rounding, double xi,
+                    double yi, double xj, double yj)
+{
+    return distance(type, rounding, xi, yi, xj, yj);
+}
+
+#ifdef TPF_X86
+void distances_sse41(EdgeWeightType type, Rounding rounding,
+                     const double* x, const double* y, int i, const int* js,
+                     int m, int* out);
+void distances_sse41(EdgeWeightType type, Rounding rounding,
+                     const double* x, const double* y, int i, int n, int* out);
+void distances_avx2(EdgeWeightType type, Rounding rounding, const double* x,
+                    const double* y, int i, const int* js, int m, int* out);
+void distances_avx2(EdgeWeightType type, Rounding rounding, const double* x,
+                    const double* y, int i, int n, int* out);
+#endif
+
+}  // namespace simd
+
+namespace {
+
+SimdLevel detect()
+{
+#ifdef TPF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SIMD_SSE41;
+#endif
+    return SIMD_SCALAR;
+}
+
+SimdLevel& current()
+{
+    static SimdLevel level = detect();
+    return level;
+}
+
+}  // namespace
+
+SimdLevel simd_level()
+{
+    return current();
+}
+
+void set_simd_level(SimdLevel level)
+{
+    SimdLevel best = detect();
+    current() = level < best ? level : best;
+}
+
+void distances(EdgeWeightType type, Rounding rounding, const double* x,
+               const double* y, int i, const int* js, int m, int* out)
+{
+    if (type == GEO) {
+        double lat = geo_radians(x[i]), lon = geo_radians(y[i]);
+        for (int k = 0; k < m; ++k)
+            out[k] = geo_distance(lat, lon, geo_radians(x[js[k]]),
+                                  geo_radians(y[js[k]]));
+        return;
+    }
+#ifdef TPF_X86
+    switch (current()) {
+    case SIMD_AVX2:
+        simd::distances_avx2(type, rounding, x, y, i, js, m, out);
+        return;
+    case SIMD_SSE41:
+        simd::distances_sse41(type, rounding, x, y, i, js, m, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    for (int k = 0; k < m; ++k)
+        out[k] = distance(type, rounding, x[i], y[i], x[js[k]], y[js[k]]);
+}
+
+void distances(EdgeWeightType type, Rounding rounding, const double* x,
+               const double* y, int i, int n, int* out)
+{
+    if (type == GEO) {
+        double lat = geo_radians(x[i]), lon = geo_radians(y[i]);
+        for (int j = 0; j < n; ++j)
+            out[j] = geo_distance(lat, lon, geo_radians(x[j]),
+                                  geo_radians(y[j]));
+        return;
+    }
+#ifdef TPF_X86
+    switch (current()) {
+    case SIMD_AVX2:
+        simd::distances_avx2(type, rounding, x, y, i, n, out);
+        return;
+    case SIMD_SSE41:
+        simd::distances_sse41(type, rounding, x, y, i, n, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    for (int j = 0; j < n; ++j)
+        out[j] = distance(type, rounding, x[i], y[i], x[j], y[j]);
+}
+
+}  // namespace tpf
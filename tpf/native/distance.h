@@ -0,0 +1,89 @@
+#ifndef TPF_DISTANCE_H
+#define TPF_DISTANCE_H
+
+#include <cmath>
+
+namespace tpf {
+
+enum EdgeWeightType { EUC_2D, CEIL_2D, MAN_2D, MAX_2D, ATT, GEO, EXPLICIT };
+
+// How EUC_2D, MAN_2D and MAX_2D distances are made integral: NINT is the
+// TSPLIB rule, TRUNCATE is what utils.py does.  CEIL_2D, ATT and GEO have
+// their own fixed rules.
+enum Rounding { NINT, TRUNCATE };
+
+// Instruction set used by the batch kernels.
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2 };
+
+// Best level supported by this CPU, unless lowered by set_simd_level().
+SimdLevel simd_level();
+
+// Force a lower level (e.g. SIMD_SCALAR to check the kernels against each
+// other); levels the CPU lacks are clamped.  Not thread-safe.
+void set_simd_level(SimdLevel level);
+
+// TSPLIB GEO: DDD.MM coordinate to radians.
+inline double geo_radians(double position)
+{
+    const double pi = 3.141592;
+    int deg = static_cast<int>(position);
+    double min = position - deg;
+    return pi * (deg + 5.0 * min / 3.0) / 180.0;
+}
+
+// TSPLIB GEO distance between two (latitude, longitude) pairs in radians.
+inline int geo_distance(double lat1, double lon1, double lat2, double lon2)
+{
+    // radius of Earth in kilometers
+    const double rrr = 6378.388;
+    double q1 = std::cos(lon1 - lon2);
+    double q2 = std::cos(lat1 - lat2);
+    double q3 = std::cos(lat1 + lat2);
+    return static_cast<int>(
+        rrr * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+}
+
+// Scalar distance kernel.  The batch kernels below perform exactly the
+// same IEEE operations in the same order, so their results are identical
+// to this one whatever the instruction set.
+inline int distance(EdgeWeightType type, Rounding rounding, double xi,
+                    double yi, double xj, double yj)
+{
+    double xd = xj - xi, yd = yj - yi;
+    double half = rounding == NINT ? 0.5 : 0.0;
+    switch (type) {
+    case EUC_2D:
+        return static_cast<int>(std::sqrt(xd * xd + yd * yd) + half);
+    case CEIL_2D:
+        return static_cast<int>(std::ceil(std::sqrt(xd * xd + yd * yd)));
+    case MAN_2D:
+        return static_cast<int>((std::fabs(xd) + std::fabs(yd)) + half);
+    case MAX_2D: {
+        int a = static_cast<int>(std::fabs(xd) + half);
+        int b = static_cast<int>(std::fabs(yd) + half);
+        return a > b ? a : b;
+    }
+    case ATT: {
+        double rij = std::sqrt((xd * xd + yd * yd) / 10.0);
+        double tij = std::trunc(rij + 0.5);
+        return static_cast<int>(tij < rij ? tij + 1.0 : tij);
+    }
+    case GEO:
+        return geo_distance(geo_radians(xi), geo_radians(yi), geo_radians(xj),
+                            geo_radians(yj));
+    default:
+        return 0;
+    }
+}
+
+// Distances from city i to cities js[0..m-1], for coordinates x, y.
+void distances(EdgeWeightType type, Rounding rounding, const double* x,
+               const double* y, int i, const int* js, int m, int* out);
+
+// Distances from city i to cities 0..n-1, for coordinates x, y.
+void distances(EdgeWeightType type, Rounding rounding, const double* x,
+               const double* y, int i, int n, int* out);
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,67 @@
+// AVX2 batch kernels; this file alone is compiled with -mavx2.
+#include <immintrin.h>
+
+#include "distance_simd.h"
+
+namespace tpf {
+namespace simd {
+
+namespace {
+
+struct Avx2 {
+    enum { width = 4 };
+    typedef __m256d V;
+
+    static V set1(double a) { return _mm256_set1_pd(a); }
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static V gather(const double* base, const int* idx)
+    {
+        __m128i vi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx));
+        // the masked form, as the plain one trips -Wmaybe-uninitialized
+        return _mm256_mask_i32gather_pd(
+            _mm256_setzero_pd(), base, vi,
+            _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+    }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static V trunc(V a)
+    {
+        return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    }
+    static V ceil(V a)
+    {
+        return _mm256_round_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+    }
+    // b where a < c, else 0
+    static V select_lt(V a, V c, V b)
+    {
+        return _mm256_and_pd(_mm256_cmp_pd(a, c, _CMP_LT_OQ), b);
+    }
+    static void store_int(int* out, V a)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         _mm256_cvttpd_epi32(a));
+    }
+};
+
+}  // namespace
+
+void distances_avx2(EdgeWeightType type, Rounding rounding, const double* x,
+                    const double* y, int i, const int* js, int m, int* out)
+{
+    distances<Avx2>(type, rounding, x, y, i, js, m, out);
+}
+
+void distances_avx2(EdgeWeightType type, Rounding rounding, const double* x,
+                    const double* y, int i, int n, int* out)
+{
+    distances<Avx2>(type, rounding, x, y, i, n, out);
+}
+
+}  // namespace simd
+}  // namespace tpf
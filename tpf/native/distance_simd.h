@@ -0,0 +1,84 @@
+// Batch distance kernels written once against a small vector interface S;
+// distance_sse41.cpp and distance_avx2.cpp instantiate them with their own
+// intrinsics.  Every step mirrors the scalar tpf::distance() so that both
+// give identical results.  Not for GEO, which is scalar only.
+#ifndef TPF_DISTANCE_SIMD_H
+#define TPF_DISTANCE_SIMD_H
+
+#include "distance.h"
+
+namespace tpf {
+namespace simd {
+
+// Out-of-line scalar kernel for the loop tails: the inline one must not be
+// instantiated in these translation units, which are built for another ISA.
+int distance_scalar(EdgeWeightType type, Rounding rounding, double xi,
+                    double yi, double xj, double yj);
+
+template <class S>
+inline typename S::V kernel(EdgeWeightType type, typename S::V half,
+                            typename S::V xd, typename S::V yd)
+{
+    typedef typename S::V V;
+    switch (type) {
+    case EUC_2D:
+        return S::trunc(S::add(S::sqrt(S::add(S::mul(xd, xd),
+                                              S::mul(yd, yd))),
+                               half));
+    case CEIL_2D:
+        return S::ceil(S::sqrt(S::add(S::mul(xd, xd), S::mul(yd, yd))));
+    case MAN_2D:
+        return S::trunc(S::add(S::add(S::abs(xd), S::abs(yd)), half));
+    case MAX_2D:
+        return S::max(S::trunc(S::add(S::abs(xd), half)),
+                      S::trunc(S::add(S::abs(yd), half)));
+    case ATT: {
+        V rij = S::sqrt(S::div(S::add(S::mul(xd, xd), S::mul(yd, yd)),
+                               S::set1(10.0)));
+        V tij = S::trunc(S::add(rij, S::set1(0.5)));
+        return S::add(tij, S::select_lt(tij, rij, S::set1(1.0)));
+    }
+    default:
+        return S::set1(0.0);
+    }
+}
+
+template <class S>
+void distances(EdgeWeightType type, Rounding rounding, const double* x,
+               const double* y, int i, const int* js, int m, int* out)
+{
+    typedef typename S::V V;
+    V xi = S::set1(x[i]), yi = S::set1(y[i]);
+    V half = S::set1(rounding == NINT ? 0.5 : 0.0);
+    int k = 0;
+    for (; k + S::width <= m; k += S::width) {
+        V xd = S::sub(S::gather(x, js + k), xi);
+        V yd = S::sub(S::gather(y, js + k), yi);
+        S::store_int(out + k, kernel<S>(type, half, xd, yd));
+    }
+    for (; k < m; ++k)
+        out[k] = distance_scalar(type, rounding, x[i], y[i], x[js[k]],
+                                 y[js[k]]);
+}
+
+template <class S>
+void distances(EdgeWeightType type, Rounding rounding, const double* x,
+               const double* y, int i, int n, int* out)
+{
+    typedef typename S::V V;
+    V xi = S::set1(x[i]), yi = S::set1(y[i]);
+    V half = S::set1(rounding == NINT ? 0.5 : 0.0);
+    int j = 0;
+    for (; j + S::width <= n; j += S::width) {
+        V xd = S::sub(S::load(x + j), xi);
+        V yd = S::sub(S::load(y + j), yi);
+        S::store_int(out + j, kernel<S>(type, half, xd, yd));
+    }
+    for (; j < n; ++j)
+        out[j] = distance_scalar(type, rounding, x[i], y[i], x[j], y[j]);
+}
+
+}  // namespace simd
+}  // namespace tpf
+
+#endif
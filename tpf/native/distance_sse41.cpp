@@ -0,0 +1,64 @@
+// SSE4.1 batch kernels; this file alone is compiled with -msse4.1.
+#include <smmintrin.h>
+
+#include "distance_simd.h"
+
+namespace tpf {
+namespace simd {
+
+namespace {
+
+struct Sse41 {
+    enum { width = 2 };
+    typedef __m128d V;
+
+    static V set1(double a) { return _mm_set1_pd(a); }
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static V gather(const double* base, const int* idx)
+    {
+        return _mm_set_pd(base[idx[1]], base[idx[0]]);
+    }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm_div_pd(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_pd(a); }
+    static V max(V a, V b) { return _mm_max_pd(a, b); }
+    static V abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static V trunc(V a)
+    {
+        return _mm_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    }
+    static V ceil(V a)
+    {
+        return _mm_round_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+    }
+    // b where a < c, else 0
+    static V select_lt(V a, V c, V b)
+    {
+        return _mm_and_pd(_mm_cmplt_pd(a, c), b);
+    }
+    static void store_int(int* out, V a)
+    {
+        __m128i v = _mm_cvttpd_epi32(a);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), v);
+    }
+};
+
+}  // namespace
+
+void distances_sse41(EdgeWeightType type, Rounding rounding,
+                     const double* x, const double* y, int i, const int* js,
+                     int m, int* out)
+{
+    distances<Sse41>(type, rounding, x, y, i, js, m, out);
+}
+
+void distances_sse41(EdgeWeightType type, Rounding rounding,
+                     const double* x, const double* y, int i, int n, int* out)
+{
+    distances<Sse41>(type, rounding, x, y, i, n, out);
+}
+
+}  // namespace simd
+}  // namespace tpf
@@ -0,0 +1,53 @@
+#include "graph.h"
+
+#include <stdexcept>
+
+namespace tpf {
+
+Graph::Graph(int n, int m, const int* tail, const int* head, const int* cost)
+    : n_(n), first_(n + 1, 0)
+{
+    for (int k = 0; k < m; ++k) {
+        if (tail[k] < 0 || tail[k] >= n || head[k] < 0 || head[k] >= n)
+            throw std::runtime_error("graph: city out of range");
+        if (cost[k] < 0 || cost[k] >= no_arc)
+            throw std::runtime_error("graph: arc cost out of range");
+        if (tail[k] != head[k])
+            ++first_[tail[k] + 1];
+    }
+    for (int i = 0; i < n; ++i)
+        first_[i + 1] += first_[i];
+    head_.resize(first_[n]);
+    cost_.resize(first_[n]);
+
+    std::vector<int> pos(first_.begin(), first_.end() - 1);
+    std::vector<std::pair<int, int> > row;
+    for (int k = 0; k < m; ++k)
+        if (tail[k] != head[k]) {
+            head_[pos[tail[k]]] = head[k];
+            cost_[pos[tail[k]]++] = cost[k];
+        }
+    for (int i = 0; i < n; ++i) {
+        row.clear();
+        for (int k = first_[i]; k < first_[i + 1]; ++k)
+            row.push_back(std::make_pair(head_[k], cost_[k]));
+        std::sort(row.begin(), row.end());
+        for (size_t r = 0; r < row.size(); ++r) {
+            if (r > 0 && row[r].first == row[r - 1].first)
+                throw std::runtime_error("graph: repeated arc");
+            head_[first_[i] + r] = row[r].first;
+            cost_[first_[i] + r] = row[r].second;
+        }
+    }
+}
+
+bool Graph::symmetric() const
+{
+    for (int i = 0; i < n_; ++i)
+        for (int k = first_[i]; k < first_[i + 1]; ++k)
+            if ((*this)(head_[k], i) != cost_[k])
+                return false;
+    return true;
+}
+
+}  // namespace tpf
@@ -0,0 +1,52 @@
+#ifndef TPF_GRAPH_H
+#define TPF_GRAPH_H
+
+#include <algorithm>
+#include <vector>
+
+namespace tpf {
+
+// Cost of the arcs a sparse graph does not have.  Tours through them are
+// infeasible; their length is at least no_arc.
+const int no_arc = 1000000000;
+
+// Sparse directed graph in compressed (CSR) form: the arcs leaving i go
+// to head[first[i]] .. head[first[i+1]-1], sorted by head, and cost
+// cost[k].  Every other arc is forbidden.
+class Graph {
+public:
+    Graph() : n_(0) {}
+
+    // Arc k goes from tail[k] to head[k] at cost[k], k < m.  Loops are
+    // dropped; throws std::runtime_error on cities out of range, repeated
+    // arcs and costs outside [0, no_arc).
+    Graph(int n, int m, const int* tail, const int* head, const int* cost);
+
+    int size() const { return n_; }
+    int arcs() const { return static_cast<int>(head_.size()); }
+
+    int begin(int i) const { return first_[i]; }
+    int end(int i) const { return first_[i + 1]; }
+    int head(int k) const { return head_[k]; }
+    int cost(int k) const { return cost_[k]; }
+
+    // Cost of the arc from i to j, no_arc if there is none.  O(log degree).
+    int operator()(int i, int j) const
+    {
+        const int* b = head_.data() + first_[i];
+        const int* e = head_.data() + first_[i + 1];
+        const int* k = std::lower_bound(b, e, j);
+        return k != e && *k == j ? cost_[k - head_.data()] : no_arc;
+    }
+
+    // Every arc has a reverse of the same cost.
+    bool symmetric() const;
+
+private:
+    int n_;
+    std::vector<int> first_, head_, cost_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,161 @@
+#include "ils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "active.h"
+#include "lk.h"
+#include "tour.h"
+
+namespace tpf {
+
+namespace {
+
+template <class T>
+class Iterated {
+public:
+    Iterated(T& t, const Oracle& D, const Neighbors& C, int moves,
+             const Control* control)
+        : t_(t), journal_(t), queue_(t.size()), D_(D), moves_(moves),
+          search_(journal_, D, C, moves & ~LIN_KERNIGHAN, queue_),
+          lk_(journal_, D, C, queue_), control_(control)
+    {
+        search_.set_control(control);
+        lk_.set_control(control);
+    }
+
+    long long run(long long z, std::mt19937& rng, long long iterations,
+                  double seconds, const Report& report)
+    {
+        typedef std::chrono::steady_clock clock;
+        clock::time_point start = clock::now();
+
+        std::vector<int> all(t_.size());
+        for (int c = 0; c < t_.size(); ++c)
+            all[c] = c;
+        z = local(z, all.data(), t_.size());
+        journal_.commit();
+        if (report)
+            report(z, t_.sequence());
+        if (control_)
+            control_->improved(z);
+
+        for (long long it = 0; iterations <= 0 || it < iterations; ++it) {
+            if (seconds > 0 &&
+                std::chrono::duration<double>(clock::now() - start).count()
+                    >= seconds)
+                break;
+            if (control_ && control_->stopped())
+                break;
+            int touched[6];
+            long long z2 = local(z + kick(rng, touched), touched, 6);
+            if (control_)
+                control_->count();
+            if (z2 <= z) {
+                journal_.commit();
+                if (z2 < z && report)
+                    report(z2, t_.sequence());
+                if (z2 < z && control_)
+                    control_->improved(z2);
+                z = z2;
+            } else {
+                journal_.revert();
+            }
+        }
+        return z;
+    }
+
+private:
+    // Local search from the given cities.  Lin-Kernighan goes first; the
+    // other moves then start again from the same cities.
+    long long local(long long z, const int* cities, int m)
+    {
+        for (int k = 0; k < m; ++k)
+            queue_.push(cities[k]);
+        if (moves_ & LIN_KERNIGHAN) {
+            z = lk_.run(z);
+            if (!(moves_ & ~LIN_KERNIGHAN))
+                return z;
+            for (int k = 0; k < m; ++k)
+                queue_.push(cities[k]);
+        }
+        return search_.run(z);
+    }
+
+    // Double bridge a b..c d..e f -> a d..e b..c f as three flips; returns
+    // the change in length.
+    long long kick(std::mt19937& rng, int* touched)
+    {
+        int n = t_.size();
+        int len = std::min(ils_segment, (n - 2) / 3);
+        int a = rng() % n;
+        int b = t_.next(a), c = b;
+        for (int k = 1 + rng() % len; k > 1; --k)
+            c = t_.next(c);
+        int d = t_.next(c), e = d;
+        for (int k = 1 + rng() % len; k > 1; --k)
+            e = t_.next(e);
+        int f = t_.next(e);
+
+        two_opt_move(journal_, a, b, e, f);      // a e..d c..b f
+        if (d != e)
+            two_opt_move(journal_, a, e, d, c);  // a d..e c..b f
+        if (b != c)
+            two_opt_move(journal_, e, c, b, f);  // a d..e b..c f
+
+        int cities[] = {a, b, c, d, e, f};
+        std::copy(cities, cities + 6, touched);
+        return static_cast<long long>(D_(a, d)) + D_(e, b) + D_(c, f)
+               - D_(a, b) - D_(c, d) - D_(e, f);
+    }
+
+    T& t_;
+    Journal<T> journal_;
+    ActiveQueue queue_;
+    const Oracle& D_;
+    int moves_;
+    Search<Journal<T> > search_;
+    LinKernighan<Journal<T> > lk_;
+    const Control* control_;
+};
+
+template <class T>
+long long run_ils(Tour& tour, long long z, const Oracle& D,
+                  const Neighbors& C, std::mt19937& rng,
+                  long long iterations, double seconds, int moves,
+                  const Report& report, const Control* control)
+{
+    if (!D.symmetric())
+        throw std::runtime_error(
+            "iterated_local_search needs symmetric distances");
+    T t(tour);
+    z = Iterated<T>(t, D, C, moves, control).run(z, rng, iterations,
+                                                 seconds, report);
+    tour = t.sequence();
+    return checked_length(tour, z, D);
+}
+
+}  // namespace
+
+long long iterated_local_search(Tour& tour, long long z, const Oracle& D,
+                                const Neighbors& C, std::mt19937& rng,
+                                long long iterations, double seconds,
+                                int moves, const Report& report,
+                                const Control* control)
+{
+    if (iterations <= 0 && seconds <= 0 && !control)
+        throw std::runtime_error("iterated_local_search: no budget given");
+    if (tour.size() < 8)
+        return optimize(tour, z, D, C, moves);
+    switch (tour_kind(AUTO_TOUR, static_cast<int>(tour.size()))) {
+    case TWO_LEVEL_TOUR:
+        return run_ils<TwoLevelTour>(tour, z, D, C, rng, iterations,
+                                     seconds, moves, report, control);
+    default:
+        return run_ils<ArrayTour>(tour, z, D, C, rng, iterations, seconds,
+                                  moves, report, control);
+    }
+}
+
+}  // namespace tpf
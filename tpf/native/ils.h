@@ -0,0 +1,41 @@
+#ifndef TPF_ILS_H
+#define TPF_ILS_H
+
+#include <random>
+
+#include "control.h"
+#include "localsearch.h"
+#include "moves.h"
+
+namespace tpf {
+
+// Iterated local search.
+//
+// The tour is first brought to a local optimum with the given moves, as in
+// optimize().  Each iteration then kicks it with a double bridge on two
+// short consecutive segments (a b..c d..e f becomes a d..e b..c f),
+// re-optimises from the six cities at the changed edges only, and keeps
+// the result if it is no longer; otherwise the flips of the iteration are
+// undone.  The tour structure persists across iterations, so an iteration
+// costs in proportion to what it changes rather than to n.
+//
+// Stops after 'iterations' kicks or 'seconds' of wall-clock time,
+// whichever comes first; 0 means no limit, but one of them must be set
+// unless there is a 'control'.  That stops the search from other threads
+// or at its own deadline, between moves, and hears of each new best
+// length and each kick (control.h).  'report' is called with each new
+// best tour.  Returns the final length.  Needs symmetric distances, as
+// Lin-Kernighan and 2-opt do; throws std::runtime_error otherwise.
+long long iterated_local_search(Tour& tour, long long z, const Oracle& D,
+                                const Neighbors& C, std::mt19937& rng,
+                                long long iterations, double seconds = 0,
+                                int moves = OR2OPT,
+                                const Report& report = Report(),
+                                const Control* control = 0);
+
+// Longest segment a double-bridge kick moves.
+const int ils_segment = 50;
+
+}  // namespace tpf
+
+#endif
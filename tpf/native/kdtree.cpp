@@ -0,0 +1,212 @@
+#include "kdtree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace tpf {
+
+namespace {
+
+const int bucket_size = 8;
+
+}  // namespace
+
+// A bounded max-heap of (distance, index) holding the best k so far.
+struct KdTree::Query {
+    double px, py;
+    int self;
+    int k;
+    int quadrant;
+    std::vector<std::pair<double, int> > heap;
+
+    double worst() const { return heap.front().first; }
+    bool full() const { return static_cast<int>(heap.size()) == k; }
+
+    void offer(double d, int j)
+    {
+        std::pair<double, int> item(d, j);
+        if (!full()) {
+            heap.push_back(item);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (item < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = item;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+};
+
+KdTree::KdTree(const double* x, const double* y, int n, Metric metric,
+               const Control* control)
+    : x_(x), y_(y), n_(n), metric_(metric), perm_(n), leaf_(n), in_(n, 1)
+{
+    for (int i = 0; i < n; ++i)
+        perm_[i] = i;
+    nodes_.reserve(2 * (n / bucket_size + 1));
+    if (n > 0)
+        build(0, n, -1, control);
+}
+
+int KdTree::build(int lo, int hi, int parent, const Control* control)
+{
+    int id = static_cast<int>(nodes_.size());
+    nodes_.push_back(Node());
+    Node node;
+    node.lo = lo;
+    node.hi = hi;
+    node.left = node.right = -1;
+    node.parent = parent;
+    node.count = hi - lo;
+    node.xmin = node.ymin = HUGE_VAL;
+    node.xmax = node.ymax = -HUGE_VAL;
+    for (int k = lo; k < hi; ++k) {
+        int i = perm_[k];
+        node.xmin = std::min(node.xmin, x_[i]);
+        node.xmax = std::max(node.xmax, x_[i]);
+        node.ymin = std::min(node.ymin, y_[i]);
+        node.ymax = std::max(node.ymax, y_[i]);
+    }
+
+    if (hi - lo > bucket_size && !(control && control->stopped())) {
+        // split the wider side at the median
+        bool by_x = node.xmax - node.xmin >= node.ymax - node.ymin;
+        const double* c = by_x ? x_ : y_;
+        int mid = lo + (hi - lo) / 2;
+        std::nth_element(perm_.begin() + lo, perm_.begin() + mid,
+                         perm_.begin() + hi, [c](int a, int b) {
+                             return c[a] < c[b] || (c[a] == c[b] && a < b);
+                         });
+        node.left = build(lo, mid, id, control);
+        node.right = build(mid, hi, id, control);
+    } else {
+        for (int k = lo; k < hi; ++k)
+            leaf_[perm_[k]] = id;
+    }
+    nodes_[id] = node;
+    return id;
+}
+
+void KdTree::add(int i, int delta)
+{
+    for (int id = leaf_[i]; id >= 0; id = nodes_[id].parent)
+        nodes_[id].count += delta;
+}
+
+void KdTree::erase(int i)
+{
+    if (in_[i]) {
+        in_[i] = 0;
+        add(i, -1);
+    }
+}
+
+void KdTree::insert(int i)
+{
+    if (!in_[i]) {
+        in_[i] = 1;
+        add(i, 1);
+    }
+}
+
+double KdTree::dist(double dx, double dy) const
+{
+    dx = std::fabs(dx);
+    dy = std::fabs(dy);
+    switch (metric_) {
+    case L1: return dx + dy;
+    case LINF: return std::max(dx, dy);
+    default: return dx * dx + dy * dy;
+    }
+}
+
+double KdTree::box_dist(const Node& node, double px, double py) const
+{
+    double dx = px < node.xmin ? node.xmin - px
+                               : (px > node.xmax ? px - node.xmax : 0.0);
+    double dy = py < node.ymin ? node.ymin - py
+                               : (py > node.ymax ? py - node.ymax : 0.0);
+    return dist(dx, dy);
+}
+
+bool KdTree::in_quadrant(double dx, double dy, int quadrant) const
+{
+    switch (quadrant) {
+    case 0: return dx > 0 && dy >= 0;
+    case 1: return dx <= 0 && dy > 0;
+    case 2: return dx < 0 && dy <= 0;
+    case 3: return dx >= 0 && dy < 0;
+    default: return true;
+    }
+}
+
+bool KdTree::box_meets_quadrant(const Node& node, double px, double py,
+                                int quadrant) const
+{
+    switch (quadrant) {
+    case 0: return node.xmax > px && node.ymax >= py;
+    case 1: return node.xmin <= px && node.ymax > py;
+    case 2: return node.xmin < px && node.ymin <= py;
+    case 3: return node.xmax >= px && node.ymin < py;
+    default: return true;
+    }
+}
+
+void KdTree::search(int id, Query& q) const
+{
+    const Node& node = nodes_[id];
+    if (node.count == 0)
+        return;
+    if (q.full() && box_dist(node, q.px, q.py) > q.worst())
+        return;
+    if (!box_meets_quadrant(node, q.px, q.py, q.quadrant))
+        return;
+
+    if (node.left < 0) {
+        for (int k = node.lo; k < node.hi; ++k) {
+            int j = perm_[k];
+            if (j == q.self || !in_[j])
+                continue;
+            double dx = x_[j] - q.px, dy = y_[j] - q.py;
+            if (q.quadrant >= 0 && !in_quadrant(dx, dy, q.quadrant))
+                continue;
+            q.offer(dist(dx, dy), j);
+        }
+        return;
+    }
+
+    // nearer child first, so the bound tightens early
+    int first = node.left, second = node.right;
+    if (box_dist(nodes_[second], q.px, q.py)
+        < box_dist(nodes_[first], q.px, q.py))
+        std::swap(first, second);
+    search(first, q);
+    search(second, q);
+}
+
+void KdTree::nearest(int i, int k, std::vector<int>& out, int quadrant) const
+{
+    Query q;
+    q.px = x_[i];
+    q.py = y_[i];
+    q.self = i;
+    q.k = k;
+    q.quadrant = quadrant;
+    q.heap.reserve(k);
+    out.clear();
+    if (k <= 0 || n_ == 0)
+        return;
+    search(0, q);
+    std::sort_heap(q.heap.begin(), q.heap.end());
+    for (size_t m = 0; m < q.heap.size(); ++m)
+        out.push_back(q.heap[m].second);
+}
+
+int KdTree::nearest(int i) const
+{
+    std::vector<int> out;
+    nearest(i, 1, out);
+    return out.empty() ? -1 : out[0];
+}
+
+}  // namespace tpf
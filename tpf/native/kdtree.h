@@ -0,0 +1,76 @@
+#ifndef TPF_KDTREE_H
+#define TPF_KDTREE_H
+
+#include <vector>
+
+#include "control.h"
+
+namespace tpf {
+
+// 2-d tree over a set of points stored as a structure of arrays.  Built in
+// O(n log n) by median splits; leaves hold small buckets of points.  Once
+// 'control', if given, stops, the build splits no further: the tree still
+// answers every query, only its last leaves are large and slow to scan.
+class KdTree {
+public:
+    enum Metric { L2, L1, LINF };
+
+    // Quadrants around a query point, counter-clockwise from +x +y.
+    // Points on an axis belong to the quadrant that follows it.
+    enum { ALL_QUADRANTS = -1 };
+
+    KdTree(const double* x, const double* y, int n, Metric metric = L2,
+           const Control* control = 0);
+
+    int size() const { return n_; }
+
+    // The k points closest to point i (i itself excluded), nearest first,
+    // ties broken by index.  With quadrant >= 0 only points in that
+    // quadrant around i are considered.  Erased points are skipped.
+    void nearest(int i, int k, std::vector<int>& out,
+                 int quadrant = ALL_QUADRANTS) const;
+
+    // The nearest point to point i that is not erased, or -1.
+    int nearest(int i) const;
+
+    // Points can be taken out of the queries and put back, in O(log n):
+    // construction heuristics erase the cities they have used.  All points
+    // are in after construction.
+    void erase(int i);
+    void insert(int i);
+    bool contains(int i) const { return in_[i] != 0; }
+    int count() const { return nodes_.empty() ? 0 : nodes_[0].count; }
+
+private:
+    struct Node {
+        int lo, hi;         // points perm_[lo..hi)
+        int left, right;    // children, -1 for a leaf
+        int parent;
+        int count;          // points not erased
+        double xmin, xmax, ymin, ymax;
+    };
+
+    struct Query;
+
+    int build(int lo, int hi, int parent, const Control* control);
+    void add(int i, int delta);
+    double dist(double dx, double dy) const;
+    double box_dist(const Node& node, double px, double py) const;
+    bool in_quadrant(double dx, double dy, int quadrant) const;
+    bool box_meets_quadrant(const Node& node, double px, double py,
+                            int quadrant) const;
+    void search(int node, Query& q) const;
+
+    const double* x_;
+    const double* y_;
+    int n_;
+    Metric metric_;
+    std::vector<int> perm_;
+    std::vector<Node> nodes_;
+    std::vector<int> leaf_;  // leaf holding each point
+    std::vector<char> in_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,58 @@
+#include "lk.h"
+
+#include <stdexcept>
+
+#include "localsearch.h"
+
+namespace tpf {
+
+namespace {
+
+template <class T>
+long long run_lk(std::vector<int>& tour, long long z, const Oracle& D,
+                 const Neighbors& C, const std::vector<int>* dirty)
+{
+    if (!D.symmetric())
+        throw std::runtime_error("lin_kernighan needs symmetric distances");
+    T t(tour);
+    ActiveQueue queue(t.size());
+    if (dirty)
+        for (size_t k = 0; k < dirty->size(); ++k)
+            queue.push((*dirty)[k]);
+    else
+        queue.push_all();
+    z = LinKernighan<T>(t, D, C, queue).run(z);
+    tour = t.sequence();
+    return checked_length(tour, z, D);
+}
+
+long long lin_kernighan(std::vector<int>& tour, long long z, const Oracle& D,
+                        const Neighbors& C, TourKind kind,
+                        const std::vector<int>* dirty)
+{
+    switch (tour_kind(kind, static_cast<int>(tour.size()))) {
+    case LINKED_TOUR:
+        return run_lk<LinkedTour>(tour, z, D, C, dirty);
+    case TWO_LEVEL_TOUR:
+        return run_lk<TwoLevelTour>(tour, z, D, C, dirty);
+    default:
+        return run_lk<ArrayTour>(tour, z, D, C, dirty);
+    }
+}
+
+}  // namespace
+
+long long lin_kernighan(std::vector<int>& tour, long long z, const Oracle& D,
+                        const Neighbors& C, TourKind kind)
+{
+    return lin_kernighan(tour, z, D, C, kind, 0);
+}
+
+long long lin_kernighan(std::vector<int>& tour, long long z, const Oracle& D,
+                        const Neighbors& C, const std::vector<int>& dirty,
+                        TourKind kind)
+{
+    return lin_kernighan(tour, z, D, C, kind, &dirty);
+}
+
+}  // namespace tpf
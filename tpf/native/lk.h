@@ -0,0 +1,186 @@
+#ifndef TPF_LK_H
+#define TPF_LK_H
+
+#include <utility>
+#include <vector>
+
+#include "active.h"
+#include "control.h"
+#include "counters.h"
+#include "neighbors.h"
+#include "oracle.h"
+#include "tour.h"
+
+namespace tpf {
+
+// Lin-Kernighan local search.
+//
+// From each active city t1 a sequential exchange is grown one edge pair at
+// a time: edge (t1,t2) is removed, (t2,t3) added for a candidate t3 while
+// the partial gain stays positive, and (t3,t4) removed so that closing up
+// with (t4,t1) gives a tour again.  Every step is a flip.  The first five
+// levels backtrack over several t3 (lk_breadth), so that all sequential
+// 5-opt moves the candidate lists lead to are tried; deeper levels follow
+// only the first candidate in neighbour order, i.e. the nearest, whose
+// partial gain is positive, up to lk_max_depth.  An edge added in a step is
+// never removed again in the same move.  The best closed-up tour along the
+// way is kept, and a queue of active cities (active.h) restricts the
+// search to cities near the last changes.  Throws std::runtime_error on
+// asymmetric distances.
+long long lin_kernighan(std::vector<int>& tour, long long z, const Oracle& D,
+                        const Neighbors& C, TourKind kind = AUTO_TOUR);
+
+// As above, but only the cities in 'dirty' are active at first, e.g. the
+// endpoints of the edges a perturbation changed.
+long long lin_kernighan(std::vector<int>& tour, long long z, const Oracle& D,
+                        const Neighbors& C, const std::vector<int>& dirty,
+                        TourKind kind = AUTO_TOUR);
+
+const int lk_max_depth = 50;
+const int lk_breadth[] = {5, 5, 3, 2, 2};
+
+// The search behind lin_kernighan(); like Search (moves.h) it works on any
+// tour type and takes its cities from a queue the caller fills.
+template <class T>
+class LinKernighan {
+public:
+    LinKernighan(T& t, const Oracle& D, const Neighbors& C,
+                 ActiveQueue& queue)
+        : t_(t), D_(D), C_(C), queue_(queue), control_(0),
+          evaluated_(0), applied_(0)
+    {
+    }
+
+    ~LinKernighan()
+    {
+        search_counters().evaluated += evaluated_;
+        search_counters().applied += applied_;
+    }
+
+    // As Search::set_control().
+    void set_control(const Control* control) { control_ = control; }
+
+    long long run(long long z)
+    {
+        if (t_.size() < 8) {
+            queue_.clear();
+            return z;
+        }
+        while (!queue_.empty() && !(control_ && control_->stopped())) {
+            int t1 = queue_.pop();
+            long long gain;
+            while ((gain = improve(t1)) > 0) {
+                z -= gain;
+                ++applied_;
+            }
+        }
+        return z;
+    }
+
+private:
+    struct Flip {
+        int a, b, c, d;
+    };
+
+    // Try both tour neighbours of t1 as t2; return the gain of the move
+    // applied, or 0.
+    long long improve(int t1)
+    {
+        for (int dir = 0; dir < 2; ++dir) {
+            int t2 = dir == 0 ? t_.next(t1) : t_.prev(t1);
+            best_gain_ = 0;
+            best_len_ = 0;
+            t1_ = t1;
+            step(1, t2, D_(t1, t2));
+            if (best_gain_ > 0) {
+                while (static_cast<int>(flips_.size()) > best_len_)
+                    undo();
+                for (size_t k = 0; k < flips_.size(); ++k) {
+                    const Flip& f = flips_[k];
+                    wake(f.a), wake(f.b), wake(f.c), wake(f.d);
+                }
+                flips_.clear();
+                added_.clear();
+                return best_gain_;
+            }
+        }
+        return 0;
+    }
+
+    // t1..t2 is the edge to remove next; 'gain' is the length removed so
+    // far minus the length added, (t1,t2) included.
+    void step(int level, int t2, long long gain)
+    {
+        if (control_ && control_->stopped())
+            return;  // unwinds like a dead end
+        int breadth = level <= 5 ? lk_breadth[level - 1] : 1;
+        int tried = 0;
+        for (int k = C_.begin(t2); k < C_.end(t2) && tried < breadth; ++k) {
+            int t3 = C_.city[k];
+            long long g1 = gain - C_.dist[k];
+            if (g1 <= 0)
+                break;
+            if (t3 == t_.next(t2) || t3 == t_.prev(t2))
+                continue;
+            int t4 = t_.next(t1_) == t2 ? t_.prev(t3) : t_.next(t3);
+            if (was_added(t3, t4))
+                continue;
+            ++tried;
+            ++evaluated_;
+
+            two_opt_move(t_, t1_, t2, t4, t3);
+            Flip f = {t1_, t2, t4, t3};
+            flips_.push_back(f);
+            added_.push_back(std::make_pair(t2, t3));
+
+            long long g2 = g1 + D_(t3, t4);
+            long long closed = g2 - D_(t4, t1_);
+            if (closed > best_gain_) {
+                best_gain_ = closed;
+                best_len_ = static_cast<int>(flips_.size());
+            }
+            if (level < lk_max_depth)
+                step(level + 1, t4, g2);
+            if (best_gain_ > 0)
+                return;
+            undo();
+        }
+    }
+
+    void undo()
+    {
+        const Flip& f = flips_.back();
+        // the flip left edges (a,c) and (b,d); put (a,b) and (c,d) back
+        two_opt_move(t_, f.a, f.c, f.b, f.d);
+        flips_.pop_back();
+        added_.pop_back();
+    }
+
+    bool was_added(int a, int b) const
+    {
+        for (size_t k = 0; k < added_.size(); ++k)
+            if ((added_[k].first == a && added_[k].second == b)
+                || (added_[k].first == b && added_[k].second == a))
+                return true;
+        return false;
+    }
+
+    void wake(int c) { queue_.push(c); }
+
+    T& t_;
+    const Oracle& D_;
+    const Neighbors& C_;
+    ActiveQueue& queue_;
+    const Control* control_;
+    long long evaluated_, applied_;  // added to search_counters() at the end
+
+    int t1_;
+    long long best_gain_;
+    int best_len_;
+    std::vector<Flip> flips_;
+    std::vector<std::pair<int, int> > added_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,270 @@
+#include "localsearch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+
+#include "moves.h"
+#include "pool.h"
+
+namespace tpf {
+
+long long length(const Tour& tour, const Oracle& D)
+{
+    if (tour.empty())
+        return 0;
+    long long z = D(tour.back(), tour.front());
+    for (size_t i = 1; i < tour.size(); ++i)
+        z += D(tour[i - 1], tour[i]);
+    return z;
+}
+
+long long checked_length(const Tour& tour, long long z, const Oracle& D)
+{
+#ifndef NDEBUG
+    assert(z == length(tour, D));
+#else
+    (void)tour;
+    (void)D;
+#endif
+    return z;
+}
+
+Tour randtour(int n, std::mt19937& rng)
+{
+    Tour sol(n);
+    for (int i = 0; i < n; ++i)
+        sol[i] = i;
+    // Fisher-Yates with our own index draw, so that a seed gives the same
+    // tour whatever the standard library's distributions do
+    for (int i = n - 1; i > 0; --i) {
+        int j = static_cast<int>((static_cast<uint64_t>(rng()) * (i + 1)) >> 32);
+        std::swap(sol[i], sol[j]);
+    }
+    return sol;
+}
+
+Tour nearest_neighbor(int i, const Oracle& D, const Control* control)
+{
+    int n = D.size();
+    std::vector<int> unvisited;
+    unvisited.reserve(n);
+    for (int j = 0; j < n; ++j)
+        if (j != i)
+            unvisited.push_back(j);
+
+    Tour tour(1, i);
+    tour.reserve(n);
+    int last = i;
+    while (!unvisited.empty()) {
+        if (control && control->stopped()) {
+            tour.resize(n);
+            for (int j = 0; j < n; ++j)
+                tour[j] = j;
+            return tour;
+        }
+        const int* dist = D.row(last);
+        int m = static_cast<int>(unvisited.size());
+        int best = 0;
+        for (int k = 1; k < m; ++k) {
+            int d = dist[unvisited[k]], dbest = dist[unvisited[best]];
+            if (d < dbest || (d == dbest && unvisited[k] < unvisited[best]))
+                best = k;
+        }
+        last = unvisited[best];
+        tour.push_back(last);
+        unvisited[best] = unvisited.back();
+        unvisited.pop_back();
+    }
+    return tour;
+}
+
+long long exchange_cost(const Tour& tour, int i, int j, const Oracle& D)
+{
+    int n = static_cast<int>(tour.size());
+    int a = tour[i], b = tour[(i + 1) % n];
+    int c = tour[j], d = tour[(j + 1) % n];
+    return static_cast<long long>(D(a, c)) + D(b, d) - D(a, b) - D(c, d);
+}
+
+void exchange(Tour& tour, std::vector<int>& tinv, int i, int j)
+{
+    if (i > j)
+        std::swap(i, j);
+    assert(i >= 0 && i < j - 1 && j < static_cast<int>(tour.size()));
+    std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+    for (int k = i + 1; k <= j; ++k)
+        tinv[tour[k]] = k;
+}
+
+long long improve(Tour& tour, long long z, const Oracle& D, const Neighbors& C)
+{
+    int n = static_cast<int>(tour.size());
+    std::vector<int> tinv(n);
+    for (int k = 0; k < n; ++k)
+        tinv[tour[k]] = k;  // position of each city in 'tour'
+
+    for (int i = 0; i < n; ++i) {
+        int a = tour[i], b = tour[(i + 1) % n];
+        int dist_ab = D(a, b);
+        bool improved = false;
+        for (int k = C.begin(a); k < C.end(a); ++k) {
+            int dist_ac = C.dist[k], c = C.city[k];
+            if (dist_ac >= dist_ab)
+                break;
+            int j = tinv[c];
+            int d = tour[(j + 1) % n];
+            long long delta = static_cast<long long>(dist_ac) + D(b, d)
+                              - dist_ab - D(c, d);
+            if (delta < 0) {  // exchange decreases length
+                exchange(tour, tinv, i, j);
+                z += delta;
+                improved = true;
+                break;
+            }
+        }
+        if (improved)
+            continue;
+        for (int k = C.begin(b); k < C.end(b); ++k) {
+            int dist_bd = C.dist[k], d = C.city[k];
+            if (dist_bd >= dist_ab)
+                break;
+            int j = tinv[d] - 1;
+            if (j == -1)
+                j = n - 1;
+            int c = tour[j];
+            long long delta = static_cast<long long>(D(a, c)) + dist_bd
+                              - dist_ab - D(c, d);
+            if (delta < 0) {  // exchange decreases length
+                exchange(tour, tinv, i, j);
+                z += delta;
+                break;
+            }
+        }
+    }
+    return z;
+}
+
+long long localsearch(Tour& tour, long long z, const Oracle& D,
+                      const Neighbors& C)
+{
+    if (!D.symmetric())
+        throw std::runtime_error("localsearch needs symmetric distances");
+    for (;;) {
+        long long newz = improve(tour, z, D, C);
+        if (newz < z)
+            z = newz;
+        else
+            break;
+    }
+    return checked_length(tour, z, D);
+}
+
+Solution multistart_localsearch(int k, const Oracle& D, const Neighbors& C,
+                                std::mt19937& rng, const Report& report,
+                                int moves, long long target)
+{
+    Solution best;
+    best.z = -1;
+    for (int i = 0; i < k; ++i) {
+        Tour tour = randtour(D.size(), rng);
+        long long z = length(tour, D);
+        z = moves ? optimize(tour, z, D, C, moves)
+                  : localsearch(tour, z, D, C);
+        if (best.z < 0 || z < best.z) {
+            best.z = z;
+            best.tour = tour;
+            if (report)
+                report(z, tour);
+            if (z <= target)
+                break;
+        }
+    }
+    return best;
+}
+
+Solution multistart_localsearch(int k, const Oracle& D, const Neighbors& C,
+                                unsigned seed, int threads,
+                                const Report& report, int moves,
+                                long long target)
+{
+    enum { PENDING, DONE, FAILED };
+    ThreadPool pool(threads);
+    std::vector<Oracle> oracles(pool.size(), D);
+    std::vector<Solution> slots(k);
+    std::vector<char> state(k, PENDING);
+    std::mutex mutex;
+    std::condition_variable finished;
+    Incumbent best(slots);
+    std::atomic<int> stop(k);  // restarts after this one are not needed
+
+    for (int i = 0; i < k; ++i) {
+        pool.submit([&, i](int w) {
+            char result = FAILED;
+            try {
+                if (i > stop.load()) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    state[i] = DONE;
+                    finished.notify_one();
+                    return;
+                }
+                std::seed_seq seq{seed, static_cast<unsigned>(i)};
+                std::mt19937 rng(seq);
+                const Oracle& Dw = oracles[w];
+                Solution& s = slots[i];
+                s.tour = randtour(Dw.size(), rng);
+                s.z = length(s.tour, Dw);
+                s.z = moves ? optimize(s.tour, s.z, Dw, C, moves)
+                            : localsearch(s.tour, s.z, Dw, C);
+                best.offer(i);
+                result = DONE;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                state[i] = result;
+                finished.notify_one();
+                throw;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            state[i] = result;
+            finished.notify_one();
+        });
+    }
+
+    // Report in restart order, dropping the tours that cannot be the best.
+    int prefix = -1;
+    for (int i = 0; i < k; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return state[i] != PENDING; });
+            if (state[i] == FAILED)
+                break;
+        }
+        if (prefix >= 0 && slots[i].z >= slots[prefix].z) {
+            Tour().swap(slots[i].tour);
+            continue;
+        }
+        if (prefix >= 0)
+            Tour().swap(slots[prefix].tour);
+        prefix = i;
+        if (report)
+            report(slots[i].z, slots[i].tour);
+        if (slots[i].z <= target) {
+            stop = i;
+            break;
+        }
+    }
+    pool.wait();
+
+    Solution result;
+    result.z = -1;
+    if (stop < k)
+        result = slots[prefix];
+    else if (best.best() >= 0)
+        result = slots[best.best()];
+    return result;
+}
+
+}  // namespace tpf
@@ -0,0 +1,125 @@
+#ifndef TPF_LOCALSEARCH_H
+#define TPF_LOCALSEARCH_H
+
+#include <atomic>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "control.h"
+#include "neighbors.h"
+#include "oracle.h"
+
+namespace tpf {
+
+typedef std::vector<int> Tour;
+
+struct Solution {
+    Tour tour;
+    long long z;
+};
+
+// Called with the length and tour of each new best solution.
+typedef std::function<void(long long z, const Tour& tour)> Report;
+
+// Calculate the length of a tour according to distances 'D'.  Lengths and
+// move deltas are summed in 64 bits throughout, so that searches keeping
+// the length up to date from deltas never drift from it.
+long long length(const Tour& tour, const Oracle& D);
+
+// Return 'z', the length of 'tour' kept up to date from the deltas of the
+// moves applied to it.  Debug builds check it against length(tour, D).
+long long checked_length(const Tour& tour, long long z, const Oracle& D);
+
+// Construct a random tour of size 'n'.
+Tour randtour(int n, std::mt19937& rng);
+
+// Return tour starting from city 'i', using the Nearest Neighbor heuristic
+// (ties go to the lowest city index, as in utils.py).  Once 'control', polled
+// at every city, stops, the cities in index order instead.
+Tour nearest_neighbor(int i, const Oracle& D, const Control* control = 0);
+
+// Calculate the cost of exchanging arcs (i,i+1) and (j,j+1) by (i,j) and
+// (i+1,j+1), where i and j are positions in the tour.
+long long exchange_cost(const Tour& tour, int i, int j, const Oracle& D);
+
+// Exchange arcs (i,i+1) and (j,j+1) with (i,j) and (i+1,j+1) by reversing
+// the cities between positions i+1 and j; 'tinv' is kept up to date.
+void exchange(Tour& tour, std::vector<int>& tinv, int i, int j);
+
+// One first-improvement 2-opt sweep over all cities; returns the new length.
+long long improve(Tour& tour, long long z, const Oracle& D, const Neighbors& C);
+
+// Repeat improve() until reaching a local optimum; returns its length.
+// Throws std::runtime_error on asymmetric distances, which 2-opt breaks.
+long long localsearch(Tour& tour, long long z, const Oracle& D,
+                      const Neighbors& C);
+
+// Do k iterations of local search, starting from random solutions.  With
+// moves = 0 this is utils.py's localsearch(); otherwise optimize() with
+// those moves (see moves.h).  Stops early once a tour of length 'target'
+// or less is found (-1 for none), e.g. gap_target() of a lower bound.
+Solution multistart_localsearch(int k, const Oracle& D, const Neighbors& C,
+                                std::mt19937& rng,
+                                const Report& report = Report(),
+                                int moves = 0, long long target = -1);
+
+// Parallel version: the restarts are spread over a work-stealing pool of
+// 'threads' threads (0 for one per hardware thread), each with its own
+// copy of D; the candidate lists are shared.  Restart i starts from a
+// random tour drawn with a generator seeded from (seed, i), so the result
+// depends on the seed only, whatever the number of threads.  'report' is
+// called from the calling thread, in restart order, exactly as a
+// sequential run would call it.  With a target, the result is the best of
+// the restarts up to the first one reaching it, as sequentially; restarts
+// after that one are skipped if they have not begun.
+Solution multistart_localsearch(int k, const Oracle& D, const Neighbors& C,
+                                unsigned seed, int threads,
+                                const Report& report = Report(),
+                                int moves = 0, long long target = -1);
+
+// Best of a set of solutions filled concurrently, one slot per search.
+// offer(i) publishes slot i, which must not change afterwards, with a
+// compare-and-swap loop; ties go to the lowest slot, so the outcome does
+// not depend on timing.
+class Incumbent {
+public:
+    explicit Incumbent(const std::vector<Solution>& slots)
+        : slots_(slots), best_(-1)
+    {
+    }
+
+    // Whether slot i became the incumbent.
+    bool offer(int i)
+    {
+        int cur = best_.load();
+        while (cur < 0 || better(i, cur))
+            if (best_.compare_exchange_weak(cur, i))
+                return true;
+        return false;
+    }
+
+    // The incumbent slot, or -1.
+    int best() const { return best_.load(); }
+
+    // Length of the incumbent, or -1.
+    long long z() const
+    {
+        int b = best_.load();
+        return b < 0 ? -1 : slots_[b].z;
+    }
+
+private:
+    bool better(int i, int j) const
+    {
+        return slots_[i].z < slots_[j].z ||
+               (slots_[i].z == slots_[j].z && i < j);
+    }
+
+    const std::vector<Solution>& slots_;
+    std::atomic<int> best_;
+};
+
+}  // namespace tpf
+
+#endif
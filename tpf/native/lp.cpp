@@ -0,0 +1,409 @@
+#include "lp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace tpf {
+
+#ifdef TPF_CPLEX
+std::unique_ptr<Lp> mk_cplex_lp();  // lp_cplex.cpp
+#endif
+
+namespace {
+
+const double inf = std::numeric_limits<double>::infinity();
+const double primal_tol = 1e-7;
+const double dual_tol = 1e-9;
+const double pivot_tol = 1e-9;
+const int refactor_pivots = 500;
+
+// Bounded dual simplex on a dense tableau, for the small programs of the
+// tests and of small instances.
+//
+// Every row i gets a slack s_i (a x + s_i = b, s_i >= 0 on <= rows,
+// <= 0 on >= rows, = 0 on equations), so the slacks form the initial
+// basis, which is dual feasible whenever the columns are at the bound
+// their cost points to.  Only the dual simplex is needed: new rows come in
+// with their slack basic; new columns and bound changes leave the slacks'
+// reduced costs alone, and the columns, all bounded, are moved to the
+// bound their reduced cost points to before each solve.
+//
+// Variables are the columns and slacks in order of creation; T holds
+// B^-1 [A I] row by row and d the reduced costs.  The tableau is rebuilt
+// from the rows every refactor_pivots pivots to shed rounding.
+class SimplexLp : public Lp {
+public:
+    SimplexLp() : pivots_(0) {}
+
+    int rows() const { return static_cast<int>(rhs_.size()); }
+    int columns() const { return static_cast<int>(col_var_.size()); }
+
+    int add_column(double cost, double lower, double upper,
+                   const std::vector<int>& rows,
+                   const std::vector<double>& coefs)
+    {
+        if (lower == -inf || upper == inf)
+            throw std::runtime_error("simplex: columns must be bounded");
+        int j = columns(), v = add_var(cost, lower, upper);
+        col_var_.push_back(v);
+        int m = this->rows();
+        // B^-1 a from the slack columns of T
+        std::vector<double> col(m, 0);
+        double dj = cost;
+        for (size_t k = 0; k < rows.size(); ++k) {
+            int i = rows[k];
+            a_[i].push_back(std::make_pair(j, coefs[k]));
+            int s = row_var_[i];
+            for (int r = 0; r < m; ++r)
+                col[r] += T_[r][s] * coefs[k];
+            dj += d_[s] * coefs[k];
+        }
+        for (int r = 0; r < m; ++r) {
+            T_[r][v] = col[r];
+            x_[head_[r]] -= col[r] * lower;
+        }
+        d_[v] = dj;
+        return j;
+    }
+
+    int add_row(const std::vector<int>& columns,
+                const std::vector<double>& coefs, Sense sense, double rhs)
+    {
+        int i = rows();
+        double lo = sense == GREATER ? -inf : 0;
+        double up = sense == LESS ? inf : 0;
+        int s = add_var(0, lo, up);
+        row_var_.push_back(s);
+        rhs_.push_back(rhs);
+        a_.push_back(std::vector<std::pair<int, double> >());
+
+        std::vector<double> row(vars(), 0);
+        double value = rhs;
+        for (size_t k = 0; k < columns.size(); ++k) {
+            int v = col_var_[columns[k]];
+            a_[i].push_back(std::make_pair(columns[k], coefs[k]));
+            row[v] += coefs[k];
+            value -= coefs[k] * x_[v];
+        }
+        row[s] = 1;
+        // eliminate the basic variables
+        for (int r = 0; r < i; ++r) {
+            double f = row[head_[r]];
+            if (f != 0)
+                axpy(row, -f, T_[r]);
+        }
+        T_.push_back(row);
+        head_.push_back(s);
+        basic_[s] = i;
+        x_[s] = value;
+        return i;
+    }
+
+    void delete_rows(const std::vector<int>& rows)
+    {
+        for (size_t k = rows.size(); k-- > 0;)
+            delete_row(rows[k]);
+    }
+
+    void set_bounds(int column, double lower, double upper)
+    {
+        int v = col_var_[column];
+        if (basic_[v] < 0) {
+            double x = upper_[v] ? upper : lower;
+            shift(v, x - x_[v]);
+        }
+        lo_[v] = lower;
+        up_[v] = upper;
+    }
+
+    Status solve()
+    {
+        if (pivots_ >= refactor_pivots)
+            refactor();
+        // columns to the bound their reduced cost points to
+        for (size_t j = 0; j < col_var_.size(); ++j) {
+            int v = col_var_[j];
+            if (basic_[v] >= 0)
+                continue;
+            bool up = d_[v] < 0;
+            if (up != upper_[v]) {
+                shift(v, (up ? up_[v] : lo_[v]) - x_[v]);
+                upper_[v] = up;
+            }
+        }
+        for (;;) {
+            // leaving row: the largest bound violation
+            int r = -1;
+            double worst = primal_tol;
+            for (int i = 0; i < rows(); ++i) {
+                int p = head_[i];
+                double e = std::max(lo_[p] - x_[p], x_[p] - up_[p]);
+                if (e > worst) {
+                    worst = e;
+                    r = i;
+                }
+            }
+            if (r < 0)
+                return OPTIMAL;
+            int p = head_[r];
+            bool raise = x_[p] < lo_[p];
+            // entering column: the smallest dual ratio, the largest pivot
+            // among ties
+            const std::vector<double>& t = T_[r];
+            int q = -1;
+            double ratio = inf, size = 0;
+            for (int v = 0; v < vars(); ++v) {
+                if (basic_[v] >= 0 || lo_[v] == up_[v])
+                    continue;
+                double a = raise == upper_[v] ? t[v] : -t[v];
+                if (a <= pivot_tol)
+                    continue;
+                double rv = std::max(0.0, upper_[v] ? -d_[v] : d_[v]) / a;
+                if (rv < ratio - dual_tol ||
+                    (rv <= ratio + dual_tol && a > size)) {
+                    ratio = rv;
+                    size = a;
+                    q = v;
+                }
+            }
+            if (q < 0)
+                return INFEASIBLE;
+            pivot(r, q, raise ? lo_[p] : up_[p]);
+        }
+    }
+
+    double objective() const
+    {
+        double z = 0;
+        for (size_t j = 0; j < col_var_.size(); ++j)
+            z += cost_[col_var_[j]] * x_[col_var_[j]];
+        return z;
+    }
+
+    void primal(std::vector<double>& x) const
+    {
+        x.resize(col_var_.size());
+        for (size_t j = 0; j < col_var_.size(); ++j)
+            x[j] = x_[col_var_[j]];
+    }
+
+    void duals(std::vector<double>& y) const
+    {
+        y.resize(row_var_.size());
+        for (size_t i = 0; i < row_var_.size(); ++i)
+            y[i] = -d_[row_var_[i]];
+    }
+
+private:
+    int vars() const { return static_cast<int>(cost_.size()); }
+
+    static void axpy(std::vector<double>& y, double a,
+                     const std::vector<double>& x)
+    {
+        for (size_t k = 0; k < y.size(); ++k)
+            y[k] += a * x[k];
+    }
+
+    // A new nonbasic variable at its lower bound (upper if none).
+    int add_var(double cost, double lower, double upper)
+    {
+        int v = vars();
+        cost_.push_back(cost);
+        lo_.push_back(lower);
+        up_.push_back(upper);
+        upper_.push_back(lower == -inf);
+        x_.push_back(lower == -inf ? upper : lower);
+        d_.push_back(cost);
+        basic_.push_back(-1);
+        for (size_t r = 0; r < T_.size(); ++r)
+            T_[r].push_back(0);
+        return v;
+    }
+
+    // Move nonbasic v by delta, updating the basic variables.
+    void shift(int v, double delta)
+    {
+        if (delta == 0)
+            return;
+        x_[v] += delta;
+        for (int r = 0; r < rows(); ++r)
+            x_[head_[r]] -= T_[r][v] * delta;
+    }
+
+    // Pivot q into row r, whose basic variable leaves at 'bound'.
+    void pivot(int r, int q, double bound)
+    {
+        int p = head_[r];
+        std::vector<double>& t = T_[r];
+        double a = t[q];
+        double delta = (x_[p] - bound) / a;
+        for (int i = 0; i < rows(); ++i)
+            x_[head_[i]] -= T_[i][q] * delta;
+        x_[q] += delta;
+        x_[p] = bound;
+
+        for (size_t k = 0; k < t.size(); ++k)
+            t[k] /= a;
+        for (int i = 0; i < rows(); ++i) {
+            double f = T_[i][q];
+            if (i != r && f != 0)
+                axpy(T_[i], -f, t);
+        }
+        double f = d_[q];
+        if (f != 0)
+            axpy(d_, -f, t);
+        d_[q] = 0;
+
+        head_[r] = q;
+        basic_[q] = r;
+        basic_[p] = -1;
+        upper_[p] = bound == up_[p] && bound != lo_[p];
+        ++pivots_;
+    }
+
+    void delete_row(int i)
+    {
+        int s = row_var_[i], r = basic_[s];
+        if (r < 0)
+            throw std::runtime_error("simplex: deleting a binding row");
+        T_.erase(T_.begin() + r);
+        head_.erase(head_.begin() + r);
+        for (size_t k = 0; k < T_.size(); ++k)
+            T_[k].erase(T_[k].begin() + s);
+        cost_.erase(cost_.begin() + s);
+        lo_.erase(lo_.begin() + s);
+        up_.erase(up_.begin() + s);
+        upper_.erase(upper_.begin() + s);
+        x_.erase(x_.begin() + s);
+        d_.erase(d_.begin() + s);
+        basic_.erase(basic_.begin() + s);
+        rhs_.erase(rhs_.begin() + i);
+        a_.erase(a_.begin() + i);
+        row_var_.erase(row_var_.begin() + i);
+        for (size_t k = 0; k < head_.size(); ++k) {
+            head_[k] -= head_[k] > s;
+            basic_[head_[k]] = static_cast<int>(k);
+        }
+        for (size_t k = 0; k < col_var_.size(); ++k)
+            col_var_[k] -= col_var_[k] > s;
+        for (size_t k = 0; k < row_var_.size(); ++k)
+            row_var_[k] -= row_var_[k] > s;
+    }
+
+    // Rebuild T, the basic values and d from the rows and the basis.
+    void refactor()
+    {
+        int m = rows(), n = vars();
+        // B, then its inverse by Gauss-Jordan with partial pivoting
+        std::vector<std::vector<double> > B(m, std::vector<double>(m, 0));
+        std::vector<std::vector<double> > inv(m, std::vector<double>(m, 0));
+        for (int i = 0; i < m; ++i) {
+            inv[i][i] = 1;
+            for (size_t k = 0; k < a_[i].size(); ++k) {
+                int r = basic_[col_var_[a_[i][k].first]];
+                if (r >= 0)
+                    B[i][r] += a_[i][k].second;
+            }
+            if (basic_[row_var_[i]] >= 0)
+                B[i][basic_[row_var_[i]]] = 1;
+        }
+        for (int c = 0; c < m; ++c) {
+            int best = c;
+            for (int i = c + 1; i < m; ++i)
+                if (std::fabs(B[i][c]) > std::fabs(B[best][c]))
+                    best = i;
+            if (std::fabs(B[best][c]) < 1e-12)
+                throw std::runtime_error("simplex: singular basis");
+            std::swap(B[c], B[best]);
+            std::swap(inv[c], inv[best]);
+            double a = B[c][c];
+            for (int k = 0; k < m; ++k) {
+                B[c][k] /= a;
+                inv[c][k] /= a;
+            }
+            for (int i = 0; i < m; ++i) {
+                double f = B[i][c];
+                if (i != c && f != 0) {
+                    axpy(B[i], -f, B[c]);
+                    axpy(inv[i], -f, inv[c]);
+                }
+            }
+        }
+        // T = B^-1 [A I], rows in basis order
+        std::vector<double> b(rhs_);
+        for (int i = 0; i < m; ++i)
+            for (size_t k = 0; k < a_[i].size(); ++k) {
+                int v = col_var_[a_[i][k].first];
+                if (basic_[v] < 0)
+                    b[i] -= a_[i][k].second * x_[v];
+            }
+        for (int i = 0; i < m; ++i)
+            if (basic_[row_var_[i]] < 0)
+                b[i] -= x_[row_var_[i]];
+        for (int r = 0; r < m; ++r) {
+            std::vector<double>& t = T_[r];
+            std::fill(t.begin(), t.end(), 0.0);
+            double xb = 0;
+            for (int i = 0; i < m; ++i) {
+                double f = inv[r][i];
+                if (f == 0)
+                    continue;
+                xb += f * b[i];
+                t[row_var_[i]] += f;
+                for (size_t k = 0; k < a_[i].size(); ++k)
+                    t[col_var_[a_[i][k].first]] += f * a_[i][k].second;
+            }
+            x_[head_[r]] = xb;
+        }
+        for (int v = 0; v < n; ++v)
+            d_[v] = cost_[v];
+        for (int r = 0; r < m; ++r) {
+            double c = cost_[head_[r]];
+            if (c != 0)
+                axpy(d_, -c, T_[r]);
+        }
+        for (int r = 0; r < m; ++r)
+            d_[head_[r]] = 0;
+        pivots_ = 0;
+    }
+
+    // the program
+    std::vector<std::vector<std::pair<int, double> > > a_;  // rows
+    std::vector<double> rhs_;
+    std::vector<int> col_var_, row_var_;
+    // per variable
+    std::vector<double> cost_, lo_, up_, x_, d_;
+    std::vector<char> upper_;  // nonbasic at its upper bound
+    std::vector<int> basic_;   // row it is basic in, or -1
+    // per row of T
+    std::vector<std::vector<double> > T_;
+    std::vector<int> head_;
+    int pivots_;
+};
+
+}  // namespace
+
+std::unique_ptr<Lp> mk_lp(LpBackend backend)
+{
+    switch (backend) {
+    case SIMPLEX_LP: return std::unique_ptr<Lp>(new SimplexLp);
+#ifdef TPF_CPLEX
+    case CPLEX_LP: return mk_cplex_lp();
+#endif
+    default: throw std::runtime_error("LP backend not built in");
+    }
+}
+
+bool lp_backend_built(LpBackend backend)
+{
+#ifdef TPF_CPLEX
+    return backend == SIMPLEX_LP || backend == CPLEX_LP;
+#else
+    return backend == SIMPLEX_LP;
+#endif
+}
+
+}  // namespace tpf
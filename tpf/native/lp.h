@@ -0,0 +1,63 @@
+#ifndef TPF_LP_H
+#define TPF_LP_H
+
+#include <memory>
+#include <vector>
+
+namespace tpf {
+
+// Linear programs for the branch-and-cut (branch.h): minimise c x subject to
+// rows a x {<=, =, >=} b and bounds l <= x <= u, built up incrementally.
+// Columns keep their index for the life of the program; deleting rows
+// renumbers the remaining ones in order.  solve() restarts from the last
+// basis, so rows, columns and bound changes are cheap to re-optimise.
+// Errors are thrown as std::runtime_error.
+class Lp {
+public:
+    enum Sense { LESS = 'L', EQUAL = 'E', GREATER = 'G' };
+    enum Status { OPTIMAL, INFEASIBLE };
+
+    virtual ~Lp() {}
+
+    virtual int rows() const = 0;
+    virtual int columns() const = 0;
+
+    // Returns the index of the new column; 'rows' and 'coefs' give its
+    // entries in the existing rows.
+    virtual int add_column(double cost, double lower, double upper,
+                           const std::vector<int>& rows,
+                           const std::vector<double>& coefs) = 0;
+
+    // Returns the index of the new row.
+    virtual int add_row(const std::vector<int>& columns,
+                        const std::vector<double>& coefs, Sense sense,
+                        double rhs) = 0;
+
+    // Delete rows (indices increasing) that are not binding at the last
+    // solution.
+    virtual void delete_rows(const std::vector<int>& rows) = 0;
+
+    virtual void set_bounds(int column, double lower, double upper) = 0;
+
+    virtual Status solve() = 0;
+
+    // Of the last optimal solution.
+    virtual double objective() const = 0;
+    virtual void primal(std::vector<double>& x) const = 0;
+    // Row duals, signed as CPXgetpi: <= 0 on <= rows, >= 0 on >= rows.
+    virtual void duals(std::vector<double>& y) const = 0;
+};
+
+enum LpBackend {
+    SIMPLEX_LP,  // the bundled dense dual simplex
+    CPLEX_LP     // CPLEX, if built with TPF_CPLEX_DIR
+};
+
+// Throws if the backend was not built in.
+std::unique_ptr<Lp> mk_lp(LpBackend backend);
+
+bool lp_backend_built(LpBackend backend);
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,131 @@
+// The CPLEX backend of lp.h, built when TPF_CPLEX_DIR points at a CPLEX
+// installation (see CMakeLists.txt).
+
+#include <ilcplex/cplex.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "lp.h"
+
+namespace tpf {
+
+namespace {
+
+class CplexLp : public Lp {
+public:
+    CplexLp() : env_(0), lp_(0)
+    {
+        int status = 0;
+        env_ = CPXopenCPLEX(&status);
+        if (!env_)
+            throw std::runtime_error("could not open CPLEX environment");
+        lp_ = CPXcreateprob(env_, &status, "tsp");
+        if (!lp_) {
+            CPXcloseCPLEX(&env_);
+            throw std::runtime_error("could not create CPLEX problem");
+        }
+        CPXchgobjsen(env_, lp_, CPX_MIN);
+    }
+
+    ~CplexLp()
+    {
+        CPXfreeprob(env_, &lp_);
+        CPXcloseCPLEX(&env_);
+    }
+
+    int rows() const { return CPXgetnumrows(env_, lp_); }
+    int columns() const { return CPXgetnumcols(env_, lp_); }
+
+    int add_column(double cost, double lower, double upper,
+                   const std::vector<int>& rows,
+                   const std::vector<double>& coefs)
+    {
+        int j = columns(), beg = 0;
+        check(CPXaddcols(env_, lp_, 1, static_cast<int>(rows.size()), &cost,
+                         &beg, rows.data(), coefs.data(), &lower, &upper,
+                         0));
+        return j;
+    }
+
+    int add_row(const std::vector<int>& columns,
+                const std::vector<double>& coefs, Sense sense, double rhs)
+    {
+        int i = rows(), beg = 0;
+        char s = static_cast<char>(sense);
+        check(CPXaddrows(env_, lp_, 0, 1, static_cast<int>(columns.size()),
+                         &rhs, &s, &beg, columns.data(), coefs.data(), 0,
+                         0));
+        return i;
+    }
+
+    void delete_rows(const std::vector<int>& rows)
+    {
+        std::vector<int> del(this->rows(), 0);
+        for (size_t k = 0; k < rows.size(); ++k)
+            del[rows[k]] = 1;
+        check(CPXdelsetrows(env_, lp_, del.data()));
+    }
+
+    void set_bounds(int column, double lower, double upper)
+    {
+        int idx[] = {column, column};
+        char lu[] = {'L', 'U'};
+        double bd[] = {lower, upper};
+        check(CPXchgbds(env_, lp_, 2, idx, lu, bd));
+    }
+
+    Status solve()
+    {
+        check(CPXdualopt(env_, lp_));
+        switch (CPXgetstat(env_, lp_)) {
+        case CPX_STAT_OPTIMAL: return OPTIMAL;
+        case CPX_STAT_INFEASIBLE: return INFEASIBLE;
+        default: throw std::runtime_error("CPLEX: LP not solved");
+        }
+    }
+
+    double objective() const
+    {
+        double z;
+        check(CPXgetobjval(env_, lp_, &z));
+        return z;
+    }
+
+    void primal(std::vector<double>& x) const
+    {
+        x.resize(columns());
+        if (!x.empty())
+            check(CPXgetx(env_, lp_, x.data(), 0, columns() - 1));
+    }
+
+    void duals(std::vector<double>& y) const
+    {
+        y.resize(rows());
+        if (!y.empty())
+            check(CPXgetpi(env_, lp_, y.data(), 0, rows() - 1));
+    }
+
+private:
+    void check(int status) const
+    {
+        if (status == 0)
+            return;
+        char message[CPXMESSAGEBUFSIZE];
+        if (!CPXgeterrorstring(env_, status, message))
+            throw std::runtime_error("CPLEX error " + std::to_string(status));
+        throw std::runtime_error(std::string("CPLEX: ") + message);
+    }
+
+    CPXENVptr env_;
+    CPXLPptr lp_;
+};
+
+}  // namespace
+
+std::unique_ptr<Lp> mk_cplex_lp()
+{
+    return std::unique_ptr<Lp>(new CplexLp);
+}
+
+}  // namespace tpf
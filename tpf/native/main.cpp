@@ -0,0 +1,226 @@
+// Multistart local search on a TSPLIB instance.
+//
+//     tsp [-i iterations] [-s seed] [-k neighbours] [-q] [-t] [-m moves]
+//         file.tsp
+//
+// -m picks the local search: 2opt, oropt or or2opt (the default) from
+// moves.h, lk for Lin-Kernighan, or utils for the 2-opt of utils.py.
+// Lin-Kernighan defaults to 12 quadrant neighbours.
+// -k 0 uses complete neighbour lists; -q takes quadrant neighbours.
+// -t truncates distances as utils.py does instead of rounding them.
+// -g computes the Held-Karp bound and stops the restarts once a tour is
+// within that fraction of it (e.g. -g 0.02); -a keeps the k candidates of
+// each list with the lowest alpha-nearness under the bound's penalties.
+// -x simplex solves the instance exactly by branch-and-cut (branch.h) on
+// the bundled simplex, -x cplex on CPLEX; -i then limits the
+// branch-and-bound nodes (default: none).
+// -S runs the anytime solver (solve.h) from the -c start, within -T
+// seconds, -i kicks and -g gap, whichever comes first; Ctrl-C stops it
+// with the best tour so far.
+// -p keeps that many of the -i restarts and recombines them by partition
+// crossover (crossover.h) until no better tour comes out.
+// -P splits the instance into k-d cells of at most that many cities,
+// tours them in parallel (-j threads) and joins them (partition.h); -m
+// then defaults to lk.
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+
+#include "bound.h"
+#include "branch.h"
+#include "construct.h"
+#include "crossover.h"
+#include "ils.h"
+#include "localsearch.h"
+#include "moves.h"
+#include "partition.h"
+#include "solve.h"
+#include "tsplib.h"
+
+static tpf::Control interrupt;
+
+static void on_interrupt(int)
+{
+    interrupt.stop();
+}
+
+static void usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "usage: %s [-i iterations] [-s seed] [-k neighbours] "
+                 "[-q] [-t] [-j threads] [-I] [-S] [-T seconds] [-g gap] [-a k] "
+                 "[-x simplex|cplex] [-p population] [-P cell_size] "
+                 "[-c random|nn|greedy|hilbert|farthest|cheapest] "
+                 "[-m 2opt|oropt|or2opt|lk|utils] file.tsp\n",
+                 prog);
+    std::exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    int niter = 100, k = -1, threads = -1, alpha = 0, cell_size = 0,
+        population = 0;
+    long long nodes = 0;
+    int moves = -1;
+    bool quadrant = false, iterated = false, exact = false;
+    bool anytime = false;
+    tpf::LpBackend backend = tpf::SIMPLEX_LP;
+    double seconds = 0, gap = -1;
+    tpf::Start start = tpf::RANDOM_START;
+    tpf::Rounding rounding = tpf::NINT;
+    unsigned seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:s:k:qtj:IST:g:a:x:p:P:c:m:")) != -1) {
+        switch (opt) {
+        case 'i':
+            niter = std::atoi(optarg);
+            nodes = niter;
+            break;
+        case 's': seed = std::strtoul(optarg, 0, 10); break;
+        case 'k': k = std::atoi(optarg); break;
+        case 'q': quadrant = true; break;
+        case 't': rounding = tpf::TRUNCATE; break;
+        case 'j': threads = std::atoi(optarg); break;
+        case 'I': iterated = true; break;
+        case 'S': anytime = true; break;
+        case 'T': seconds = std::atof(optarg); break;
+        case 'g': gap = std::atof(optarg); break;
+        case 'a': alpha = std::atoi(optarg); break;
+        case 'x':
+            exact = true;
+            if (std::strcmp(optarg, "cplex") == 0)
+                backend = tpf::CPLEX_LP;
+            else if (std::strcmp(optarg, "simplex") != 0)
+                usage(argv[0]);
+            break;
+        case 'p': population = std::atoi(optarg); break;
+        case 'P': cell_size = std::atoi(optarg); break;
+        case 'c': {
+            const char* names[] = {"random", "nn", "greedy", "hilbert",
+                                   "farthest", "cheapest"};
+            int s = 0;
+            while (s < 6 && std::strcmp(optarg, names[s]) != 0)
+                ++s;
+            if (s == 6)
+                usage(argv[0]);
+            start = tpf::Start(s);
+            break;
+        }
+        case 'm':
+            if (std::strcmp(optarg, "2opt") == 0)
+                moves = tpf::TWO_OPT;
+            else if (std::strcmp(optarg, "oropt") == 0)
+                moves = tpf::OR_OPT;
+            else if (std::strcmp(optarg, "or2opt") == 0)
+                moves = tpf::OR2OPT;
+            else if (std::strcmp(optarg, "lk") == 0)
+                moves = tpf::LIN_KERNIGHAN;
+            else if (std::strcmp(optarg, "utils") == 0)
+                moves = 0;
+            else
+                usage(argv[0]);
+            break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1)
+        usage(argv[0]);
+
+    try {
+        tpf::Problem p = tpf::read_tsplib(argv[optind], rounding);
+        tpf::Oracle D(p);
+        if (moves < 0)
+            moves = cell_size > 0 ? tpf::LIN_KERNIGHAN : tpf::OR2OPT;
+        if (moves == tpf::LIN_KERNIGHAN && k < 0) {
+            k = 12;
+            quadrant = true;
+        }
+        tpf::Neighbors C = tpf::mk_neighbors(
+            D, k < 0 ? tpf::default_neighbors(p.n) : k, quadrant);
+        long long bound = -1, target = -1;
+        if ((gap >= 0 && !anytime) || alpha > 0) {
+            tpf::HeldKarp hk = tpf::held_karp(D, C);
+            bound = hk.bound;
+            std::printf("bound:%lld%s\n", bound,
+                        hk.exact ? "" : " (estimate)");
+            if (gap >= 0)
+                target = tpf::gap_target(bound, gap);
+            if (alpha > 0)
+                C = tpf::alpha_neighbors(D, C, hk, alpha,
+                                         threads < 0 ? 0 : threads);
+        }
+
+        tpf::Report report = [](long long z, const tpf::Tour&) {
+            std::printf("cpu:%g\tobj:%lld\n",
+                        double(std::clock()) / CLOCKS_PER_SEC, z);
+        };
+        tpf::Solution best;
+        if (exact) {
+            tpf::BranchAndCut bc = tpf::branch_and_cut(D, C, backend, nodes,
+                                                       report);
+            std::printf("nodes:%lld\tcuts:%d\tbound:%lld%s\n", bc.nodes,
+                        bc.cuts, bc.bound, bc.optimal ? " (optimal)" : "");
+            best.tour = bc.tour;
+            best.z = bc.z;
+        } else if (cell_size > 0) {
+            best.tour = tpf::partition_tour(D, C, cell_size,
+                                            moves ? moves : tpf::OR2OPT,
+                                            threads < 0 ? 0 : threads);
+            best.z = tpf::length(best.tour, D);
+            report(best.z, best.tour);
+        } else if (anytime) {
+            tpf::Budget budget;
+            budget.seconds = seconds;
+            budget.iterations = niter;
+            budget.gap = gap;
+            budget.bound = bound;
+            signal(SIGINT, on_interrupt);
+            tpf::Outcome out = tpf::solve(
+                D, C, budget,
+                [](const tpf::Progress& p) {
+                    std::printf("time:%g\tobj:%lld\tkicks:%lld\n",
+                                p.seconds, p.z, p.iterations);
+                },
+                &interrupt, seed, moves ? moves : tpf::OR2OPT, start);
+            signal(SIGINT, SIG_DFL);
+            bound = out.bound;
+            best.tour = out.tour;
+            best.z = out.z;
+        } else if (iterated) {
+            // -i counts kicks (0: only -T), from a single start (-c)
+            std::mt19937 rng(seed);
+            best.tour = tpf::initial_tour(start, D, C, rng);
+            best.z = tpf::iterated_local_search(
+                best.tour, tpf::length(best.tour, D), D, C, rng,
+                niter, seconds, moves ? moves : tpf::OR2OPT, report);
+        } else if (population > 0) {
+            best = tpf::population_search(niter, population, D, C, seed,
+                                          threads < 0 ? 0 : threads, report,
+                                          moves, target);
+        } else if (threads < 0) {
+            std::mt19937 rng(seed);
+            best = tpf::multistart_localsearch(niter, D, C, rng, report,
+                                               moves, target);
+        } else {
+            best = tpf::multistart_localsearch(niter, D, C, seed, threads,
+                                               report, moves, target);
+        }
+        std::printf("best found solution (%d iterations): z = %lld\n", niter,
+                    best.z);
+        if (bound > 0)
+            std::printf("gap: %.4f\n", double(best.z - bound) / bound);
+        for (size_t i = 0; i < best.tour.size(); ++i)
+            std::printf("%d%c", best.tour[i],
+                        i + 1 < best.tour.size() ? ' ' : '\n');
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "matrix.h"
+
+#include "distance.h"
+
+namespace tpf {
+
+int dist_l2(const Point& p, const Point& q)
+{
+    return distance(EUC_2D, TRUNCATE, p.x, p.y, q.x, q.y);
+}
+
+int dist_l1(const Point& p, const Point& q)
+{
+    return distance(MAN_2D, TRUNCATE, p.x, p.y, q.x, q.y);
+}
+
+int dist_ceil2d(const Point& p, const Point& q)
+{
+    return distance(CEIL_2D, TRUNCATE, p.x, p.y, q.x, q.y);
+}
+
+int dist_max2d(const Point& p, const Point& q)
+{
+    return distance(MAX_2D, TRUNCATE, p.x, p.y, q.x, q.y);
+}
+
+int dist_att(const Point& p, const Point& q)
+{
+    return distance(ATT, TRUNCATE, p.x, p.y, q.x, q.y);
+}
+
+int dist_geo(const Point& p, const Point& q)
+{
+    return distance(GEO, TRUNCATE, p.x, p.y, q.x, q.y);
+}
+
+Matrix mk_matrix(const std::vector<Point>& coord, dist_fn dist)
+{
+    int n = static_cast<int>(coord.size());
+    Matrix D(n);
+    for (int i = 0; i < n - 1; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            D.at(i, j) = dist(coord[i], coord[j]);
+            D.at(j, i) = D(i, j);
+        }
+    }
+    return D;
+}
+
+}  // namespace tpf
@@ -0,0 +1,62 @@
+#ifndef TPF_MATRIX_H
+#define TPF_MATRIX_H
+
+#include <cstddef>
+#include <vector>
+
+namespace tpf {
+
+struct Point {
+    double x, y;
+};
+
+typedef int (*dist_fn)(const Point& p, const Point& q);
+
+// L2-norm (Euclidean) distance, truncated like utils.py's distL2.
+int dist_l2(const Point& p, const Point& q);
+
+// L1-norm (Manhattan) distance, truncated like utils.py's distL1.
+int dist_l1(const Point& p, const Point& q);
+
+// Euclidean distance rounded up (TSPLIB CEIL_2D).
+int dist_ceil2d(const Point& p, const Point& q);
+
+// Maximum-norm distance, truncated like dist_l1.
+int dist_max2d(const Point& p, const Point& q);
+
+// TSPLIB pseudo-Euclidean distance (ATT).
+int dist_att(const Point& p, const Point& q);
+
+// TSPLIB geographical distance; coordinates are DDD.MM latitude/longitude.
+int dist_geo(const Point& p, const Point& q);
+
+// Dense n x n distance matrix stored row-major in one flat buffer, so that
+// D(i,j) is a single indexed load instead of a dict lookup on (i,j).
+class Matrix {
+public:
+    Matrix() : n_(0) {}
+    explicit Matrix(int n) : n_(n), d_(static_cast<size_t>(n) * n, 0) {}
+
+    int size() const { return n_; }
+
+    int operator()(int i, int j) const { return d_[index(i, j)]; }
+    int& at(int i, int j) { return d_[index(i, j)]; }
+
+    const int* row(int i) const { return &d_[index(i, 0)]; }
+
+private:
+    size_t index(int i, int j) const
+    {
+        return static_cast<size_t>(i) * n_ + j;
+    }
+
+    int n_;
+    std::vector<int> d_;
+};
+
+// Compute a distance matrix for a set of points using 'dist'.
+Matrix mk_matrix(const std::vector<Point>& coord, dist_fn dist);
+
+}  // namespace tpf
+
+#endif
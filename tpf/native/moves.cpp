@@ -0,0 +1,97 @@
+#include "moves.h"
+
+#include "directed.h"
+#include "lk.h"
+#include "localsearch.h"
+
+namespace tpf {
+
+namespace {
+
+template <class T>
+long long run_search(std::vector<int>& tour, long long z, const Oracle& D,
+                     const Neighbors& C, int moves,
+                     const std::vector<int>* dirty)
+{
+    T t(tour);
+    ActiveQueue queue(t.size());
+    if (dirty)
+        for (size_t k = 0; k < dirty->size(); ++k)
+            queue.push((*dirty)[k]);
+    else
+        queue.push_all();
+    z = Search<T>(t, D, C, moves, queue).run(z);
+    tour = t.sequence();
+    return checked_length(tour, z, D);
+}
+
+// Cities whose tour neighbours differ between two tours.
+void changed_cities(const std::vector<int>& before,
+                    const std::vector<int>& after, std::vector<int>& out)
+{
+    int n = static_cast<int>(before.size());
+    std::vector<int> next(n), prev(n);
+    for (int k = 0; k < n; ++k) {
+        int c = before[k], d = before[k + 1 == n ? 0 : k + 1];
+        next[c] = d;
+        prev[d] = c;
+    }
+    for (int k = 0; k < n; ++k) {
+        int c = after[k], d = after[k + 1 == n ? 0 : k + 1];
+        if (next[c] != d && prev[c] != d) {
+            out.push_back(c);
+            out.push_back(d);
+        }
+    }
+}
+
+long long optimize(std::vector<int>& tour, long long z, const Oracle& D,
+                   const Neighbors& C, int moves, TourKind kind,
+                   const std::vector<int>* dirty)
+{
+    if (!D.symmetric())
+        return directed_or_opt(tour, z, D, C, dirty);
+    std::vector<int> active;
+    if (moves & LIN_KERNIGHAN) {
+        std::vector<int> before;
+        if (dirty) {
+            before = tour;
+            active = *dirty;
+        }
+        z = dirty ? lin_kernighan(tour, z, D, C, *dirty, kind)
+                  : lin_kernighan(tour, z, D, C, kind);
+        moves &= ~LIN_KERNIGHAN;
+        if (!moves)
+            return z;
+        // the other moves start from what Lin-Kernighan changed
+        if (dirty) {
+            changed_cities(before, tour, active);
+            dirty = &active;
+        }
+    }
+    switch (tour_kind(kind, static_cast<int>(tour.size()))) {
+    case LINKED_TOUR:
+        return run_search<LinkedTour>(tour, z, D, C, moves, dirty);
+    case TWO_LEVEL_TOUR:
+        return run_search<TwoLevelTour>(tour, z, D, C, moves, dirty);
+    default:
+        return run_search<ArrayTour>(tour, z, D, C, moves, dirty);
+    }
+}
+
+}  // namespace
+
+long long optimize(std::vector<int>& tour, long long z, const Oracle& D,
+                   const Neighbors& C, int moves, TourKind kind)
+{
+    return optimize(tour, z, D, C, moves, kind, 0);
+}
+
+long long optimize(std::vector<int>& tour, long long z, const Oracle& D,
+                   const Neighbors& C, const std::vector<int>& dirty,
+                   int moves, TourKind kind)
+{
+    return optimize(tour, z, D, C, moves, kind, &dirty);
+}
+
+}  // namespace tpf
@@ -0,0 +1,221 @@
+#ifndef TPF_MOVES_H
+#define TPF_MOVES_H
+
+#include <vector>
+
+#include "active.h"
+#include "control.h"
+#include "counters.h"
+#include "neighbors.h"
+#include "oracle.h"
+#include "tour.h"
+
+namespace tpf {
+
+// Move sets for optimize().  OR2OPT is the union of 2-opt and Or-opt, the
+// restricted 3-opt neighbourhood sometimes called 2h-opt or or-2opt.
+// LIN_KERNIGHAN runs lin_kernighan() (lk.h) first, then any other moves.
+enum Moves {
+    TWO_OPT = 1,
+    OR_OPT = 2,
+    OR2OPT = TWO_OPT | OR_OPT,
+    LIN_KERNIGHAN = 4
+};
+
+// Longest segment Or-opt relocates.
+const int max_segment = 3;
+
+// Delta of the 2-opt move replacing edges (a,b), (c,d) by (a,c), (b,d).
+inline long long two_opt_delta(const Oracle& D, int a, int b, int c, int d)
+{
+    return static_cast<long long>(D(a, c)) + D(b, d) - D(a, b) - D(c, d);
+}
+
+// Delta of the Or-opt move taking the segment s1..s2 out from between p
+// and n and putting it between u and v, as u s1..s2 v or, if 'reversed',
+// as u s2..s1 v.
+inline long long or_opt_delta(const Oracle& D, int p, int s1, int s2, int n,
+                              int u, int v, bool reversed)
+{
+    long long add = reversed ? static_cast<long long>(D(u, s2)) + D(s1, v)
+                             : static_cast<long long>(D(u, s1)) + D(s2, v);
+    return add + D(p, n) - D(p, s1) - D(s2, n) - D(u, v);
+}
+
+// Or-opt as a sequence of at most three 2-opt moves; see or_opt_delta().
+// p, s1, s2, n and u, v must follow each other in the same direction.
+template <class T>
+void apply_or_opt(T& t, int p, int s1, int s2, int n, int u, int v,
+                  bool reversed)
+{
+    if (v == p) {
+        // seen the other way round u is next to n, which the steps allow
+        apply_or_opt(t, n, s2, s1, p, v, u, reversed);
+        return;
+    }
+    two_opt_move(t, p, s1, u, v);  // p u .. n s2..s1 v
+    if (u != n)
+        two_opt_move(t, p, u, n, s2);  // p n .. u s2..s1 v
+    if (!reversed)
+        two_opt_move(t, u, s2, s1, v);  // u s1..s2 v
+}
+
+// The search behind optimize(), over any tour type of tour.h.  It looks
+// at the cities in 'queue', which the caller fills, and queues the
+// endpoints of every edge it changes.
+template <class T>
+class Search {
+public:
+    Search(T& t, const Oracle& D, const Neighbors& C, int moves,
+           ActiveQueue& queue)
+        : t_(t), D_(D), C_(C), moves_(moves), queue_(queue), control_(0),
+          evaluated_(0), applied_(0)
+    {
+    }
+
+    ~Search()
+    {
+        search_counters().evaluated += evaluated_;
+        search_counters().applied += applied_;
+    }
+
+    // Have run() return early, its queue not empty, once 'control' stops.
+    void set_control(const Control* control) { control_ = control; }
+
+    // Look at the queued cities until no improving move is left around
+    // any of them.
+    long long run(long long z)
+    {
+        if (t_.size() < 5) {
+            queue_.clear();
+            return z;
+        }
+        while (!queue_.empty() && !(control_ && control_->stopped())) {
+            int a = queue_.pop();
+            while (((moves_ & TWO_OPT) && two_opt(a, z))
+                   || ((moves_ & OR_OPT) && or_opt(a, z)))
+                ;
+        }
+        return z;
+    }
+
+private:
+    bool two_opt(int a, long long& z)
+    {
+        for (int dir = 0; dir < 2; ++dir) {
+            int b = dir == 0 ? t_.next(a) : t_.prev(a);
+            int dist_ab = D_(a, b);
+            for (int k = C_.begin(a); k < C_.end(a); ++k) {
+                int c = C_.city[k];
+                if (C_.dist[k] >= dist_ab)
+                    break;
+                int d = dir == 0 ? t_.next(c) : t_.prev(c);
+                if (c == b || d == a)
+                    continue;
+                long long delta = two_opt_delta(D_, a, b, c, d);
+                ++evaluated_;
+                if (delta < 0) {
+                    two_opt_move(t_, a, b, c, d);
+                    ++applied_;
+                    z += delta;
+                    wake(a), wake(b), wake(c), wake(d);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool or_opt(int a, long long& z)
+    {
+        if (t_.size() < 8)
+            return false;
+        int seg[max_segment];
+        for (int len = 1; len <= max_segment; ++len) {
+            // segments s1..s2 (in next() order) starting or ending at a
+            for (int side = 0; side < (len == 1 ? 1 : 2); ++side) {
+                int s1 = a, s2 = a;
+                seg[0] = a;
+                for (int i = 1; i < len; ++i)
+                    seg[i] = side == 0 ? (s2 = t_.next(s2))
+                                       : (s1 = t_.prev(s1));
+                int p = t_.prev(s1), n = t_.next(s2);
+                long long gain = static_cast<long long>(D_(p, s1))
+                                 + D_(s2, n) - D_(p, n);
+                if (gain <= 0)
+                    continue;
+                for (int e = 0; e < (len == 1 ? 1 : 2); ++e) {
+                    int end = e == 0 ? s1 : s2;
+                    for (int k = C_.begin(end); k < C_.end(end); ++k) {
+                        int c = C_.city[k];
+                        if (C_.dist[k] >= gain)
+                            break;
+                        if (in(seg, len, c))
+                            continue;
+                        // put 'end' next to c, before or after it
+                        for (int w = 0; w < 2; ++w) {
+                            int u = w == 0 ? c : t_.prev(c);
+                            int v = w == 0 ? t_.next(c) : c;
+                            if (in(seg, len, u) || in(seg, len, v))
+                                continue;
+                            bool reversed = (c == u) == (end == s2);
+                            long long delta = or_opt_delta(D_, p, s1, s2, n,
+                                                           u, v, reversed);
+                            ++evaluated_;
+                            if (delta < 0) {
+                                apply_or_opt(t_, p, s1, s2, n, u, v,
+                                             reversed);
+                                ++applied_;
+                                z += delta;
+                                wake(p), wake(n), wake(u), wake(v);
+                                for (int i = 0; i < len; ++i)
+                                    wake(seg[i]);
+                                return true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    static bool in(const int* seg, int len, int c)
+    {
+        for (int i = 0; i < len; ++i)
+            if (seg[i] == c)
+                return true;
+        return false;
+    }
+
+    void wake(int c) { queue_.push(c); }
+
+    T& t_;
+    const Oracle& D_;
+    const Neighbors& C_;
+    int moves_;
+    ActiveQueue& queue_;
+    const Control* control_;
+    long long evaluated_, applied_;  // added to search_counters() at the end
+};
+
+// Neighbour-list local search with don't-look bits: apply improving moves
+// of the given kinds until none is left, and return the new length.  Each
+// move queues the endpoints of the edges it changed (active.h), and only
+// queued cities are looked at.  The tour representation is picked from the
+// instance size unless 'kind' says otherwise.  With asymmetric distances
+// the search is directed_or_opt() (directed.h) whatever 'moves' asks.
+long long optimize(std::vector<int>& tour, long long z, const Oracle& D,
+                   const Neighbors& C, int moves = OR2OPT,
+                   TourKind kind = AUTO_TOUR);
+
+// As above, but only the cities in 'dirty' are queued at first, e.g. the
+// endpoints of the edges a perturbation changed; the search then follows
+// the changes instead of sweeping all n cities.
+long long optimize(std::vector<int>& tour, long long z, const Oracle& D,
+                   const Neighbors& C, const std::vector<int>& dirty,
+                   int moves = OR2OPT, TourKind kind = AUTO_TOUR);
+
+}  // namespace tpf
+
+#endif
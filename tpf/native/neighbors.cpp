@@ -0,0 +1,208 @@
+#include "neighbors.h"
+
+#include <algorithm>
+
+#include "kdtree.h"
+
+namespace tpf {
+
+namespace {
+
+// The arcs of a sparse graph, cheapest first: no row is ever expanded.
+Neighbors graph_closest(const Graph& G, int k)
+{
+    int n = G.size();
+    Neighbors C;
+    C.first.resize(n + 1);
+    std::vector<std::pair<int, int> > dlist;
+    for (int i = 0; i < n; ++i) {
+        C.first[i] = static_cast<int>(C.city.size());
+        dlist.clear();
+        for (int a = G.begin(i); a < G.end(i); ++a)
+            dlist.push_back(std::make_pair(G.cost(a), G.head(a)));
+        std::sort(dlist.begin(), dlist.end());
+        int m = static_cast<int>(dlist.size());
+        if (k > 0 && k < m)
+            m = k;
+        for (int r = 0; r < m; ++r) {
+            C.dist.push_back(dlist[r].first);
+            C.city.push_back(dlist[r].second);
+        }
+    }
+    C.first[n] = static_cast<int>(C.city.size());
+    return C;
+}
+
+}  // namespace
+
+Neighbors mk_closest(const Oracle& D, int k)
+{
+    if (D.graph())
+        return graph_closest(*D.graph(), k);
+    int n = D.size();
+    int m = n > 0 ? n - 1 : 0;
+    if (k <= 0 || k > m)
+        k = m;
+    Neighbors C;
+    C.first.resize(n + 1);
+    C.city.resize(static_cast<size_t>(n) * k);
+    C.dist.resize(C.city.size());
+
+    std::vector<int> row(n);
+    std::vector<std::pair<int, int> > dlist;
+    dlist.reserve(n);
+    size_t pos = 0;
+    for (int i = 0; i < n; ++i) {
+        C.first[i] = static_cast<int>(pos);
+        D.distances(i, &row[0]);
+        dlist.clear();
+        for (int j = 0; j < n; ++j)
+            if (j != i)
+                dlist.push_back(std::make_pair(row[j], j));
+        if (k < m)
+            std::nth_element(dlist.begin(), dlist.begin() + k, dlist.end());
+        std::sort(dlist.begin(), dlist.begin() + k);
+        for (int r = 0; r < k; ++r, ++pos) {
+            C.dist[pos] = dlist[r].first;
+            C.city[pos] = dlist[r].second;
+        }
+    }
+    C.first[n] = static_cast<int>(pos);
+    return C;
+}
+
+Neighbors mk_neighbors(const Oracle& D, int k, bool quadrant)
+{
+    const Problem* p = D.problem();
+    int n = D.size();
+    if (k <= 0 || k >= n - 1 || !p || p->type == EXPLICIT)
+        return mk_closest(D, k);
+
+    KdTree::Metric metric = p->type == MAN_2D
+                                ? KdTree::L1
+                                : (p->type == MAX_2D ? KdTree::LINF
+                                                     : KdTree::L2);
+    KdTree tree(&p->x[0], &p->y[0], n, metric);
+
+    Neighbors C;
+    C.first.resize(n + 1);
+    C.city.reserve(static_cast<size_t>(n) * k);
+    C.dist.reserve(static_cast<size_t>(n) * k);
+
+    std::vector<int> cand, found, dist(k);
+    std::vector<int> mark(n, -1);
+    std::vector<std::pair<int, int> > dlist;
+    for (int i = 0; i < n; ++i) {
+        C.first[i] = static_cast<int>(C.city.size());
+        cand.clear();
+        if (quadrant) {
+            for (int q = 0; q < 4; ++q) {
+                tree.nearest(i, k / 4, found, q);
+                for (size_t m = 0; m < found.size(); ++m) {
+                    mark[found[m]] = i;
+                    cand.push_back(found[m]);
+                }
+            }
+        }
+        if (static_cast<int>(cand.size()) < k) {
+            tree.nearest(i, k, found);
+            for (size_t m = 0; m < found.size()
+                               && static_cast<int>(cand.size()) < k;
+                 ++m)
+                if (mark[found[m]] != i)
+                    cand.push_back(found[m]);
+        }
+
+        int m = static_cast<int>(cand.size());
+        D.distances(i, &cand[0], m, &dist[0]);
+        dlist.clear();
+        for (int r = 0; r < m; ++r)
+            dlist.push_back(std::make_pair(dist[r], cand[r]));
+        std::sort(dlist.begin(), dlist.end());
+        for (int r = 0; r < m; ++r) {
+            C.dist.push_back(dlist[r].first);
+            C.city.push_back(dlist[r].second);
+        }
+    }
+    C.first[n] = static_cast<int>(C.city.size());
+    return C;
+}
+
+Neighbors mk_symmetric(const Neighbors& C, const Control* control)
+{
+    int n = static_cast<int>(C.first.size()) - 1;
+    auto stopping = [control](int i) {
+        return control && i % control_run == 0 && control->stopped();
+    };
+    std::vector<int> count(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        if (stopping(i))
+            return Neighbors();
+        for (int k = C.begin(i); k < C.end(i); ++k) {
+            ++count[i + 1];
+            ++count[C.city[k] + 1];
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        count[i + 1] += count[i];
+    std::vector<std::pair<int, int> > all(count[n]);
+    std::vector<int> fill(count.begin(), count.end() - 1);
+    for (int i = 0; i < n; ++i) {
+        if (stopping(i))
+            return Neighbors();
+        for (int k = C.begin(i); k < C.end(i); ++k) {
+            int j = C.city[k];
+            all[fill[i]++] = std::make_pair(C.dist[k], j);
+            all[fill[j]++] = std::make_pair(C.dist[k], i);
+        }
+    }
+
+    Neighbors S;
+    S.first.resize(n + 1);
+    S.city.reserve(all.size());
+    S.dist.reserve(all.size());
+    for (int i = 0; i < n; ++i) {
+        if (stopping(i))
+            return Neighbors();
+        S.first[i] = static_cast<int>(S.city.size());
+        std::sort(all.begin() + count[i], all.begin() + count[i + 1]);
+        for (int k = count[i]; k < count[i + 1]; ++k) {
+            if (k > count[i] && all[k] == all[k - 1])
+                continue;
+            S.dist.push_back(all[k].first);
+            S.city.push_back(all[k].second);
+        }
+    }
+    S.first[n] = static_cast<int>(S.city.size());
+    return S;
+}
+
+Neighbors mk_reverse(const Neighbors& C)
+{
+    int n = static_cast<int>(C.first.size()) - 1;
+    std::vector<int> count(n + 1, 0);
+    for (int k = 0; k < C.first[n]; ++k)
+        ++count[C.city[k] + 1];
+    for (int i = 0; i < n; ++i)
+        count[i + 1] += count[i];
+    std::vector<std::pair<int, int> > all(count[n]);
+    std::vector<int> fill(count.begin(), count.end() - 1);
+    for (int i = 0; i < n; ++i)
+        for (int k = C.begin(i); k < C.end(i); ++k)
+            all[fill[C.city[k]]++] = std::make_pair(C.dist[k], i);
+
+    Neighbors R;
+    R.first.assign(count.begin(), count.end());
+    R.city.resize(all.size());
+    R.dist.resize(all.size());
+    for (int j = 0; j < n; ++j) {
+        std::sort(all.begin() + count[j], all.begin() + count[j + 1]);
+        for (int k = count[j]; k < count[j + 1]; ++k) {
+            R.dist[k] = all[k].first;
+            R.city[k] = all[k].second;
+        }
+    }
+    return R;
+}
+
+}  // namespace tpf
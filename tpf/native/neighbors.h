@@ -0,0 +1,57 @@
+#ifndef TPF_NEIGHBORS_H
+#define TPF_NEIGHBORS_H
+
+#include <vector>
+
+#include "control.h"
+#include "oracle.h"
+
+namespace tpf {
+
+// Candidate neighbour lists in compressed (CSR) form: the neighbours of
+// city i are city[first[i]] .. city[first[i+1]-1], sorted by increasing
+// distance dist[k] = D(i, city[k]) and, for ties, by city index.
+struct Neighbors {
+    std::vector<int> first;
+    std::vector<int> city;
+    std::vector<int> dist;
+
+    int begin(int i) const { return first[i]; }
+    int end(int i) const { return first[i + 1]; }
+};
+
+// Neighbour list length used when none is asked for: complete lists (as
+// utils.py) up to a few thousand cities, short lists beyond that.
+inline int default_neighbors(int n)
+{
+    return n <= 5000 ? 0 : 16;
+}
+
+// Compute the sorted list of neighbours for each of the nodes, keeping the
+// k closest ones (all of them when k is 0).  O(n^2) distance evaluations,
+// except on a sparse graph, whose lists are the arcs leaving each city.
+// With asymmetric distances the lists are of the arcs from each city.
+Neighbors mk_closest(const Oracle& D, int k = 0);
+
+// Candidate lists of length k built with a k-d tree in O(n log n): the k
+// nearest neighbours of each city or, with 'quadrant', the k/4 nearest in
+// each quadrant around it topped up with the nearest overall.  Instances
+// without coordinates, and k = 0, go through mk_closest.  GEO instances
+// are searched on raw latitude/longitude, which gives slightly different
+// but equally useful candidates.
+Neighbors mk_neighbors(const Oracle& D, int k, bool quadrant = false);
+
+// The union of the lists of C and their reverse: j is a neighbour of i
+// whenever i is one of j's, sorted as in C.  Assumes symmetric distances.
+// Once 'control', polled every few thousand cities, stops, no lists at all
+// (empty 'first').
+Neighbors mk_symmetric(const Neighbors& C, const Control* control = 0);
+
+// The lists of C reversed: i is a neighbour of j whenever j is one of i's,
+// at distance D(i,j), sorted likewise.  For asymmetric distances these
+// are the arcs into each city.
+Neighbors mk_reverse(const Neighbors& C);
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,143 @@
+#include "oracle.h"
+
+#include <algorithm>
+
+namespace tpf {
+
+namespace {
+
+template <class F>
+bool is_symmetric(const F& D, int n)
+{
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < i; ++j)
+            if (D(i, j) != D(j, i))
+                return false;
+    return true;
+}
+
+}  // namespace
+
+Oracle::Oracle()
+    : n_(0), symmetric_(true), cache_rows_(0), head_(-1), tail_(-1),
+      used_(0), hits_(0), misses_(0)
+{
+}
+
+Oracle::Oracle(const Problem& p, int cache_rows)
+    : n_(p.n), problem_(std::make_shared<Problem>(p)),
+      symmetric_(p.type != EXPLICIT || !p.full_matrix
+                 || is_symmetric([&p](int i, int j) {
+                        return p.distance(i, j);
+                    }, p.n)),
+      cache_rows_(cache_rows < p.n ? cache_rows : p.n), head_(-1),
+      tail_(-1), used_(0), hits_(0), misses_(0)
+{
+    if (cache_rows_ > 0) {
+        cache_.resize(static_cast<size_t>(cache_rows_) * n_);
+        slot_of_.assign(n_, -1);
+        city_of_.assign(cache_rows_, -1);
+        prev_.assign(cache_rows_, -1);
+        next_.assign(cache_rows_, -1);
+    }
+}
+
+Oracle::Oracle(const Matrix& D)
+    : n_(D.size()), matrix_(std::make_shared<Matrix>(D)),
+      symmetric_(is_symmetric(D, D.size())), cache_rows_(0), head_(-1),
+      tail_(-1), used_(0), hits_(0), misses_(0)
+{
+}
+
+Oracle::Oracle(const Graph& G)
+    : n_(G.size()), graph_(std::make_shared<Graph>(G)),
+      symmetric_(G.symmetric()), cache_rows_(0), head_(-1), tail_(-1),
+      used_(0), hits_(0), misses_(0)
+{
+}
+
+void Oracle::touch(int slot) const
+{
+    if (slot == head_)
+        return;
+    // unlink
+    if (prev_[slot] >= 0)
+        next_[prev_[slot]] = next_[slot];
+    if (next_[slot] >= 0)
+        prev_[next_[slot]] = prev_[slot];
+    if (tail_ == slot)
+        tail_ = prev_[slot];
+    // push front
+    prev_[slot] = -1;
+    next_[slot] = head_;
+    if (head_ >= 0)
+        prev_[head_] = slot;
+    head_ = slot;
+    if (tail_ < 0)
+        tail_ = slot;
+}
+
+const int* Oracle::row(int i) const
+{
+    if (matrix_)
+        return matrix_->row(i);
+    if (graph_ || cache_rows_ == 0) {
+        scratch_.resize(n_);
+        distances(i, &scratch_[0]);
+        return &scratch_[0];
+    }
+
+    int slot = slot_of_[i];
+    if (slot >= 0) {
+        ++hits_;
+    } else {
+        ++misses_;
+        if (used_ < cache_rows_) {
+            slot = used_++;
+        } else {
+            slot = tail_;  // evict the least recently used row
+            slot_of_[city_of_[slot]] = -1;
+        }
+        int* out = &cache_[static_cast<size_t>(slot) * n_];
+        distances(i, out);
+        city_of_[slot] = i;
+        slot_of_[i] = slot;
+    }
+    touch(slot);
+    return &cache_[static_cast<size_t>(slot) * n_];
+}
+
+void Oracle::distances(int i, const int* js, int m, int* out) const
+{
+    if (matrix_ || graph_ || problem_->type == EXPLICIT) {
+        for (int k = 0; k < m; ++k)
+            out[k] = (*this)(i, js[k]);
+        return;
+    }
+    const Problem& p = *problem_;
+    tpf::distances(p.type, p.rounding, &p.x[0], &p.y[0], i, js, m, out);
+}
+
+void Oracle::distances(int i, int* out) const
+{
+    if (matrix_) {
+        const int* r = matrix_->row(i);
+        std::copy(r, r + n_, out);
+        return;
+    }
+    if (graph_) {
+        std::fill(out, out + n_, no_arc);
+        for (int k = graph_->begin(i); k < graph_->end(i); ++k)
+            out[graph_->head(k)] = graph_->cost(k);
+        return;
+    }
+    const Problem& p = *problem_;
+    if (p.type == EXPLICIT) {
+        for (int j = 0; j < n_; ++j)
+            out[j] = p.distance(i, j);
+        return;
+    }
+    tpf::distances(p.type, p.rounding, &p.x[0], &p.y[0], i, n_, out);
+}
+
+}  // namespace tpf
@@ -0,0 +1,87 @@
+#ifndef TPF_ORACLE_H
+#define TPF_ORACLE_H
+
+#include <memory>
+#include <vector>
+
+#include "graph.h"
+#include "matrix.h"
+#include "tsplib.h"
+
+namespace tpf {
+
+// Distance oracle: D(i,j) for every consumer of distances.
+//
+// Built from a Problem, coordinate distances are computed on demand from
+// the SoA coordinates (rows and batches through the SIMD kernels of
+// distance.h) and explicit weights are read from their packed
+// form, so no n x n matrix is ever materialised.  Built from a Matrix
+// (e.g. the dict matrices of utils.py) it simply indexes it; built from a
+// sparse Graph it looks arcs up in their rows, and the arcs missing cost
+// no_arc.  Distances may be asymmetric (see symmetric()).
+//
+// The instance data is shared between copies.  An oracle may also keep a
+// bounded LRU cache of whole rows, filled by row(i); point lookups use a
+// cached row when there is one.  The cache is per copy and not
+// thread-safe: threads should each work on their own copy.
+class Oracle {
+public:
+    Oracle();
+    explicit Oracle(const Problem& p, int cache_rows = 0);
+    explicit Oracle(const Matrix& D);
+    explicit Oracle(const Graph& G);
+
+    int size() const { return n_; }
+
+    // D(i,j) == D(j,i) for all i, j; checked once when built.  Searches
+    // that reverse paths (2-opt, Lin-Kernighan) need it.
+    bool symmetric() const { return symmetric_; }
+
+    int operator()(int i, int j) const
+    {
+        if (matrix_)
+            return (*matrix_)(i, j);
+        if (graph_)
+            return (*graph_)(i, j);
+        if (slot_of_.empty() || slot_of_[i] < 0)
+            return problem_->distance(i, j);
+        return cache_[static_cast<size_t>(slot_of_[i]) * n_ + j];
+    }
+
+    // Distances from i to every city, cached if the cache is enabled.
+    // The pointer is only valid until the next call to row().
+    const int* row(int i) const;
+
+    // Distances from i to cities js[0..m-1] written to out.
+    void distances(int i, const int* js, int m, int* out) const;
+
+    // Distances from i to cities 0..n-1 written to out.
+    void distances(int i, int* out) const;
+
+    const Problem* problem() const { return problem_.get(); }
+    const Graph* graph() const { return graph_.get(); }
+
+    long long cache_hits() const { return hits_; }
+    long long cache_misses() const { return misses_; }
+
+private:
+    void touch(int slot) const;
+
+    int n_;
+    std::shared_ptr<const Problem> problem_;
+    std::shared_ptr<const Matrix> matrix_;
+    std::shared_ptr<const Graph> graph_;
+    bool symmetric_;
+
+    // LRU row cache: slots form a doubly linked list, most recent first
+    int cache_rows_;
+    mutable std::vector<int> cache_;
+    mutable std::vector<int> slot_of_, city_of_, prev_, next_;
+    mutable int head_, tail_, used_;
+    mutable std::vector<int> scratch_;
+    mutable long long hits_, misses_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,231 @@
+#include "partition.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "construct.h"
+#include "kdtree.h"
+#include "pool.h"
+
+namespace tpf {
+
+namespace {
+
+void split(const Problem& p, int* lo, int* hi, int cell_size,
+           std::vector<std::vector<int> >& cells)
+{
+    if (hi - lo <= cell_size) {
+        cells.push_back(std::vector<int>(lo, hi));
+        return;
+    }
+    double xmin = p.x[*lo], xmax = xmin, ymin = p.y[*lo], ymax = ymin;
+    for (int* c = lo; c < hi; ++c) {
+        xmin = std::min(xmin, p.x[*c]);
+        xmax = std::max(xmax, p.x[*c]);
+        ymin = std::min(ymin, p.y[*c]);
+        ymax = std::max(ymax, p.y[*c]);
+    }
+    const std::vector<double>& v = xmax - xmin >= ymax - ymin ? p.x : p.y;
+    int* mid = lo + (hi - lo) / 2;
+    std::nth_element(lo, mid, hi, [&v](int a, int b) {
+        return v[a] < v[b] || (v[a] == v[b] && a < b);
+    });
+    split(p, lo, mid, cell_size, cells);
+    split(p, mid, hi, cell_size, cells);
+}
+
+// The cities of 'cell' as an instance of their own.
+Problem sub_problem(const Problem& p, const std::vector<int>& cell)
+{
+    Problem s;
+    s.name = p.name;
+    s.n = static_cast<int>(cell.size());
+    s.type = p.type;
+    s.rounding = p.rounding;
+    s.x.resize(s.n);
+    s.y.resize(s.n);
+    for (int i = 0; i < s.n; ++i) {
+        s.x[i] = p.x[cell[i]];
+        s.y[i] = p.y[cell[i]];
+    }
+    return s;
+}
+
+// Tour of one cell, in the city numbers of the whole instance.
+Tour cell_tour(const Problem& p, const std::vector<int>& cell, int moves)
+{
+    int m = static_cast<int>(cell.size());
+    if (m < 4)
+        return cell;
+    Oracle D(sub_problem(p, cell));
+    Neighbors C = mk_neighbors(D, partition_neighbors, true);
+    Tour t = greedy_tour(D, C);
+    optimize(t, length(t, D), D, C, moves);
+    for (int i = 0; i < m; ++i)
+        t[i] = cell[t[i]];
+    return t;
+}
+
+// Order in which to join the cells: a tour of their centroids.
+std::vector<int> cell_order(const Problem& p,
+                            const std::vector<std::vector<int> >& cells)
+{
+    Problem c;
+    c.n = static_cast<int>(cells.size());
+    c.type = p.type;
+    c.rounding = p.rounding;
+    for (size_t k = 0; k < cells.size(); ++k) {
+        double x = 0, y = 0;
+        for (size_t i = 0; i < cells[k].size(); ++i) {
+            x += p.x[cells[k][i]];
+            y += p.y[cells[k][i]];
+        }
+        c.x.push_back(x / cells[k].size());
+        c.y.push_back(y / cells[k].size());
+    }
+    Oracle D(c);
+    Tour t = space_filling_tour(D);
+    if (c.n >= 5)
+        optimize(t, length(t, D), D, mk_closest(D, partition_neighbors),
+                 OR2OPT);
+    return t;
+}
+
+}  // namespace
+
+std::vector<std::vector<int> > kd_partition(const Problem& p, int cell_size)
+{
+    if (cell_size < 1)
+        throw std::runtime_error("cell size must be positive");
+    std::vector<std::vector<int> > cells;
+    if (p.n == 0)
+        return cells;
+    std::vector<int> cities(p.n);
+    for (int i = 0; i < p.n; ++i)
+        cities[i] = i;
+    split(p, &cities[0], &cities[0] + p.n, cell_size, cells);
+    return cells;
+}
+
+Tour partition_tour(const Oracle& D, const Neighbors& C, int cell_size,
+                    int moves, int threads)
+{
+    const Problem* p = D.problem();
+    if (!p || p->type == EXPLICIT)
+        throw std::runtime_error("partition needs coordinates");
+    int n = p->n;
+    std::vector<std::vector<int> > cells = kd_partition(*p, cell_size);
+    if (cells.empty())
+        return Tour();
+
+    std::vector<Tour> tours(cells.size());
+    {
+        ThreadPool pool(threads);
+        for (size_t k = 0; k < cells.size(); ++k)
+            pool.submit([&, k](int) {
+                tours[k] = cell_tour(*p, cells[k], moves);
+            });
+        pool.wait();
+    }
+    std::vector<int> order = cell_order(*p, cells);
+
+    // cell of each city and its position in the cell tour
+    std::vector<int> cell_of(n), at(n);
+    for (size_t k = 0; k < tours.size(); ++k)
+        for (size_t i = 0; i < tours[k].size(); ++i) {
+            cell_of[tours[k][i]] = static_cast<int>(k);
+            at[tours[k][i]] = static_cast<int>(i);
+        }
+
+    // Patch the cells into one cycle, kept as next/prev links; the tree
+    // holds the cities joined so far.
+    KdTree::Metric metric = p->type == MAN_2D
+                                ? KdTree::L1
+                                : (p->type == MAX_2D ? KdTree::LINF
+                                                     : KdTree::L2);
+    KdTree tree(&p->x[0], &p->y[0], n, metric);
+    for (int i = 0; i < n; ++i)
+        tree.erase(i);
+    std::vector<int> next(n, -1), prev(n, -1);
+    std::vector<int> dirty;
+    {
+        const Tour& t = tours[order[0]];
+        int m = static_cast<int>(t.size());
+        for (int i = 0; i < m; ++i) {
+            next[t[i]] = t[(i + 1) % m];
+            prev[t[(i + 1) % m]] = t[i];
+            tree.insert(t[i]);
+        }
+    }
+    std::vector<int> cand;
+    for (size_t q = 1; q < order.size(); ++q) {
+        const Tour& t = tours[order[q]];
+        int m = static_cast<int>(t.size());
+        // remove (b, nb) from the cell and (c, nc) from the tour, then
+        // add (b, c) and (nb, nc)
+        long long best = 0;
+        int bb = -1, bnb = -1, bc = -1, bnc = -1;
+        for (int i = 0; i < m; ++i) {
+            int b = t[i];
+            cand.clear();
+            for (int k = C.begin(b); k < C.end(b); ++k)
+                if (next[C.city[k]] >= 0)
+                    cand.push_back(C.city[k]);
+            cand.push_back(tree.nearest(b));
+            for (int s = 0; s < 2; ++s) {
+                int nb = t[s == 0 ? (i + 1) % m : (i + m - 1) % m];
+                for (size_t r = 0; r < cand.size(); ++r) {
+                    int c = cand[r];
+                    for (int w = 0; w < 2; ++w) {
+                        int nc = w == 0 ? next[c] : prev[c];
+                        long long delta = static_cast<long long>(D(b, c))
+                                          + D(nb, nc) - D(b, nb) - D(c, nc);
+                        if (bb < 0 || delta < best) {
+                            best = delta;
+                            bb = b, bnb = nb, bc = c, bnc = nc;
+                        }
+                    }
+                }
+            }
+        }
+
+        // the cell path x..y goes in between tour edge (u, v)
+        int u = bc, v = bnc, x = bb, y = bnb;
+        if (next[bc] != bnc) {
+            u = bnc, v = bc, x = bnb, y = bb;
+        }
+        int ix = at[x], step = t[(ix + 1) % m] == y ? m - 1 : 1;
+        int last = u;
+        for (int i = 0, j = ix; i < m; ++i, j = (j + step) % m) {
+            next[last] = t[j];
+            prev[t[j]] = last;
+            last = t[j];
+            tree.insert(t[j]);
+        }
+        next[last] = v;
+        prev[v] = last;
+        dirty.push_back(u), dirty.push_back(v);
+        dirty.push_back(x), dirty.push_back(y);
+    }
+
+    Tour tour;
+    tour.reserve(n);
+    int c = 0;
+    do {
+        tour.push_back(c);
+        c = next[c];
+    } while (c != 0);
+    std::vector<Tour>().swap(tours);
+
+    for (int i = 0; i < n; ++i)
+        for (int k = C.begin(i); k < C.end(i); ++k)
+            if (cell_of[C.city[k]] != cell_of[i]) {
+                dirty.push_back(i);
+                break;
+            }
+    if (!dirty.empty())
+        optimize(tour, length(tour, D), D, C, dirty, moves);
+    return tour;
+}
+
+}  // namespace tpf
@@ -0,0 +1,40 @@
+#ifndef TPF_PARTITION_H
+#define TPF_PARTITION_H
+
+#include <vector>
+
+#include "localsearch.h"
+#include "moves.h"
+
+namespace tpf {
+
+// Karp's partitioning: split the cities at the median of the longer side
+// of their bounding box, as KdTree does, until no part has more than
+// 'cell_size' cities.  The cells are returned in tree order.
+std::vector<std::vector<int> > kd_partition(const Problem& p, int cell_size);
+
+// Decomposition for very large coordinate instances.
+//
+// The cities are partitioned into k-d cells of at most 'cell_size'
+// cities (kd_partition), and each cell is toured on its own: greedy edge,
+// then optimize() with 'moves' on candidate lists of the cell.  Cells are
+// solved in parallel on a pool of 'threads' threads (0 for one per
+// hardware thread), each with a sub-instance of its own, so memory grows
+// with n and the threads, not with the size of the search.
+//
+// The cell tours are then patched one at a time into a single tour, in
+// the order of a tour of the cell centroids: each is cut open at the edge
+// and joined at the tour edge, among the candidates of C and the nearest
+// city already joined, that add least.  A last optimize() with 'moves'
+// over the whole tour starts from the cities with a candidate in another
+// cell only, so it works along the boundaries.  Throws on instances
+// without coordinates.
+Tour partition_tour(const Oracle& D, const Neighbors& C, int cell_size,
+                    int moves = LIN_KERNIGHAN, int threads = 0);
+
+// Candidate list length within a cell.
+const int partition_neighbors = 10;
+
+}  // namespace tpf
+
+#endif
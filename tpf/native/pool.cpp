@@ -0,0 +1,104 @@
+#include "pool.h"
+
+namespace tpf {
+
+ThreadPool::ThreadPool(int threads)
+    : queued_(0), pending_(0), turn_(0), stop_(false)
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0)
+        threads = 1;
+    for (int w = 0; w < threads; ++w)
+        queues_.push_back(std::unique_ptr<Queue>(new Queue));
+    for (int w = 0; w < threads; ++w)
+        threads_.push_back(std::thread(&ThreadPool::work, this, w));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    ready_.notify_all();
+    for (size_t w = 0; w < threads_.size(); ++w)
+        threads_[w].join();
+}
+
+void ThreadPool::submit(const Task& task)
+{
+    ++pending_;
+    Queue& q = *queues_[turn_++ % queues_.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++queued_;
+    }
+    ready_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return pending_ == 0; });
+    if (error_) {
+        std::exception_ptr e = error_;
+        error_ = std::exception_ptr();
+        std::rethrow_exception(e);
+    }
+}
+
+bool ThreadPool::take(int w, Task& task)
+{
+    int n = size();
+    for (int k = 0; k < n; ++k) {
+        Queue& q = *queues_[(w + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty())
+            continue;
+        if (k == 0) {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+        } else {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::work(int w)
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return stop_ || queued_ > 0; });
+            if (stop_)
+                return;
+            --queued_;
+        }
+        // A task is reserved for this worker; some deque holds it, though
+        // maybe not its own.
+        Task task;
+        while (!take(w, task))
+            std::this_thread::yield();
+        try {
+            task(w);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+        }
+        if (--pending_ == 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_.notify_all();
+        }
+    }
+}
+
+}  // namespace tpf
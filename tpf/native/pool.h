@@ -0,0 +1,60 @@
+#ifndef TPF_POOL_H
+#define TPF_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tpf {
+
+// Fixed set of worker threads with one task deque each.  Tasks are dealt
+// to the deques in turn; a worker takes from the back of its own deque and,
+// when that is empty, steals from the front of the others.
+class ThreadPool {
+public:
+    // The task is given the index of the worker running it, in
+    // [0, size()), so that it can use per-worker state.
+    typedef std::function<void(int worker)> Task;
+
+    // 'threads' = 0 uses one thread per hardware thread.
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(threads_.size()); }
+
+    void submit(const Task& task);
+
+    // Block until every submitted task has run.  The first exception a
+    // task threw, if any, is rethrown here.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void work(int w);
+    bool take(int w, Task& task);
+
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable ready_;  // a task was queued, or stop_
+    std::condition_variable idle_;   // pending_ dropped to zero
+    int queued_;                     // tasks in the deques, under mutex_
+    std::atomic<int> pending_;       // tasks queued or running
+    std::atomic<unsigned> turn_;
+    bool stop_;
+    std::exception_ptr error_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,101 @@
+#include "solve.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#include "bound.h"
+#include "ils.h"
+
+namespace tpf {
+
+Outcome solve(const Oracle& D, const Neighbors& C, const Budget& budget,
+              const Listener& listener, Control* control, unsigned seed,
+              int moves, Start start)
+{
+    if (budget.seconds <= 0 && budget.iterations <= 0 && !control)
+        throw std::runtime_error("solve: no time or iteration limit");
+    Control::clock::time_point begin = Control::clock::now();
+    auto elapsed = [begin] {
+        return std::chrono::duration<double>(Control::clock::now() - begin)
+            .count();
+    };
+
+    // 'inner' stops at the deadline, at the gap, or with 'control'
+    Control inner(control);
+    if (budget.seconds > 0)
+        inner.set_deadline(budget.seconds);
+    std::atomic<long long> bound(budget.bound), best(-1);
+    auto within = [&](long long z) {
+        long long b = bound.load();
+        return budget.gap >= 0 && b >= 0 && z <= gap_target(b, budget.gap);
+    };
+    auto found = [&](long long z, long long iterations) {
+        best = z;
+        if (listener) {
+            Progress p = {z, bound.load(), iterations, elapsed()};
+            listener(p);
+        }
+        if (within(z))
+            inner.stop();
+    };
+
+    Outcome out;
+    std::mt19937 rng(seed);
+    out.tour = initial_tour(start, D, C, rng, &inner);
+    out.z = length(out.tour, D);
+    found(out.z, 0);
+    inner.on_improved = [&](long long z, long long iterations) {
+        if (z < best.load())
+            found(z, iterations);
+    };
+
+    Control bounding(&inner);
+    Oracle Dh(D);  // the helper's own copy, for its cache
+    std::exception_ptr error;
+    std::thread helper;
+    if (budget.gap >= 0 && budget.bound < 0 && !inner.stopped()
+        && D.size() <= held_karp_dense_limit) {
+        long long upper = out.z;
+        helper = std::thread([&, upper] {
+            try {
+                HeldKarp hk = held_karp(Dh, C, upper, 0, &bounding);
+                // only a proven bound: the sparse one is an estimate
+                if (!bounding.stopped() && hk.exact) {
+                    bound = hk.bound;
+                    if (within(best.load()))
+                        inner.stop();
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+    }
+
+    try {
+        if (!inner.stopped())
+            out.z = iterated_local_search(out.tour, out.z, D, C, rng,
+                                          budget.iterations, 0, moves,
+                                          Report(), &inner);
+    } catch (...) {
+        bounding.stop();
+        if (helper.joinable())
+            helper.join();
+        throw;
+    }
+    bounding.stop();
+    if (helper.joinable())
+        helper.join();
+    if (error)
+        std::rethrow_exception(error);
+
+    out.bound = bound.load();
+    out.iterations = inner.iterations();
+    out.seconds = elapsed();
+    out.stopped = control && control->stopped();
+    return out;
+}
+
+}  // namespace tpf
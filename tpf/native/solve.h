@@ -0,0 +1,67 @@
+#ifndef TPF_SOLVE_H
+#define TPF_SOLVE_H
+
+#include <functional>
+
+#include "construct.h"
+#include "control.h"
+#include "localsearch.h"
+#include "moves.h"
+
+namespace tpf {
+
+// Limits of an anytime solve(); the search ends at the first one reached.
+struct Budget {
+    double seconds;        // wall-clock time, 0 for none
+    long long iterations;  // double-bridge kicks, 0 for none
+    double gap;            // stop within this fraction of 'bound', < 0: none
+    long long bound;       // lower bound for 'gap'; -1: Held-Karp's
+
+    Budget() : seconds(0), iterations(0), gap(-1), bound(-1) {}
+};
+
+// State of an anytime solve() when its incumbent changes.
+struct Progress {
+    long long z;           // length of the incumbent
+    long long bound;       // lower bound known so far, or -1
+    long long iterations;  // kicks done
+    double seconds;        // since solve() began
+};
+
+typedef std::function<void(const Progress& progress)> Listener;
+
+struct Outcome {
+    Tour tour;
+    long long z;
+    long long bound;       // lower bound known at the end, or -1
+    long long iterations;
+    double seconds;
+    bool stopped;          // by 'control' rather than by the budget
+};
+
+// Anytime solver: the best tour it can find within a budget.
+//
+// A starting tour of kind 'start' is improved by iterated local search with
+// 'moves' (ils.h), which can be interrupted between any two moves.  With a
+// gap budget and no bound given, the Held-Karp bound is computed on a
+// second thread meanwhile, from the length of the starting tour, and the
+// gap applies once it is known.  Beyond held_karp_dense_limit cities
+// Held-Karp only estimates the bound (bound.h), so there the gap applies
+// to a given bound only, and no bound is reported otherwise.  'listener'
+// is called from the searching thread with each new incumbent and the
+// bound known by then; it is given lengths only, so that it stays cheap
+// on large instances.
+//
+// 'control', if given, stops the search from any other thread within
+// microseconds of its stop(), and the construction of the starting tour
+// within milliseconds, leaving the cities in index order.
+// A budget without seconds or iterations requires one.  Kicks are drawn
+// from 'seed'.
+Outcome solve(const Oracle& D, const Neighbors& C, const Budget& budget,
+              const Listener& listener = Listener(), Control* control = 0,
+              unsigned seed = 1, int moves = LIN_KERNIGHAN | OR2OPT,
+              Start start = GREEDY_START);
+
+}  // namespace tpf
+
+#endif
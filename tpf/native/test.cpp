@@ -0,0 +1,890 @@
+// Sanity checks for the native engine, in the spirit of tpf/test.py.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "bound.h"
+#include "branch.h"
+#include "construct.h"
+#include "crossover.h"
+#include "cuts.h"
+#include "directed.h"
+#include "ils.h"
+#include "lk.h"
+#include "localsearch.h"
+#include "lp.h"
+#include "moves.h"
+#include "partition.h"
+#include "pool.h"
+#include "solve.h"
+#include "tour.h"
+#include "tsplib.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+                        #cond);                                            \
+            ++failures;                                                    \
+        }                                                                  \
+    } while (0)
+
+using namespace tpf;
+
+static bool is_permutation(const Tour& tour, int n)
+{
+    std::vector<bool> seen(n, false);
+    if (static_cast<int>(tour.size()) != n)
+        return false;
+    for (size_t i = 0; i < tour.size(); ++i) {
+        if (tour[i] < 0 || tour[i] >= n || seen[tour[i]])
+            return false;
+        seen[tour[i]] = true;
+    }
+    return true;
+}
+
+static void test_toy()
+{
+    Point xy[] = {{4, 0}, {5, 6}, {8, 3}, {4, 4}, {4, 1},
+                  {4, 10}, {4, 7}, {6, 8}, {8, 1}};
+    std::vector<Point> coord(xy, xy + 9);
+    Oracle D(mk_matrix(coord, dist_l2));
+    Neighbors C = mk_closest(D);
+    CHECK(C.end(0) - C.begin(0) == 8);
+    for (int k = C.begin(0) + 1; k < C.end(0); ++k)
+        CHECK(C.dist[k - 1] <= C.dist[k]);
+
+    std::mt19937 rng(1);
+    for (int r = 0; r < 20; ++r) {
+        Tour tour = randtour(9, rng);
+        long long z = localsearch(tour, length(tour, D), D, C);
+        CHECK(is_permutation(tour, 9));
+        CHECK(z == length(tour, D));
+    }
+}
+
+static void test_exchange()
+{
+    Tour tour;
+    for (int i = 0; i < 8; ++i)
+        tour.push_back(i);
+    std::vector<int> tinv(tour);
+    exchange(tour, tinv, 5, 1);
+    int expect[] = {0, 1, 5, 4, 3, 2, 6, 7};
+    CHECK(tour == Tour(expect, expect + 8));
+    for (int k = 0; k < 8; ++k)
+        CHECK(tinv[tour[k]] == k);
+
+    // lengths and deltas beyond the range of int
+    Matrix M(4);
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            M.at(i, j) = i == j ? 0 : (i + j) % 2 ? 1000000000 : 2000000000;
+    Oracle D(M);
+    Tour square;
+    for (int i = 0; i < 4; ++i)
+        square.push_back(i);
+    CHECK(length(square, D) == 4000000000LL);
+    CHECK(exchange_cost(square, 0, 2, D) == 2000000000LL);
+}
+
+static void test_tsplib(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p), M(mk_matrix(p));
+    Neighbors C = mk_closest(D);
+    std::mt19937 rng(1);
+    Solution best = multistart_localsearch(20, D, C, rng);
+    CHECK(is_permutation(best.tour, D.size()));
+    CHECK(best.z == length(best.tour, D));
+    CHECK(best.z >= optimum);
+
+    // the lazy oracle and the full matrix walk the same search
+    std::mt19937 rng2(1);
+    Solution same = multistart_localsearch(20, M, mk_closest(M), rng2);
+    CHECK(same.tour == best.tour);
+
+    Neighbors C5 = mk_closest(D, 5);
+    for (int i = 0; i < D.size(); ++i) {
+        CHECK(C5.end(i) - C5.begin(i) == 5);
+        for (int r = 0; r < 5; ++r)
+            CHECK(C5.city[C5.begin(i) + r] == C.city[C.begin(i) + r]);
+    }
+}
+
+static void test_oracle_cache()
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/berlin52.tsp");
+    Oracle D(p, 4);
+    for (int i = 0; i < 6; ++i)
+        D.row(i);  // rows 2..5 stay cached
+    CHECK(D.cache_misses() == 6 && D.cache_hits() == 0);
+    D.row(5);
+    D.row(2);
+    CHECK(D.cache_hits() == 2);
+    D.row(0);  // evicts row 3, the least recently used
+    D.row(2);
+    CHECK(D.cache_hits() == 3);
+    D.row(3);
+    CHECK(D.cache_misses() == 8);
+    for (int i = 0; i < p.n; ++i)
+        for (int j = 0; j < p.n; ++j)
+            CHECK(D(i, j) == p.distance(i, j));
+
+    Tour nn = nearest_neighbor(0, D);
+    CHECK(is_permutation(nn, p.n));
+    for (size_t k = 1; k + 1 < nn.size(); ++k)
+        for (size_t m = k + 1; m < nn.size(); ++m)
+            CHECK(D(nn[k - 1], nn[k]) <= D(nn[k - 1], nn[m]));
+}
+
+static void test_kernels()
+{
+    // the scalar kernel against TSPLIB's reference values
+    CHECK(distance(EUC_2D, NINT, 0, 0, 1, 1.5) == 2);
+    CHECK(distance(EUC_2D, TRUNCATE, 0, 0, 1, 1.5) == 1);
+    CHECK(distance(MAN_2D, NINT, 0, 0, 1.2, 1.3) == 3);
+    CHECK(distance(MAN_2D, TRUNCATE, 0, 0, 1.2, 1.3) == 2);
+
+    // every instruction set gives the scalar results, bit for bit
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> u(-1000.0, 1000.0);
+    const int n = 1003;
+    std::vector<double> x(n), y(n);
+    std::vector<int> js(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = u(rng);
+        y[i] = u(rng);
+        js[i] = (i * 7919) % n;
+    }
+    // GEO wants DDD.MM in range
+    std::vector<double> lat(n), lon(n);
+    for (int i = 0; i < n; ++i) {
+        lat[i] = x[i] / 12.0;
+        lon[i] = y[i] / 6.0;
+    }
+
+    SimdLevel best = simd_level();
+    EdgeWeightType types[] = {EUC_2D, CEIL_2D, MAN_2D, MAX_2D, ATT, GEO};
+    Rounding roundings[] = {NINT, TRUNCATE};
+    std::vector<int> out(n), gathered(n);
+    for (int level = SIMD_SCALAR; level <= best; ++level) {
+        set_simd_level(SimdLevel(level));
+        for (size_t t = 0; t < 6; ++t) {
+            const double* px = types[t] == GEO ? &lat[0] : &x[0];
+            const double* py = types[t] == GEO ? &lon[0] : &y[0];
+            for (int r = 0; r < 2; ++r) {
+                for (int i = 0; i < n; i += 97) {
+                    distances(types[t], roundings[r], px, py, i, n, &out[0]);
+                    distances(types[t], roundings[r], px, py, i, &js[0], n,
+                              &gathered[0]);
+                    for (int j = 0; j < n; ++j) {
+                        int d = distance(types[t], roundings[r], px[i], py[i],
+                                         px[j], py[j]);
+                        CHECK(out[j] == d);
+                    }
+                    for (int k = 0; k < n; ++k)
+                        CHECK(gathered[k] == out[js[k]]);
+                }
+            }
+        }
+    }
+    set_simd_level(best);
+}
+
+static void test_candidates()
+{
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> u(0.0, 1000.0);
+    EdgeWeightType types[] = {EUC_2D, MAN_2D, MAX_2D, ATT};
+    for (size_t t = 0; t < 4; ++t) {
+        Problem p;
+        p.n = 2000;
+        p.type = types[t];
+        for (int i = 0; i < p.n; ++i) {
+            // a coarse grid, so that there are plenty of ties
+            p.x.push_back(std::floor(u(rng) / 8));
+            p.y.push_back(std::floor(u(rng) / 8));
+        }
+        Oracle D(p);
+        Neighbors brute = mk_closest(D, 10);
+        Neighbors tree = mk_neighbors(D, 10);
+        // rounding is monotone, so both see the same distances
+        CHECK(tree.first == brute.first);
+        CHECK(tree.dist == brute.dist);
+
+        Neighbors quad = mk_neighbors(D, 12, true);
+        for (int i = 0; i < p.n; ++i) {
+            CHECK(quad.end(i) - quad.begin(i) == 12);
+            std::vector<int> seen;
+            for (int k = quad.begin(i); k < quad.end(i); ++k) {
+                int j = quad.city[k];
+                CHECK(j != i && quad.dist[k] == D(i, j));
+                if (k > quad.begin(i))
+                    CHECK(quad.dist[k - 1] <= quad.dist[k]);
+                seen.push_back(j);
+            }
+            std::sort(seen.begin(), seen.end());
+            CHECK(std::unique(seen.begin(), seen.end()) == seen.end());
+        }
+    }
+
+    // quadrant candidates reach across a gap that plain k-nearest misses
+    Problem p;
+    p.n = 12;
+    p.type = EUC_2D;
+    for (int i = 0; i < 11; ++i) {
+        p.x.push_back(i);
+        p.y.push_back(0);
+    }
+    p.x.push_back(0);
+    p.y.push_back(100);
+    Oracle D(p);
+    Neighbors near = mk_neighbors(D, 4), quad = mk_neighbors(D, 4, true);
+    bool reaches = false;
+    for (int k = near.begin(0); k < near.end(0); ++k)
+        CHECK(near.city[k] != 11);
+    for (int k = quad.begin(0); k < quad.end(0); ++k)
+        reaches = reaches || quad.city[k] == 11;
+    CHECK(reaches);
+}
+
+template <class T>
+static void test_tour(const T& start)
+{
+    T t(start);
+    CHECK(t.next(7) == 0 && t.prev(0) == 7);
+    CHECK(t.between(6, 0, 1) && !t.between(1, 0, 6));
+    t.flip(1, 2, 4, 5);  // 0 1 4 3 2 5 6 7
+    CHECK(t.next(1) == 4 && t.next(2) == 5 && t.prev(3) == 4);
+    two_opt_move(t, 6, 7, 1, 4);  // the complement 4 .. 6 is shorter
+    CHECK(is_permutation(t.sequence(), 8));
+    // edges (6,7) and (1,4) became (6,1) and (7,4)
+    CHECK(t.next(6) == 1 || t.prev(6) == 1);
+    CHECK(t.next(7) == 4 || t.prev(7) == 4);
+}
+
+// Apply the same random 2-opt moves to t and to an array tour and compare
+// neighbours and between() after each one.
+template <class T>
+static void check_flips(T& t, const Tour& start, std::mt19937& rng)
+{
+    ArrayTour ref(start);
+    int n = ref.size();
+    for (int r = 0; r < 4000; ++r) {
+        int a = rng() % n, c = rng() % n;
+        if (a == c)
+            continue;
+        int b = ref.next(a), d = ref.next(c);
+        two_opt_move(ref, a, b, c, d);
+        two_opt_move(t, a, b, c, d);
+        bool same = t.next(a) == ref.next(a);
+        for (int k = 0; k < 8; ++k) {
+            int x = rng() % n, y = rng() % n, z = rng() % n;
+            CHECK(t.next(x) == (same ? ref.next(x) : ref.prev(x)));
+            CHECK(t.prev(t.next(x)) == x);
+            CHECK(t.between(x, y, z) ==
+                  (same ? ref.between(x, y, z) : ref.between(z, y, x)));
+        }
+    }
+    CHECK(is_permutation(t.sequence(), n));
+}
+
+static void test_tours()
+{
+    int seq[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    Tour small(seq, seq + 8);
+    test_tour(ArrayTour(small));
+    test_tour(LinkedTour(small));
+    test_tour(TwoLevelTour(small));
+    test_tour(TwoLevelTour(small, 2));
+
+    std::mt19937 rng(5);
+    Tour start = randtour(1000, rng);
+    LinkedTour linked(start);
+    check_flips(linked, start, rng);
+    TwoLevelTour two_level(start);
+    check_flips(two_level, start, rng);
+    TwoLevelTour tiny(start, 3);
+    check_flips(tiny, start, rng);
+    CHECK(tiny.segments() > 1);
+}
+
+static void test_moves(const char* name)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 8);
+    std::mt19937 rng(2);
+    long long sum2 = 0, sum_or2 = 0;
+    for (int r = 0; r < 10; ++r) {
+        Tour tour = randtour(p.n, rng);
+        long long z = optimize(tour, length(tour, D), D, C, TWO_OPT);
+        CHECK(is_permutation(tour, p.n));
+        CHECK(z == length(tour, D));
+        sum2 += z;
+
+        long long z2 = optimize(tour, z, D, C, OR2OPT);
+        CHECK(z2 <= z && z2 == length(tour, D));
+        sum_or2 += z2;
+
+        Tour other = randtour(p.n, rng);
+        long long z3 = optimize(other, length(other, D), D, C, OR_OPT);
+        CHECK(is_permutation(other, p.n));
+        CHECK(z3 == length(other, D));
+    }
+    CHECK(sum_or2 < sum2);
+
+    // re-optimise after reversing a random stretch of a local optimum
+    for (int moves = TWO_OPT; moves <= LIN_KERNIGHAN + OR2OPT; moves += 3) {
+        Tour tour = randtour(p.n, rng);
+        long long z = optimize(tour, length(tour, D), D, C, moves);
+        int i = rng() % (p.n - 20), j = i + 2 + rng() % 15;
+        std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+        long long kicked = length(tour, D);
+        int ends[] = {tour[i], tour[i + 1], tour[j], tour[j + 1]};
+        Tour dirty(ends, ends + 4);
+        long long z2 = optimize(tour, kicked, D, C, dirty, moves);
+        CHECK(is_permutation(tour, p.n));
+        CHECK(z2 == length(tour, D) && z2 <= kicked);
+        CHECK(z2 < kicked || kicked == z);
+    }
+
+    TourKind kinds[] = {LINKED_TOUR, TWO_LEVEL_TOUR};
+    for (int k = 0; k < 2; ++k) {
+        Tour tour = randtour(p.n, rng);
+        long long z = optimize(tour, length(tour, D), D, C, OR2OPT, kinds[k]);
+        CHECK(is_permutation(tour, p.n));
+        CHECK(z == length(tour, D));
+    }
+}
+
+static void test_lin_kernighan(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 12, true);
+    std::mt19937 rng(4);
+    long long best = -1, sum_lk = 0, sum_or2 = 0;
+    for (int r = 0; r < 10; ++r) {
+        Tour tour = randtour(p.n, rng), other = tour;
+        long long z = lin_kernighan(tour, length(tour, D), D, C);
+        CHECK(is_permutation(tour, p.n));
+        CHECK(z == length(tour, D));
+        CHECK(z >= optimum);
+        if (best < 0 || z < best)
+            best = z;
+        sum_lk += z;
+        sum_or2 += optimize(other, length(other, D), D, C, OR2OPT);
+    }
+    CHECK(sum_lk < sum_or2);
+    CHECK(best <= optimum * 102 / 100);
+
+    Tour tour = randtour(p.n, rng);
+    long long z = lin_kernighan(tour, length(tour, D), D, C, TWO_LEVEL_TOUR);
+    CHECK(is_permutation(tour, p.n));
+    CHECK(z == length(tour, D) && z >= optimum);
+}
+
+static void test_iterated(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 8);
+    std::mt19937 rng(6);
+    Solution multi = multistart_localsearch(10, D, C, rng, Report(), OR2OPT);
+
+    Tour tour = randtour(p.n, rng);
+    long long last = -1;
+    long long z = iterated_local_search(
+        tour, length(tour, D), D, C, rng, 3000, 0, OR2OPT,
+        [&last](long long z, const Tour&) {
+            CHECK(last < 0 || z < last);
+            last = z;
+        });
+    CHECK(is_permutation(tour, p.n));
+    CHECK(z == length(tour, D) && z == last);
+    CHECK(z >= optimum && z <= multi.z);
+    CHECK(z <= optimum * 102 / 100);
+
+    Tour other = randtour(p.n, rng);
+    z = iterated_local_search(other, length(other, D), D, C, rng, 300, 0,
+                              LIN_KERNIGHAN);
+    CHECK(z == length(other, D) && z >= optimum);
+}
+
+static void test_construction(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p), M(mk_matrix(p));  // with and without coordinates
+    Neighbors C = mk_neighbors(D, 10);
+    std::mt19937 rng(8);
+    for (int s = NEAREST_START; s <= CHEAPEST_START; ++s) {
+        Tour tour = initial_tour(Start(s), D, C, rng);
+        CHECK(is_permutation(tour, p.n));
+        long long z = length(tour, D);
+        CHECK(z >= optimum && z < optimum * 3 / 2);
+        if (s == SPACE_FILLING_START)
+            continue;
+        Tour plain = initial_tour(Start(s), M, C, rng);
+        CHECK(is_permutation(plain, p.n));
+        CHECK(length(plain, M) < optimum * 3 / 2);
+    }
+    CHECK(length(farthest_insertion(D), D) < optimum * 6 / 5);
+    CHECK(nearest_neighbor_tour(M, 3) == nearest_neighbor(3, D));
+}
+
+static void test_held_karp(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 12, true);
+    HeldKarp hk = held_karp(D, C);
+    CHECK(hk.exact);
+    CHECK(hk.bound <= optimum && hk.bound >= optimum * 98 / 100);
+    CHECK(static_cast<int>(hk.pi.size()) == p.n);
+
+    Neighbors A = alpha_neighbors(D, C, hk, 5, 3);
+    for (int i = 0; i < p.n; ++i) {
+        CHECK(A.end(i) - A.begin(i) == 5);
+        for (int k = A.begin(i); k < A.end(i); ++k) {
+            CHECK(A.dist[k] == D(i, A.city[k]));
+            CHECK(k == A.begin(i) || A.dist[k] >= A.dist[k - 1]);
+        }
+    }
+    CHECK(A.city == alpha_neighbors(D, C, hk, 5, 1).city);
+    Tour tour = greedy_tour(D, A);
+    CHECK(optimize(tour, length(tour, D), D, A, LIN_KERNIGHAN)
+          < optimum * 21 / 20);
+
+    // restarts stop at the first tour within 10% of the bound
+    long long target = gap_target(hk.bound, 0.1);
+    std::mt19937 rng(5);
+    Solution s = multistart_localsearch(100, D, C, rng, Report(), OR2OPT,
+                                        target);
+    CHECK(s.z <= target);
+    Solution t = multistart_localsearch(100, D, C, 5u, 3, Report(), OR2OPT,
+                                        target);
+    CHECK(t.z <= target && t.z == length(t.tour, D));
+    CHECK(t.tour == multistart_localsearch(100, D, C, 5u, 1, Report(),
+                                           OR2OPT, target).tour);
+}
+
+static void test_lp()
+{
+    // min -x - y  st  x + 2y <= 4, 3x + y <= 6, x - y >= -1, 0 <= x, y <= 3
+    std::unique_ptr<Lp> lp = mk_lp(SIMPLEX_LP);
+    int x = lp->add_column(-1, 0, 3, std::vector<int>(),
+                           std::vector<double>());
+    lp->add_row(std::vector<int>(1, x), std::vector<double>(1, 1), Lp::LESS,
+                4);
+    int y = lp->add_column(-1, 0, 3, std::vector<int>(1, 0),
+                           std::vector<double>(1, 2));
+    int cols[] = {x, y};
+    double a[] = {3, 1}, b[] = {1, -1};
+    lp->add_row(std::vector<int>(cols, cols + 2),
+                std::vector<double>(a, a + 2), Lp::LESS, 6);
+    lp->add_row(std::vector<int>(cols, cols + 2),
+                std::vector<double>(b, b + 2), Lp::GREATER, -1);
+    CHECK(lp->solve() == Lp::OPTIMAL);
+    CHECK(std::fabs(lp->objective() + 2.8) < 1e-9);  // x = 1.6, y = 1.2
+    std::vector<double> v, dual;
+    lp->primal(v);
+    lp->duals(dual);
+    CHECK(std::fabs(v[x] - 1.6) < 1e-9 && std::fabs(v[y] - 1.2) < 1e-9);
+    CHECK(dual[0] < 0 && dual[1] < 0 && std::fabs(dual[2]) < 1e-9);
+    lp->delete_rows(std::vector<int>(1, 2));
+    lp->set_bounds(x, 2, 2);
+    CHECK(lp->solve() == Lp::OPTIMAL);
+    CHECK(std::fabs(lp->objective() + 2) < 1e-9);  // x = 2, y = 0
+    lp->set_bounds(y, 2, 3);
+    CHECK(lp->solve() == Lp::INFEASIBLE);
+    lp->set_bounds(x, 0, 3);
+    CHECK(lp->solve() == Lp::OPTIMAL);
+    CHECK(std::fabs(lp->objective() + 2) < 1e-9);  // x = 0, y = 2
+    CHECK(!lp_backend_built(CPLEX_LP) || mk_lp(CPLEX_LP));
+
+    // two triangles joined by an edge at 1/2
+    Support s;
+    s.n = 6;
+    int ea[] = {0, 1, 2, 3, 4, 5, 0}, eb[] = {1, 2, 0, 4, 5, 3, 3};
+    double ex[] = {1, 1, 0.75, 1, 1, 0.75, 0.5};
+    s.a.assign(ea, ea + 7);
+    s.b.assign(eb, eb + 7);
+    s.x.assign(ex, ex + 7);
+    std::vector<Cut> cuts;
+    CHECK(subtour_cuts(s, cuts) == 1);
+    CHECK(cuts[0].sets.size() == 1 && cuts[0].sets[0].size() == 3 &&
+          cuts[0].rhs == 2 && cut_lhs(cuts[0], s) > 2.5);
+}
+
+static void test_branch_and_cut(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 10);
+    long long reported = -1;
+    BranchAndCut bc = branch_and_cut(
+        D, C, SIMPLEX_LP, 0,
+        [&reported](long long z, const Tour&) { reported = z; });
+    CHECK(bc.optimal && bc.z == optimum && bc.bound == optimum);
+    CHECK(is_permutation(bc.tour, p.n) && length(bc.tour, D) == optimum);
+    CHECK(reported == optimum);
+}
+
+static void test_partition(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    std::vector<std::vector<int> > cells = kd_partition(p, 40);
+    Tour all;
+    for (size_t k = 0; k < cells.size(); ++k) {
+        CHECK(cells[k].size() <= 40 && cells[k].size() >= 20);
+        all.insert(all.end(), cells[k].begin(), cells[k].end());
+    }
+    CHECK(is_permutation(all, p.n));
+
+    Neighbors C = mk_neighbors(D, 10, true);
+    for (int threads = 1; threads <= 2; ++threads) {
+        Tour tour = partition_tour(D, C, 40, LIN_KERNIGHAN, threads);
+        CHECK(is_permutation(tour, p.n));
+        CHECK(length(tour, D) < optimum * 11 / 10);
+    }
+    CHECK(length(partition_tour(D, C, 1), D) < optimum * 13 / 10);
+    CHECK(length(partition_tour(D, C, p.n), D) < optimum * 11 / 10);
+}
+
+static void test_crossover(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 8);
+    std::mt19937 rng(5);
+    Solution a, b;
+    a.tour = randtour(p.n, rng);
+    a.z = optimize(a.tour, length(a.tour, D), D, C, TWO_OPT);
+    b.tour = randtour(p.n, rng);
+    b.z = optimize(b.tour, length(b.tour, D), D, C, TWO_OPT);
+    std::vector<int> contested;
+    Solution child = gpx(a, b, D, &contested);
+    CHECK(is_permutation(child.tour, p.n));
+    CHECK(child.z == length(child.tour, D));
+    CHECK(child.z <= std::min(a.z, b.z));
+    CHECK(!contested.empty() && static_cast<int>(contested.size()) <= p.n);
+    CHECK(gpx(a, a, D, &contested).tour == a.tour && contested.empty());
+
+    Solution plain = multistart_localsearch(8, D, C, 3u, 1, Report(),
+                                            TWO_OPT);
+    Solution pop[2];
+    for (int r = 0; r < 2; ++r) {
+        pop[r] = population_search(8, 4, D, C, 3u, r + 1, Report(),
+                                   TWO_OPT);
+        CHECK(is_permutation(pop[r].tour, p.n));
+        CHECK(pop[r].z == length(pop[r].tour, D));
+        CHECK(pop[r].z <= plain.z && pop[r].z >= optimum);
+    }
+    CHECK(pop[1].tour == pop[0].tour);
+}
+
+static void test_solve(const char* name, long long optimum)
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/" + name);
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 12, true);
+
+    Budget kicks;
+    kicks.iterations = 300;
+    std::vector<long long> seen;
+    Outcome out = solve(D, C, kicks, [&seen](const Progress& pr) {
+        seen.push_back(pr.z);
+    });
+    CHECK(is_permutation(out.tour, p.n));
+    CHECK(out.z == length(out.tour, D) && out.z >= optimum);
+    CHECK(out.iterations == 300 && !out.stopped && out.bound < 0);
+    CHECK(seen.size() >= 2 && seen.back() == out.z);
+    for (size_t k = 1; k < seen.size(); ++k)
+        CHECK(seen[k] < seen[k - 1]);
+
+    Budget gap;
+    gap.seconds = 30;
+    gap.gap = 0.01;
+    out = solve(D, C, gap);
+    CHECK(out.bound > 0 && out.bound <= optimum);
+    CHECK(out.z <= gap_target(out.bound, 0.01) && out.seconds < 30);
+    gap.bound = optimum;
+    gap.gap = 0;
+    out = solve(D, C, gap);
+    CHECK(out.z == optimum && out.bound == optimum);
+
+    // the deadline alone ends the search, from the control's timer
+    Budget seconds;
+    seconds.seconds = 0.2;
+    out = solve(D, C, seconds);
+    CHECK(!out.stopped && out.iterations > 0 && out.z >= optimum);
+    CHECK(out.seconds >= 0.2 && out.seconds < 1);
+
+    // no budget but the control: runs until stopped
+    Control control;
+    std::thread stopper([&control] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        control.stop();
+    });
+    out = solve(D, C, Budget(), Listener(), &control);
+    stopper.join();
+    CHECK(out.stopped && out.iterations > 0 && out.z >= optimum);
+    CHECK(out.seconds >= 0.1 && out.seconds < 1);
+
+    bool thrown = false;
+    try {
+        solve(D, C, Budget());
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+// solve() beyond held_karp_dense_limit cities.  Stopped right after it
+// starts, it returns within milliseconds, even while it is still building
+// a greedy tour that would take much longer.  It reports no bound from
+// Held-Karp, which is only an estimate there.
+static void test_solve_large()
+{
+    Problem p;
+    p.n = 200000;
+    p.type = EUC_2D;
+    p.x.resize(p.n);
+    p.y.resize(p.n);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> side(0, 999999);
+    for (int i = 0; i < p.n; ++i) {
+        p.x[i] = side(rng);
+        p.y[i] = side(rng);
+    }
+    Oracle D(p);
+    Neighbors C = mk_neighbors(D, 10);
+
+    Control control;
+    std::thread stopper([&control] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        control.stop();
+    });
+    Outcome out = solve(D, C, Budget(), Listener(), &control);
+    stopper.join();
+    CHECK(out.stopped && out.iterations == 0);
+    CHECK(is_permutation(out.tour, p.n) && out.z == length(out.tour, D));
+    CHECK(out.seconds < 0.1);
+
+    Budget gap;
+    gap.seconds = 0.5;
+    gap.gap = 0.5;
+    out = solve(D, C, gap);
+    CHECK(!out.stopped && out.bound < 0 && out.seconds >= 0.5);
+}
+
+static void test_parallel_multistart()
+{
+    Problem p = read_tsplib(std::string(TPF_DATA_DIR) + "/berlin52.tsp");
+    Oracle D(p, 8);
+    Neighbors C = mk_neighbors(D, 8);
+    std::vector<long long> reports[3];
+    Solution best[3];
+    int threads[] = {1, 3, 4};
+    for (int r = 0; r < 3; ++r) {
+        std::vector<long long>& seen = reports[r];
+        best[r] = multistart_localsearch(
+            16, D, C, 7u, threads[r],
+            [&seen](long long z, const Tour&) { seen.push_back(z); },
+            OR2OPT);
+        CHECK(is_permutation(best[r].tour, p.n));
+        CHECK(best[r].z == length(best[r].tour, D));
+        CHECK(!seen.empty() && seen.back() == best[r].z);
+        for (size_t k = 1; k < seen.size(); ++k)
+            CHECK(seen[k] < seen[k - 1]);
+    }
+    // the same restarts whatever the number of threads
+    for (int r = 1; r < 3; ++r) {
+        CHECK(best[r].tour == best[0].tour);
+        CHECK(reports[r] == reports[0]);
+    }
+
+    ThreadPool pool(2);
+    std::atomic<int> sum(0);
+    for (int i = 1; i <= 100; ++i)
+        pool.submit([&sum, i](int) { sum += i; });
+    pool.submit([](int) { throw std::runtime_error("task failed"); });
+    bool thrown = false;
+    try {
+        pool.wait();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown && sum == 5050);
+}
+
+static Problem read_string(const std::string& text)
+{
+    char path[] = "/tmp/tsp_testXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    CHECK(write(fd, text.data(), text.size()) == ssize_t(text.size()));
+    close(fd);
+    Problem p = read_tsplib(path);
+    unlink(path);
+    return p;
+}
+
+static void test_explicit()
+{
+    // the same symmetric 4 x 4 matrix in every layout
+    const int w[4][4] = {{0, 3, 5, 7}, {3, 0, 2, 4}, {5, 2, 0, 6},
+                         {7, 4, 6, 0}};
+    const char* head = "NAME: t\nTYPE: TSP\nDIMENSION: 4\n"
+                       "EDGE_WEIGHT_TYPE: EXPLICIT\nEDGE_WEIGHT_FORMAT: ";
+    const char* layouts[][2] = {
+        {"FULL_MATRIX", "0 3 5 7\n3 0 2 4\n5 2 0 6\n7 4 6 0"},
+        {"UPPER_ROW", "3 5 7\n2 4\n6"},
+        {"LOWER_ROW", "3\n5 2\n7 4 6"},
+        {"UPPER_DIAG_ROW", "0 3 5 7\n0 2 4\n0 6\n0"},
+        {"LOWER_DIAG_ROW", "0\n3 0\n5 2 0\n7 4 6 0"},
+        {"UPPER_COL", "3\n5 2\n7 4 6"},
+        {"LOWER_DIAG_COL", "0 3 5 7 0 2 4 0 6 0"},
+    };
+    for (size_t k = 0; k < sizeof layouts / sizeof layouts[0]; ++k) {
+        Problem p = read_string(std::string(head) + layouts[k][0]
+                                + "\nEDGE_WEIGHT_SECTION\n" + layouts[k][1]
+                                + "\nEOF\n");
+        CHECK(p.n == 4 && p.type == EXPLICIT);
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                CHECK(p.distance(i, j) == w[i][j]);
+    }
+}
+
+static void test_directed()
+{
+    // asymmetric costs: only reversal-free moves keep lengths right
+    const int n = 60;
+    std::mt19937 rng(5);
+    Matrix M(n);
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            M.at(i, j) = i == j ? 0 : 1 + rng() % 1000;
+    Oracle D(M);
+    CHECK(!D.symmetric());
+    Neighbors C = mk_closest(D, 10);
+    Tour tour = greedy_tour(D, C);
+    CHECK(is_permutation(tour, n));
+    long long z0 = length(tour, D);
+    long long z = optimize(tour, z0, D, C);
+    CHECK(is_permutation(tour, n));
+    CHECK(z == length(tour, D) && z < z0);
+    bool threw = false;
+    try {
+        lin_kernighan(tour, z, D, C);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // sparse graph: a ring i -> i+1 and chords i -> i+2, i+3 and i-2, no
+    // reverse arcs; the rest are forbidden
+    std::vector<int> tail, head, cost;
+    const int step[] = {1, 2, 3, n - 2}, price[] = {100, 60, 70, 60};
+    for (int i = 0; i < n; ++i)
+        for (int s = 0; s < 4; ++s) {
+            tail.push_back(i);
+            head.push_back((i + step[s]) % n);
+            cost.push_back(price[s] + i % 7);
+        }
+    Graph G(n, static_cast<int>(tail.size()), &tail[0], &head[0], &cost[0]);
+    Oracle S(G);
+    CHECK(!S.symmetric() && S.graph() != 0);
+    CHECK(S(3, 4) == 103 && S(4, 3) == no_arc && S(3, 1) == 63);
+    Neighbors SC = mk_neighbors(S, 8);
+    CHECK(SC.end(0) - SC.begin(0) == 4 && SC.city[SC.begin(0)] == 2);
+    Tour ring;
+    for (int i = 0; i < n; ++i)
+        ring.push_back(i);
+    z0 = length(ring, S);
+    z = optimize(ring, z0, S, SC);  // e.g. i -> i+3 -> i+1 -> i+2 -> i+4
+    CHECK(is_permutation(ring, n));
+    CHECK(z == length(ring, S) && z < z0);
+    tour = greedy_tour(S, SC);
+    CHECK(is_permutation(tour, n));
+    CHECK(optimize(tour, length(tour, S), S, SC) == length(tour, S));
+
+    threw = false;
+    try {
+        int t[] = {0, 0}, h[] = {1, 1}, c[] = {1, 2};
+        Graph(2, 2, t, h, c);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+static void test_coord_types()
+{
+    Problem p = read_string("NAME : t\nDIMENSION : 2\n"
+                            "EDGE_WEIGHT_TYPE : ATT\n"
+                            "NODE_COORD_SECTION\n2 3.0e1 40\n1 0 0\nEOF\n");
+    CHECK(p.type == ATT && p.x[1] == 30.0 && p.y[1] == 40.0);
+    CHECK(p.distance(0, 1) == 16);  // sqrt(2500 / 10) = 15.8 -> 16
+    Point a = {0, 0}, b = {3, 4.5};
+    CHECK(dist_ceil2d(a, b) == 6);
+    CHECK(dist_max2d(a, b) == 4);
+}
+
+int main()
+{
+    test_toy();
+    test_exchange();
+    test_explicit();
+    test_coord_types();
+    test_directed();
+    test_oracle_cache();
+    test_kernels();
+    test_candidates();
+    test_tours();
+    test_moves("berlin52.tsp");
+    test_moves("a280.tsp");
+    test_lin_kernighan("berlin52.tsp", 7542);
+    test_lin_kernighan("a280.tsp", 2579);
+    test_iterated("berlin52.tsp", 7542);
+    test_iterated("a280.tsp", 2579);
+    test_construction("berlin52.tsp", 7542);
+    test_construction("a280.tsp", 2579);
+    test_solve("berlin52.tsp", 7542);
+    test_solve("a280.tsp", 2579);
+    test_solve_large();
+    test_crossover("berlin52.tsp", 7542);
+    test_crossover("a280.tsp", 2579);
+    test_partition("berlin52.tsp", 7542);
+    test_partition("a280.tsp", 2579);
+    test_parallel_multistart();
+    test_held_karp("burma14.tsp", 3323);
+    test_held_karp("berlin52.tsp", 7542);
+    test_held_karp("a280.tsp", 2579);
+    test_lp();
+    test_branch_and_cut("burma14.tsp", 3323);
+    test_branch_and_cut("berlin52.tsp", 7542);
+    test_branch_and_cut("a280.tsp", 2579);
+    test_tsplib("burma14.tsp", 3323);
+    test_tsplib("berlin52.tsp", 7542);
+    test_tsplib("a280.tsp", 2579);
+    if (failures)
+        std::printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,334 @@
+#include "tour.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace tpf {
+
+LinkedTour::LinkedTour(const std::vector<int>& tour)
+    : n_(static_cast<int>(tour.size())), next_(n_), prev_(n_)
+{
+    for (int k = 0; k < n_; ++k) {
+        int c = tour[k], d = tour[k + 1 == n_ ? 0 : k + 1];
+        next_[c] = d;
+        prev_[d] = c;
+    }
+}
+
+bool LinkedTour::between(int a, int b, int c) const
+{
+    for (int x = a;; x = next_[x]) {
+        if (x == b)
+            return true;
+        if (x == c)
+            return false;
+    }
+}
+
+void LinkedTour::flip(int a, int b, int c, int d)
+{
+    if (a == c || b == d)
+        return;
+    // Walk b..c and d..a side by side to find the shorter one.
+    int x = b, y = d;
+    while (x != c && y != a) {
+        x = next_[x];
+        y = next_[y];
+    }
+    if (x != c) {
+        std::swap(a, c);
+        std::swap(b, d);
+    }
+    // Reverse the path b..c lying between a and d.
+    for (int u = b;;) {
+        int v = next_[u];
+        std::swap(next_[u], prev_[u]);
+        if (u == c)
+            break;
+        u = v;
+    }
+    next_[a] = c;
+    prev_[c] = a;
+    next_[b] = d;
+    prev_[d] = b;
+}
+
+std::vector<int> LinkedTour::sequence() const
+{
+    std::vector<int> tour;
+    tour.reserve(n_);
+    if (n_ == 0)
+        return tour;
+    int c = 0;
+    do {
+        tour.push_back(c);
+        c = next_[c];
+    } while (c != 0);
+    return tour;
+}
+
+TwoLevelTour::TwoLevelTour(const std::vector<int>& tour, int group)
+    : n_(static_cast<int>(tour.size())),
+      group_(group > 0 ? group
+                       : std::max(8, static_cast<int>(std::sqrt(n_)))),
+      count_((n_ + group_ - 1) / group_),
+      parent_(n_),
+      seq_(n_),
+      link_(n_),
+      seg_(count_)
+{
+    for (int s = 0; s < count_; ++s) {
+        int lo = s * group_, hi = std::min(n_, lo + group_);
+        Segment& S = seg_[s];
+        S.reversed = false;
+        S.first = tour[lo];
+        S.last = tour[hi - 1];
+        S.size = hi - lo;
+        S.next = s + 1 == count_ ? 0 : s + 1;
+        S.prev = s == 0 ? count_ - 1 : s - 1;
+        S.rank = s;
+        for (int k = lo; k < hi; ++k) {
+            int c = tour[k];
+            parent_[c] = s;
+            seq_[c] = k - lo;
+            link_[c].prev = k == lo ? -1 : tour[k - 1];
+            link_[c].next = k + 1 == hi ? -1 : tour[k + 1];
+        }
+    }
+}
+
+void TwoLevelTour::flip(int a, int b, int c, int d)
+{
+    if (a == c || b == d || b == c || a == d)
+        return;
+    // A path inside one segment is reversed city by city.
+    if (parent_[b] == parent_[c] && order(b) <= order(c)) {
+        reverse_inside(b, c);
+        return;
+    }
+    if (parent_[d] == parent_[a] && order(d) <= order(a)) {
+        reverse_inside(d, a);
+        return;
+    }
+
+    // Otherwise make b..c and d..a runs of whole segments and reverse the
+    // shorter run.
+    split_.clear();
+    split_before(b);
+    split_before(d);
+    int sb = parent_[b], sc = parent_[c];
+    int len = seg_[sc].rank - seg_[sb].rank;
+    if (len < 0)
+        len += count_;
+    if (2 * (len + 1) <= count_)
+        reverse_segments(sb, sc);
+    else
+        reverse_segments(parent_[d], parent_[a]);
+
+    for (size_t k = 0; k < split_.size(); ++k) {
+        int s = split_[k];
+        if (seg_[s].size > 0 && 2 * seg_[s].size < group_ && count_ > 1)
+            merge(s);
+    }
+}
+
+std::vector<int> TwoLevelTour::sequence() const
+{
+    std::vector<int> tour;
+    tour.reserve(n_);
+    if (n_ == 0)
+        return tour;
+    int c = 0;
+    do {
+        tour.push_back(c);
+        c = next(c);
+    } while (c != 0);
+    return tour;
+}
+
+// Reverse the path x..y, which lies inside one segment.
+void TwoLevelTour::reverse_inside(int x, int y)
+{
+    Segment& S = seg_[parent_[x]];
+    if (S.reversed)
+        std::swap(x, y);
+    path_.clear();
+    for (int c = x;; c = link_[c].next) {
+        path_.push_back(c);
+        if (c == y)
+            break;
+    }
+    int before = link_[x].prev, after = link_[y].next;
+    int lo = seq_[x], k = static_cast<int>(path_.size());
+    for (int i = 0; i < k; ++i) {
+        int c = path_[k - 1 - i];
+        seq_[c] = lo + i;
+        link_[c].prev = i == 0 ? before : path_[k - i];
+        link_[c].next = i + 1 == k ? after : path_[k - 2 - i];
+    }
+    if (before < 0)
+        S.first = y;
+    else
+        link_[before].next = y;
+    if (after < 0)
+        S.last = x;
+    else
+        link_[after].prev = x;
+}
+
+// Cut the segment of x so that x becomes the head of a segment.  The
+// smaller piece goes to a new segment next to the old one.
+void TwoLevelTour::split_before(int x)
+{
+    int s = parent_[x];
+    if (head(s) == x)
+        return;
+    int t;
+    if (free_.empty()) {
+        t = static_cast<int>(seg_.size());
+        seg_.push_back(Segment());
+    } else {
+        t = free_.back();
+        free_.pop_back();
+    }
+    Segment& S = seg_[s];
+    Segment& T = seg_[t];
+
+    // Cities from x to the tail of the segment, in tour order.
+    int back = S.reversed ? seq_[x] - seq_[S.first] + 1
+                          : seq_[S.last] - seq_[x] + 1;
+    bool move_back = 2 * back <= S.size;
+
+    // Cut the links: the segment becomes [first .. lo] [hi .. last].
+    int lo = S.reversed ? x : link_[x].prev;
+    int hi = S.reversed ? link_[x].next : x;
+    link_[lo].next = -1;
+    link_[hi].prev = -1;
+    T.reversed = S.reversed;
+    if (move_back != S.reversed) {
+        T.first = hi;
+        T.last = S.last;
+        S.last = lo;
+    } else {
+        T.first = S.first;
+        T.last = lo;
+        S.first = hi;
+    }
+    T.size = move_back ? back : S.size - back;
+    S.size -= T.size;
+    for (int c = T.first; c >= 0; c = link_[c].next)
+        parent_[c] = t;
+
+    if (move_back) {
+        T.prev = s;
+        T.next = S.next;
+        seg_[S.next].prev = t;
+        S.next = t;
+    } else {
+        T.next = s;
+        T.prev = S.prev;
+        seg_[S.prev].next = t;
+        S.prev = t;
+    }
+    ++count_;
+    rank_segments();
+    split_.push_back(s);
+    split_.push_back(t);
+}
+
+// Reverse the run of segments from 'first' to 'last' in tour order.
+void TwoLevelTour::reverse_segments(int first, int last)
+{
+    int before = seg_[first].prev, after = seg_[last].next;
+    for (int s = first;;) {
+        Segment& S = seg_[s];
+        int next = S.next;
+        std::swap(S.next, S.prev);
+        S.reversed = !S.reversed;
+        if (s == last)
+            break;
+        s = next;
+    }
+    if (after != first) {
+        seg_[before].next = last;
+        seg_[last].prev = before;
+        seg_[first].next = after;
+        seg_[after].prev = first;
+    }
+    rank_segments();
+}
+
+// Move the cities of segment s into its smaller neighbour and drop s.
+void TwoLevelTour::merge(int s)
+{
+    Segment& S = seg_[s];
+    bool to_next = seg_[S.next].size <= seg_[S.prev].size;
+    int t = to_next ? S.next : S.prev;
+    Segment& T = seg_[t];
+
+    path_.clear();
+    for (int c = head(s);; c = next(c)) {
+        path_.push_back(c);
+        if (c == tail(s))
+            break;
+    }
+    if (to_next)
+        std::reverse(path_.begin(), path_.end());
+    // Prepend to T in tour order when moving forward, append otherwise;
+    // which end of the city list that is depends on T's bit.
+    bool at_last = to_next == T.reversed;
+    for (size_t k = 0; k < path_.size(); ++k) {
+        int c = path_[k];
+        parent_[c] = t;
+        if (at_last) {
+            seq_[c] = seq_[T.last] + 1;
+            link_[c].prev = T.last;
+            link_[c].next = -1;
+            link_[T.last].next = c;
+            T.last = c;
+        } else {
+            seq_[c] = seq_[T.first] - 1;
+            link_[c].next = T.first;
+            link_[c].prev = -1;
+            link_[T.first].prev = c;
+            T.first = c;
+        }
+    }
+    T.size += S.size;
+
+    seg_[S.prev].next = S.next;
+    seg_[S.next].prev = S.prev;
+    S.size = 0;
+    free_.push_back(s);
+    --count_;
+    if (std::abs(seq_[T.first]) > (1 << 30) ||
+        std::abs(seq_[T.last]) > (1 << 30))
+        renumber(t);
+    rank_segments();
+
+    if (T.size > 2 * group_) {
+        int c = head(t);
+        for (int k = T.size / 2; k > 0; --k)
+            c = next(c);
+        split_before(c);
+    }
+}
+
+void TwoLevelTour::renumber(int s)
+{
+    int k = 0;
+    for (int c = seg_[s].first; c >= 0; c = link_[c].next)
+        seq_[c] = k++;
+}
+
+void TwoLevelTour::rank_segments()
+{
+    int first = parent_[0], s = first, k = 0;
+    do {
+        seg_[s].rank = k++;
+        s = seg_[s].next;
+    } while (s != first);
+}
+
+}  // namespace tpf
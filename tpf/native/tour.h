@@ -0,0 +1,272 @@
+#ifndef TPF_TOUR_H
+#define TPF_TOUR_H
+
+#include <vector>
+
+namespace tpf {
+
+// Tour stored as an array of cities plus the position of every city.
+//
+// Moves are expressed through flip(a, b, c, d): with b = next(a) and
+// d = next(c), replace edges (a,b) and (c,d) by (a,c) and (b,d).  The
+// path b..c is reversed, or its complement d..a when that is shorter, so
+// the orientation of the tour may change; next() and prev() always
+// describe the current orientation.
+class ArrayTour {
+public:
+    explicit ArrayTour(const std::vector<int>& tour)
+        : n_(static_cast<int>(tour.size())), tour_(tour), pos_(n_)
+    {
+        for (int k = 0; k < n_; ++k)
+            pos_[tour_[k]] = k;
+    }
+
+    int size() const { return n_; }
+
+    int next(int c) const
+    {
+        int k = pos_[c] + 1;
+        return tour_[k == n_ ? 0 : k];
+    }
+
+    int prev(int c) const
+    {
+        int k = pos_[c];
+        return tour_[k == 0 ? n_ - 1 : k - 1];
+    }
+
+    // Whether b lies on the path from a to c following next().
+    bool between(int a, int b, int c) const
+    {
+        int pa = pos_[a], pb = pos_[b], pc = pos_[c];
+        if (pa <= pc)
+            return pa <= pb && pb <= pc;
+        return pb >= pa || pb <= pc;
+    }
+
+    void flip(int a, int b, int c, int d)
+    {
+        int i = pos_[b], j = pos_[c];
+        int len = j - i + (j < i ? n_ : 0) + 1;
+        if (2 * len > n_) {
+            i = pos_[d];
+            j = pos_[a];
+            len = n_ - len;
+        }
+        for (int k = 0; k < len / 2; ++k) {
+            int ci = tour_[i], cj = tour_[j];
+            tour_[i] = cj;
+            pos_[cj] = i;
+            tour_[j] = ci;
+            pos_[ci] = j;
+            if (++i == n_)
+                i = 0;
+            if (--j < 0)
+                j = n_ - 1;
+        }
+    }
+
+    // The cities in tour order, starting from position 0.
+    std::vector<int> sequence() const { return tour_; }
+
+private:
+    int n_;
+    std::vector<int> tour_;
+    std::vector<int> pos_;
+};
+
+// Tour stored as a doubly-linked list.  flip() walks both sides of the
+// move at once and relinks the shorter one, so it costs as much as in an
+// ArrayTour, but between() has to walk the tour.
+class LinkedTour {
+public:
+    explicit LinkedTour(const std::vector<int>& tour);
+
+    int size() const { return n_; }
+    int next(int c) const { return next_[c]; }
+    int prev(int c) const { return prev_[c]; }
+    bool between(int a, int b, int c) const;
+    void flip(int a, int b, int c, int d);
+
+    // The cities in tour order, starting from city 0.
+    std::vector<int> sequence() const;
+
+private:
+    int n_;
+    std::vector<int> next_;
+    std::vector<int> prev_;
+};
+
+// Two-level doubly-linked list (Fredman et al., 1995).  The tour is cut
+// into about sqrt(n) segments, each a doubly-linked list of cities with a
+// reversal bit, and the segments themselves form a doubly-linked list.  A
+// flip splits at most two segments so that the path to reverse is made of
+// whole segments, then reverses the order of those segments and toggles
+// their bits; short segments are merged back into a neighbour afterwards.
+// Flips and between() take O(sqrt n) time instead of O(n).
+class TwoLevelTour {
+public:
+    // 'group' is the target segment size, sqrt(n) by default.
+    explicit TwoLevelTour(const std::vector<int>& tour, int group = 0);
+
+    int size() const { return n_; }
+
+    int next(int c) const
+    {
+        const Segment& s = seg_[parent_[c]];
+        if (!s.reversed)
+            return c == s.last ? head(s.next) : link_[c].next;
+        return c == s.first ? head(s.next) : link_[c].prev;
+    }
+
+    int prev(int c) const
+    {
+        const Segment& s = seg_[parent_[c]];
+        if (!s.reversed)
+            return c == s.first ? tail(s.prev) : link_[c].prev;
+        return c == s.last ? tail(s.prev) : link_[c].next;
+    }
+
+    bool between(int a, int b, int c) const
+    {
+        long long ka = key(a), kb = key(b), kc = key(c);
+        if (ka <= kc)
+            return ka <= kb && kb <= kc;
+        return kb >= ka || kb <= kc;
+    }
+
+    void flip(int a, int b, int c, int d);
+
+    // The cities in tour order, starting from the first segment.
+    std::vector<int> sequence() const;
+
+    // Number of segments, for tests.
+    int segments() const { return count_; }
+
+private:
+    // Cities of a segment are linked from 'first' to 'last' by Link::next;
+    // when 'reversed' the segment is traversed from 'last' to 'first'.
+    // Sequence numbers increase by one from 'first' to 'last'.
+    struct Segment {
+        bool reversed;
+        int first, last, size;
+        int next, prev;  // neighbouring segments in tour order
+        int rank;        // position of the segment in tour order
+    };
+    struct Link {
+        int next, prev;  // -1 at the ends of a segment
+    };
+
+    int head(int s) const
+    {
+        return seg_[s].reversed ? seg_[s].last : seg_[s].first;
+    }
+    int tail(int s) const
+    {
+        return seg_[s].reversed ? seg_[s].first : seg_[s].last;
+    }
+    // Sequence number of c in tour order within its segment.
+    int order(int c) const
+    {
+        return seg_[parent_[c]].reversed ? -seq_[c] : seq_[c];
+    }
+    long long key(int c) const
+    {
+        return (static_cast<long long>(seg_[parent_[c]].rank) << 32) +
+               order(c);
+    }
+
+    void reverse_inside(int x, int y);
+    void split_before(int x);
+    void reverse_segments(int first, int last);
+    void merge(int s);
+    void renumber(int s);
+    void rank_segments();
+
+    int n_;
+    int group_;
+    int count_;
+    std::vector<int> parent_;
+    std::vector<int> seq_;
+    std::vector<Link> link_;
+    std::vector<Segment> seg_;
+    std::vector<int> free_;   // unused segment slots
+    std::vector<int> split_;  // segments cut by the current flip
+    std::vector<int> path_;   // scratch for reverse_inside()
+};
+
+// Tour representation used by optimize() and lin_kernighan().
+enum TourKind {
+    AUTO_TOUR,
+    ARRAY_TOUR,
+    LINKED_TOUR,
+    TWO_LEVEL_TOUR
+};
+
+// Arrays are fastest on small instances; above a few thousand cities the
+// O(sqrt n) flips of the two-level list win.
+const int two_level_threshold = 5000;
+
+inline TourKind tour_kind(TourKind kind, int n)
+{
+    if (kind != AUTO_TOUR)
+        return kind;
+    return n < two_level_threshold ? ARRAY_TOUR : TWO_LEVEL_TOUR;
+}
+
+// Replace edges (a,b), (c,d) by (a,c), (b,d), where b and d follow a and c
+// in the same direction, whatever the current orientation of the tour.
+template <class T>
+void two_opt_move(T& t, int a, int b, int c, int d)
+{
+    if (t.next(a) == b)
+        t.flip(a, b, c, d);
+    else
+        t.flip(b, a, d, c);
+}
+
+// Wrapper recording the flips made on a tour so that they can be undone,
+// e.g. to revert a rejected step of iterated local search.
+template <class T>
+class Journal {
+public:
+    explicit Journal(T& t) : t_(t) {}
+
+    int size() const { return t_.size(); }
+    int next(int c) const { return t_.next(c); }
+    int prev(int c) const { return t_.prev(c); }
+    bool between(int a, int b, int c) const { return t_.between(a, b, c); }
+
+    void flip(int a, int b, int c, int d)
+    {
+        t_.flip(a, b, c, d);
+        Flip f = {a, b, c, d};
+        log_.push_back(f);
+    }
+
+    // Forget the flips made so far.
+    void commit() { log_.clear(); }
+
+    // Undo the flips made since the last commit().
+    void revert()
+    {
+        while (!log_.empty()) {
+            const Flip& f = log_.back();
+            // the flip left edges (a,c) and (b,d); put (a,b) and (c,d) back
+            two_opt_move(t_, f.a, f.c, f.b, f.d);
+            log_.pop_back();
+        }
+    }
+
+private:
+    struct Flip {
+        int a, b, c, d;
+    };
+
+    T& t_;
+    std::vector<Flip> log_;
+};
+
+}  // namespace tpf
+
+#endif
@@ -0,0 +1,364 @@
+#include "tsplib.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace tpf {
+
+namespace {
+
+// Read-only mapping of a whole file, unmapped on destruction.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) : data_(0), size_(0)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + filename);
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            size_ = static_cast<size_t>(st.st_size);
+            void* p = ::mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (!data_)
+            throw std::runtime_error("cannot map " + filename);
+    }
+
+    ~MappedFile() { ::munmap(const_cast<char*>(data_), size_); }
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data_;
+    size_t size_;
+};
+
+// Tokenizer over the mapped bytes; nothing is copied except the short
+// keyword and value strings of the specification part.
+class Cursor {
+public:
+    Cursor(const char* p, const char* end, const std::string& filename)
+        : p_(p), end_(end), begin_(p), filename_(filename)
+    {
+    }
+
+    bool at_end()
+    {
+        skip_space();
+        return p_ == end_;
+    }
+
+    // Next character after blanks, without consuming it.
+    char peek()
+    {
+        skip_space();
+        return p_ == end_ ? '\0' : *p_;
+    }
+
+    // A keyword: letters, digits and underscores.
+    std::string keyword()
+    {
+        skip_space();
+        const char* b = p_;
+        while (p_ != end_ && (is_alnum(*p_) || *p_ == '_'))
+            ++p_;
+        return std::string(b, p_);
+    }
+
+    // The value of a "KEY : value" line, up to the end of the line.
+    std::string value()
+    {
+        while (p_ != end_ && (*p_ == ' ' || *p_ == '\t'))
+            ++p_;
+        if (p_ != end_ && *p_ == ':')
+            ++p_;
+        while (p_ != end_ && (*p_ == ' ' || *p_ == '\t'))
+            ++p_;
+        const char* b = p_;
+        while (p_ != end_ && *p_ != '\n' && *p_ != '\r')
+            ++p_;
+        const char* e = p_;
+        while (e != b && (e[-1] == ' ' || e[-1] == '\t'))
+            --e;
+        return std::string(b, e);
+    }
+
+    long long integer()
+    {
+        skip_space();
+        bool neg = sign();
+        if (p_ == end_ || !is_digit(*p_))
+            fail("integer expected");
+        long long v = 0;
+        while (p_ != end_ && is_digit(*p_))
+            v = v * 10 + (*p_++ - '0');
+        return neg ? -v : v;
+    }
+
+    // Decimal number.  Short mantissas with small exponents are converted
+    // exactly (one correctly rounded division); the rest goes to strtod.
+    double real()
+    {
+        skip_space();
+        const char* b = p_;
+        bool neg = sign();
+        uint64_t mant = 0;
+        int digits = 0, exp10 = 0;
+        bool any = false;
+        while (p_ != end_ && is_digit(*p_)) {
+            if (digits < 19) {
+                mant = mant * 10 + (*p_ - '0');
+                if (mant)
+                    ++digits;
+            } else {
+                ++exp10;
+            }
+            ++p_;
+            any = true;
+        }
+        if (p_ != end_ && *p_ == '.') {
+            ++p_;
+            while (p_ != end_ && is_digit(*p_)) {
+                if (digits < 19) {
+                    mant = mant * 10 + (*p_ - '0');
+                    if (mant)
+                        ++digits;
+                    --exp10;
+                }
+                ++p_;
+                any = true;
+            }
+        }
+        if (!any)
+            fail("number expected");
+        if (p_ != end_ && (*p_ == 'e' || *p_ == 'E')) {
+            ++p_;
+            bool eneg = sign();
+            int e = 0;
+            while (p_ != end_ && is_digit(*p_))
+                e = e * 10 + (*p_++ - '0');
+            exp10 += eneg ? -e : e;
+        }
+
+        static const double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                       1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                       1e18, 1e19, 1e20, 1e21, 1e22};
+        double v;
+        if (mant < (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+            v = static_cast<double>(mant);
+            v = exp10 < 0 ? v / pow10[-exp10] : v * pow10[exp10];
+        } else {
+            std::string s(b, p_);
+            return std::strtod(s.c_str(), 0);
+        }
+        return neg ? -v : v;
+    }
+
+    void fail(const std::string& what) const
+    {
+        int line = 1;
+        for (const char* q = begin_; q < p_; ++q)
+            line += *q == '\n';
+        throw std::runtime_error(filename_ + ":" + to_string(line) + ": "
+                                 + what);
+    }
+
+private:
+    static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    static bool is_alnum(char c)
+    {
+        return is_digit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    }
+    static std::string to_string(int v)
+    {
+        char buf[16];
+        std::snprintf(buf, sizeof buf, "%d", v);
+        return buf;
+    }
+
+    void skip_space()
+    {
+        while (p_ != end_ && static_cast<unsigned char>(*p_) <= ' ')
+            ++p_;
+    }
+
+    bool sign()
+    {
+        if (p_ != end_ && (*p_ == '-' || *p_ == '+'))
+            return *p_++ == '-';
+        return false;
+    }
+
+    const char* p_;
+    const char* end_;
+    const char* begin_;
+    std::string filename_;
+};
+
+void read_coords(Cursor& in, Problem& p)
+{
+    p.x.assign(p.n, 0.0);
+    p.y.assign(p.n, 0.0);
+    for (int k = 0; k < p.n; ++k) {
+        long long id = in.integer();
+        if (id < 1 || id > p.n)
+            in.fail("node id out of range");
+        p.x[id - 1] = in.real();
+        p.y[id - 1] = in.real();
+    }
+}
+
+// Visit the (row, column) cells of an EDGE_WEIGHT_SECTION in file order.
+// The _COL formats are the transposes of the _ROW ones, and the matrix is
+// symmetric, so those read as the opposite triangle by rows.
+void read_weights(Cursor& in, Problem& p, const std::string& format)
+{
+    int n = p.n;
+    if (format == "FULL_MATRIX") {
+        p.full_matrix = true;
+        p.weights.resize(static_cast<size_t>(n) * n);
+        for (size_t k = 0; k < p.weights.size(); ++k)
+            p.weights[k] = static_cast<int>(in.integer());
+        return;
+    }
+
+    bool lower, diag;
+    if (format == "LOWER_ROW" || format == "UPPER_COL")
+        lower = true, diag = false;
+    else if (format == "LOWER_DIAG_ROW" || format == "UPPER_DIAG_COL")
+        lower = true, diag = true;
+    else if (format == "UPPER_ROW" || format == "LOWER_COL")
+        lower = false, diag = false;
+    else if (format == "UPPER_DIAG_ROW" || format == "LOWER_DIAG_COL")
+        lower = false, diag = true;
+    else
+        throw std::runtime_error("cannot deal with EDGE_WEIGHT_FORMAT "
+                                 + format);
+
+    p.full_matrix = false;
+    p.weights.assign(static_cast<size_t>(n) * (n + 1) / 2, 0);
+    for (int i = 0; i < n; ++i) {
+        int jb = lower ? 0 : (diag ? i : i + 1);
+        int je = lower ? (diag ? i + 1 : i) : n;
+        for (int j = jb; j < je; ++j) {
+            int r = i > j ? i : j, c = i > j ? j : i;
+            p.weights[static_cast<size_t>(r) * (r + 1) / 2 + c] =
+                static_cast<int>(in.integer());
+        }
+    }
+}
+
+// Skip the numbers of a section we do not use.
+void skip_section(Cursor& in)
+{
+    for (;;) {
+        char c = in.peek();
+        if (c == '\0' || !((c >= '0' && c <= '9') || c == '-' || c == '+'
+                           || c == '.'))
+            return;
+        in.real();
+    }
+}
+
+}  // namespace
+
+Problem read_tsplib(const std::string& filename, Rounding rounding)
+{
+    MappedFile file(filename);
+    Cursor in(file.begin(), file.end(), filename);
+
+    Problem p;
+    p.rounding = rounding;
+    std::string type, format;
+    bool have_type = false;
+    while (!in.at_end()) {
+        std::string key = in.keyword();
+        if (key.empty())
+            in.fail("keyword expected");
+
+        if (key == "EOF") {
+            break;
+        } else if (key == "NODE_COORD_SECTION") {
+            if (p.n <= 0)
+                in.fail("NODE_COORD_SECTION before DIMENSION");
+            read_coords(in, p);
+        } else if (key == "EDGE_WEIGHT_SECTION") {
+            if (p.n <= 0)
+                in.fail("EDGE_WEIGHT_SECTION before DIMENSION");
+            read_weights(in, p, format);
+        } else if (key.size() > 8
+                   && key.compare(key.size() - 8, 8, "_SECTION") == 0) {
+            skip_section(in);
+        } else {
+            std::string value = in.value();
+            if (key == "NAME") {
+                p.name = value;
+            } else if (key == "DIMENSION") {
+                p.n = std::atoi(value.c_str());
+            } else if (key == "EDGE_WEIGHT_FORMAT") {
+                format = value;
+            } else if (key == "EDGE_WEIGHT_TYPE") {
+                type = value;
+                have_type = true;
+                if (type == "EUC_2D")
+                    p.type = EUC_2D;
+                else if (type == "CEIL_2D")
+                    p.type = CEIL_2D;
+                else if (type == "MAN_2D")
+                    p.type = MAN_2D;
+                else if (type == "MAX_2D")
+                    p.type = MAX_2D;
+                else if (type == "ATT")
+                    p.type = ATT;
+                else if (type == "GEO")
+                    p.type = GEO;
+                else if (type == "EXPLICIT")
+                    p.type = EXPLICIT;
+                else
+                    throw std::runtime_error(
+                        "cannot deal with EDGE_WEIGHT_TYPE " + type);
+            }
+        }
+    }
+
+    if (!have_type)
+        throw std::runtime_error(filename + ": missing EDGE_WEIGHT_TYPE");
+    if (p.type == EXPLICIT ? p.weights.empty() : p.x.empty())
+        throw std::runtime_error(filename + ": no edge data");
+    return p;
+}
+
+Matrix mk_matrix(const Problem& p)
+{
+    Matrix D(p.n);
+    for (int i = 0; i < p.n; ++i) {
+        int* row = &D.at(i, 0);
+        if (p.type == EXPLICIT) {
+            for (int j = 0; j < p.n; ++j)
+                row[j] = p.distance(i, j);
+        } else {
+            distances(p.type, p.rounding, &p.x[0], &p.y[0], i, p.n, row);
+        }
+    }
+    return D;
+}
+
+}  // namespace tpf
@@ -0,0 +1,56 @@
+#ifndef TPF_TSPLIB_H
+#define TPF_TSPLIB_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "distance.h"
+#include "matrix.h"
+
+namespace tpf {
+
+// A TSPLIB instance.  Node coordinates are kept as a structure of arrays;
+// EXPLICIT weights are kept as parsed, either as a full n x n matrix or,
+// for the triangular formats, packed by rows of the lower triangle
+// (diagonal included).
+struct Problem {
+    std::string name;
+    int n;
+    EdgeWeightType type;
+    Rounding rounding;
+
+    std::vector<double> x, y;
+    std::vector<int> weights;
+    bool full_matrix;
+
+    Problem() : n(0), type(EUC_2D), rounding(NINT), full_matrix(false) {}
+
+    int distance(int i, int j) const
+    {
+        if (type != EXPLICIT)
+            return tpf::distance(type, rounding, x[i], y[i], x[j], y[j]);
+        if (full_matrix)
+            return weights[static_cast<size_t>(i) * n + j];
+        if (i < j)
+            std::swap(i, j);
+        return weights[static_cast<size_t>(i) * (i + 1) / 2 + j];
+    }
+};
+
+// Read a TSP problem in the TSPLIB format.
+//
+// The file is memory-mapped and parsed in place.  Node coordinates are
+// understood for EUC_2D, CEIL_2D, MAN_2D, MAX_2D, ATT and GEO, and
+// EDGE_WEIGHT_SECTION for every EXPLICIT EDGE_WEIGHT_FORMAT (FULL_MATRIX,
+// UPPER/LOWER_ROW, UPPER/LOWER_DIAG_ROW and the _COL variants).
+// Throws std::runtime_error on anything else.  'rounding' applies to
+// EUC_2D, MAN_2D and MAX_2D; use TRUNCATE to match utils.py.
+Problem read_tsplib(const std::string& filename, Rounding rounding = NINT);
+
+// Compute the distance matrix of a problem.
+Matrix mk_matrix(const Problem& p);
+
+}  // namespace tpf
+
+#endif
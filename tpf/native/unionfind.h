@@ -0,0 +1,38 @@
+#ifndef TPF_UNIONFIND_H
+#define TPF_UNIONFIND_H
+
+#include <vector>
+
+namespace tpf {
+
+// Disjoint sets over 0..n-1, with path halving.
+struct UnionFind {
+    std::vector<int> parent;
+
+    explicit UnionFind(int n) : parent(n)
+    {
+        for (int i = 0; i < n; ++i)
+            parent[i] = i;
+    }
+
+    int find(int i)
+    {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    }
+
+    bool unite(int a, int b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return false;
+        parent[a] = b;
+        return true;
+    }
+};
+
+}  // namespace tpf
+
+#endif
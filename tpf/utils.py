@@ -97,7 +97,7 @@ def length(tour, D):
     """Calculate the length of a tour according to distance matrix 'D'."""
     z = D[tour[-1], tour[0]]    # edge from last to first city of the tour
     for i in range(1,len(tour)):
-        z += D[tour[i], tour[i-1]]      # add length of edge from city i-1 to i
+        z += D[tour[i-1], tour[i]]      # add length of edge from city i-1 to i
     return z
 
 
@@ -241,6 +241,8 @@ def localsearch(tour, z, D, C=None):
             z = newz
         else:
             break
+    # z is kept from the exchange deltas; check it unless run with -O
+    assert z == length(tour, D)
     return z
 
 